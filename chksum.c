@@ -0,0 +1,248 @@
+/*
+    Internet checksum for lwIP, tuned for the Cortex-M0
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+lwIP's generic checksum (algorithm 2 in inet_chksum.c) adds one halfword per loop pass, which on the Cortex-M0
+costs a load, an add and the loop overhead for every two bytes of each packet sent or received.
+
+The ones' complement sum doesn't care how the data is grouped, so fast_chksum() adds whole 32-bit words into a
+64-bit accumulator instead (on the M0, an adds/adcs pair) and folds the carries back in once at the end.
+The M0 faults on unaligned loads, so a leading odd byte and halfword are taken on their own until the pointer
+is word aligned; as in algorithm 2, an odd start is undone by swapping the bytes of the result.
+The main loop takes four words per pass, which with the accumulator, pointer and count fits the M0's eight low registers.
+
+The host build (see link.h) has SSE2, which adds eight halfwords per instruction into 32-bit lanes.
+
+fast_chksum_copy() is the same loop with a store of each word it adds, so that data copied into a pbuf
+would be read once rather than once to copy and again to sum.
+Words can only be moved whole when source and destination share their alignment; otherwise it falls back to
+copying and then summing.
+
+lwipopts.h selects fast_chksum() through LWIP_CHKSUM, but leaves LWIP_CHKSUM_COPY to lwIP (a copy, then
+fast_chksum() of the copy): on the host (host/bench_chksum.c), fast_chksum_copy() only breaks even below 300 bytes
+and loses above, and there is no cycle count from the Cortex-M0 to say otherwise. It is kept, tested, for that.
+*/
+
+#include "chksum.h"
+#include "lwip/inet_chksum.h"
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE2__)
+/* adds len (a multiple of 16) bytes at p; each pass adds at most 2 * 0xFFFF to a lane, so the lanes are emptied every 0x4000 passes */
+static uint64_t chksum_sse2(const u8_t *p, int len)
+{
+  const __m128i zero = _mm_setzero_si128();
+  uint32_t lanes[4];
+  uint64_t sum = 0;
+  __m128i acc, v;
+  int passes;
+
+  while (len)
+  {
+    passes = len / 16;
+    if (passes > 0x4000)
+      passes = 0x4000;
+    len -= passes * 16;
+
+    acc = zero;
+    while (passes--)
+    {
+      v = _mm_loadu_si128((const __m128i *)p);
+      acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+      acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+      p += 16;
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  }
+
+  return sum;
+}
+#endif
+
+/* fold 64 bits down to 16, adding the carries back in, and undo the byte swap of an odd start */
+static u16_t chksum_fold(uint64_t sum, int odd)
+{
+  uint32_t acc;
+
+  sum = (sum & 0xFFFFFFFFUL) + (sum >> 32);
+  sum = (sum & 0xFFFFFFFFUL) + (sum >> 32);
+  acc = (uint32_t)sum;
+  acc = FOLD_U32T(acc);
+  acc = FOLD_U32T(acc);
+
+  if (odd)
+    acc = SWAP_BYTES_IN_WORD(acc);
+
+  return (u16_t)acc;
+}
+
+u16_t fast_chksum(void *dataptr, int len)
+{
+  const u8_t *pb = (const u8_t *)dataptr;
+  const uint32_t *pl;
+  uint64_t sum = 0;
+  u16_t t = 0;
+  int odd = ((mem_ptr_t)pb & 1);
+
+  /* a leading odd byte is the high byte of the first halfword (on this little-endian target); the swap at the end puts it right */
+  if (odd && (len > 0))
+  {
+    ((u8_t *)&t)[1] = *pb++;
+    len--;
+  }
+
+  /* then a halfword to reach word alignment */
+  if (((mem_ptr_t)pb & 2) && (len > 1))
+  {
+    sum += *(const u16_t *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+#if defined(__SSE2__)
+  sum += chksum_sse2(pb, len & ~15);
+  pb += len & ~15;
+  len &= 15;
+#endif
+
+  pl = (const uint32_t *)pb;
+
+  while (len >= 16)
+  {
+    sum += pl[0];
+    sum += pl[1];
+    sum += pl[2];
+    sum += pl[3];
+    pl += 4;
+    len -= 16;
+  }
+
+  while (len >= 4)
+  {
+    sum += *pl++;
+    len -= 4;
+  }
+
+  pb = (const u8_t *)pl;
+
+  if (len > 1)
+  {
+    sum += *(const u16_t *)pb;
+    pb += 2;
+    len -= 2;
+  }
+
+  /* a trailing byte is the low byte of the last halfword */
+  if (len > 0)
+    ((u8_t *)&t)[0] = *pb;
+
+  sum += t;
+
+  return chksum_fold(sum, odd);
+}
+
+u16_t fast_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  u8_t *db = (u8_t *)dst;
+  const u8_t *sb = (const u8_t *)src;
+  uint32_t *dl;
+  const uint32_t *sl;
+  uint32_t w;
+  uint64_t sum = 0;
+  u16_t t = 0, h;
+  int n = len;
+  int odd = ((mem_ptr_t)db & 1);
+
+  /* words can't be moved whole between differently aligned buffers */
+  if (((mem_ptr_t)db ^ (mem_ptr_t)sb) & 3)
+  {
+    MEMCPY(dst, src, len);
+    return fast_chksum(dst, len);
+  }
+
+  if (odd && (n > 0))
+  {
+    ((u8_t *)&t)[1] = *db++ = *sb++;
+    n--;
+  }
+
+  if (((mem_ptr_t)db & 2) && (n > 1))
+  {
+    h = *(const u16_t *)sb;
+    *(u16_t *)db = h;
+    sum += h;
+    db += 2;
+    sb += 2;
+    n -= 2;
+  }
+
+  dl = (uint32_t *)db;
+  sl = (const uint32_t *)sb;
+
+  while (n >= 16)
+  {
+    w = sl[0]; dl[0] = w; sum += w;
+    w = sl[1]; dl[1] = w; sum += w;
+    w = sl[2]; dl[2] = w; sum += w;
+    w = sl[3]; dl[3] = w; sum += w;
+    dl += 4;
+    sl += 4;
+    n -= 16;
+  }
+
+  while (n >= 4)
+  {
+    w = *sl++;
+    *dl++ = w;
+    sum += w;
+    n -= 4;
+  }
+
+  db = (u8_t *)dl;
+  sb = (const u8_t *)sl;
+
+  if (n > 1)
+  {
+    h = *(const u16_t *)sb;
+    *(u16_t *)db = h;
+    sum += h;
+    db += 2;
+    sb += 2;
+    n -= 2;
+  }
+
+  if (n > 0)
+    ((u8_t *)&t)[0] = *db = *sb;
+
+  sum += t;
+
+  return chksum_fold(sum, odd);
+}
@@ -0,0 +1,37 @@
+/*
+    Internet checksum for lwIP, tuned for the Cortex-M0
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef __CHKSUM_H
+#define __CHKSUM_H
+
+#include <stdint.h>
+#include "lwip/arch.h"
+
+/* lwIP's LWIP_CHKSUM: the (non-inverted) ones' complement sum of len bytes at dataptr, in host order */
+u16_t fast_chksum(void *dataptr, int len);
+
+/* copies len bytes from src to dst (like MEMCPY) and returns fast_chksum() of them, in one pass; not selected as lwIP's LWIP_CHKSUM_COPY (see chksum.c) */
+u16_t fast_chksum_copy(void *dst, const void *src, u16_t len);
+
+#endif
@@ -227,11 +227,32 @@ int fill_options(void *dest,
 	return ptr - (uint8_t *)dest;
 }
 
+/* broadcasts dhcp_data; returns false if no pbuf could be had for it */
+static bool send_dhcp_data(struct udp_pcb *upcb, u16_t port)
+{
+	struct pbuf *pp;
+
+	pp = pbuf_alloc(PBUF_TRANSPORT, sizeof(dhcp_data), PBUF_POOL);
+	if (pp == NULL) return false;
+#if LWIP_CHECKSUM_ON_COPY
+	{
+		/* checksummed as it is copied, so that udp_sendto_chksum() doesn't read it all again */
+		u16_t chksum = 0;
+		pbuf_take_chksum(pp, &dhcp_data, sizeof(dhcp_data), 0, &chksum);
+		udp_sendto_chksum(upcb, pp, IP_ADDR_BROADCAST, port, 1, chksum);
+	}
+#else
+	pbuf_take(pp, &dhcp_data, sizeof(dhcp_data));
+	udp_sendto(upcb, pp, IP_ADDR_BROADCAST, port);
+#endif
+	pbuf_free(pp);
+	return true;
+}
+
 static void udp_recv_proc(void *arg, struct udp_pcb *upcb, struct pbuf *p, struct ip_addr *addr, u16_t port)
 {
 	uint8_t *ptr;
 	dhcp_entry_t *entry;
-	struct pbuf *pp;
 
 	int n = p->len;
 	if (n > sizeof(dhcp_data)) n = sizeof(dhcp_data);
@@ -260,11 +281,7 @@ static void udp_recv_proc(void *arg, struct udp_pcb *upcb, struct pbuf *p, struc
 				get_ip(config->addr), 
 				get_ip(entry->subnet));
 
-			pp = pbuf_alloc(PBUF_TRANSPORT, sizeof(dhcp_data), PBUF_POOL);
-			if (pp == NULL) break;
-			memcpy(pp->payload, &dhcp_data, sizeof(dhcp_data));
-			udp_sendto(upcb, pp, IP_ADDR_BROADCAST, port);
-			pbuf_free(pp);
+			send_dhcp_data(upcb, port);
 			break;
 
 		case DHCP_REQUEST:
@@ -303,12 +320,8 @@ static void udp_recv_proc(void *arg, struct udp_pcb *upcb, struct pbuf *p, struc
 				get_ip(entry->subnet));
 
 			/* 6. send ACK */
-			pp = pbuf_alloc(PBUF_TRANSPORT, sizeof(dhcp_data), PBUF_POOL);
-			if (pp == NULL) break;
+			if (!send_dhcp_data(upcb, port)) break;
 			memcpy(entry->mac, dhcp_data.dp_chaddr, 6);
-			memcpy(pp->payload, &dhcp_data, sizeof(dhcp_data));
-			udp_sendto(upcb, pp, IP_ADDR_BROADCAST, port);
-			pbuf_free(pp);
 			break;
 
 		default:
@@ -137,7 +137,7 @@ static void udp_recv_proc(void *arg, struct udp_pcb *upcb, struct pbuf *p, struc
 	static dns_query_t query;
 	struct pbuf *out;
 	ip_addr_t host_addr;
-	dns_answer_t *answer;
+	dns_answer_t answer;
 
 	if (p->len <= sizeof(dns_header_t)) goto error;
 	header = (dns_header_t *)p->payload;
@@ -149,22 +149,32 @@ static void udp_recv_proc(void *arg, struct udp_pcb *upcb, struct pbuf *p, struc
 	if (!query_proc(query.name, &host_addr)) goto error;
 
 	len += sizeof(dns_header_t);
-	out = pbuf_alloc(PBUF_TRANSPORT, len + 16, PBUF_POOL);
+	out = pbuf_alloc(PBUF_TRANSPORT, len + sizeof(answer), PBUF_POOL);
 	if (out == NULL) goto error;
 
-	memcpy(out->payload, p->payload, len);
-	header = (dns_header_t *)out->payload;
+	/* the reply is the query, marked as a response with one answer, followed by the answer */
 	header->flags.qr = 1;
 	header->n_record[1] = htons(1);
-	answer = (struct dns_answer *)((uint8_t *)out->payload + len);
-	answer->name = htons(0xC00C);
-	answer->type = htons(1);
-	answer->Class = htons(1);
-	answer->ttl = htonl(32);
-	answer->len = htons(4);
-	answer->addr = host_addr.addr;
-	
+	answer.name = htons(0xC00C);
+	answer.type = htons(1);
+	answer.Class = htons(1);
+	answer.ttl = htonl(32);
+	answer.len = htons(4);
+	answer.addr = host_addr.addr;
+
+#if LWIP_CHECKSUM_ON_COPY
+	{
+		/* checksummed as it is copied, so that udp_sendto_chksum() doesn't read it all again */
+		u16_t chksum = 0;
+		pbuf_take_chksum(out, p->payload, len, 0, &chksum);
+		pbuf_take_chksum(out, &answer, sizeof(answer), len, &chksum);
+		udp_sendto_chksum(upcb, out, addr, port, 1, chksum);
+	}
+#else
+	memcpy(out->payload, p->payload, len);
+	memcpy((uint8_t *)out->payload + len, &answer, sizeof(answer));
 	udp_sendto(upcb, out, addr, port);
+#endif
 	pbuf_free(out);
 
 error:
@@ -0,0 +1,201 @@
+/*
+    Ethernet frame filtering for USB CDC-ECM/NCM
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+Frames from the host are classified by ecm_filter_rx() as soon as their first 64-byte chunk (holding the Ethernet header) has arrived.
+Only frames that lwIP could make use of are accepted:
+IPv4 or ARP, addressed to the device (see usb_ecm_set_hwaddr) or broadcast.
+This lwIP has no IGMP, and so belongs to no multicast group; all other multicast (the host's mDNS, LLMNR and the like) is dropped.
+The rest of an unwanted frame is read over the top of the same pbuf and dropped, so it never reaches ethernet_input().
+
+In the other direction, the host chooses (with SET_ETHERNET_PACKET_FILTER) which types of frame it wants to see,
+and (with SET_ETHERNET_MULTICAST_FILTERS) which multicast groups it belongs to; ecm_filter_tx() withholds the others
+before they are queued for transmission. The table names the groups the host receives, so it plays no part in ecm_filter_rx().
+
+The multicast table is a 64-bit hash, as in most Ethernet MACs:
+each address sets the bit given by the top six bits of its CRC-32, so a lookup is a CRC and a bit test, however many addresses there are.
+The odd unwanted group that shares a bit with a wanted one gets through; this is why wMCFilters advertises imperfect filtering.
+With no table (the default, or after the host sets zero filters), only ECM_PACKET_TYPE_ALL_MULTICAST lets multicast through to the host.
+
+Each ECM function (see NUM_OF_ECM) has its own filters, address and counters; the host's settings are forgotten when it re-configures the device.
+*/
+
+#include <string.h>
+#include "ecmfilter.h"
+#include "usbd_conf.h"
+#include "netif/etharp.h"
+#include "stm32f0xx.h"
+
+struct ecm_filter
+{
+  uint16_t packet_filter;          /* SET_ETHERNET_PACKET_FILTER bitmap */
+  uint32_t mc_hash[2];             /* SET_ETHERNET_MULTICAST_FILTERS table; the host's groups, for ecm_filter_tx() */
+  uint8_t hwaddr[ETHARP_HWADDR_LEN];
+  bool hwaddr_valid;
+  struct ecm_filter_stats stats;
+};
+
+static struct ecm_filter ecm_filters[NUM_OF_ECM];
+
+void ecm_filter_reset(unsigned index)
+{
+  struct ecm_filter *filter = &ecm_filters[index];
+
+  /* until the host says otherwise, it is sent everything */
+  filter->packet_filter = ECM_PACKET_TYPE_PROMISCUOUS | ECM_PACKET_TYPE_ALL_MULTICAST | ECM_PACKET_TYPE_DIRECTED | ECM_PACKET_TYPE_BROADCAST | ECM_PACKET_TYPE_MULTICAST;
+  filter->mc_hash[0] = 0;
+  filter->mc_hash[1] = 0;
+}
+
+void ecm_filter_set_packet_filter(unsigned index, uint16_t bitmap)
+{
+  ecm_filters[index].packet_filter = bitmap;
+}
+
+/* the bit of mc_hash that a (multicast) address hashes to: the top six bits of its (reflected) Ethernet CRC-32 */
+static unsigned ecm_mc_bit(const uint8_t *addr)
+{
+  uint32_t crc = 0xFFFFFFFF;
+  int i, bit;
+
+  for (i = 0; i < ETHARP_HWADDR_LEN; i++)
+  {
+    crc ^= addr[i];
+    for (bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+  }
+
+  return ~crc >> 26;
+}
+
+static bool ecm_mc_match(const struct ecm_filter *filter, const uint8_t *addr)
+{
+  unsigned bit = ecm_mc_bit(addr);
+
+  return filter->mc_hash[bit >> 5] & (1UL << (bit & 31));
+}
+
+void ecm_filter_set_multicast(unsigned index, const uint8_t *addrs, unsigned count)
+{
+  struct ecm_filter *filter = &ecm_filters[index];
+  uint32_t hash[2] = { 0, 0 };
+  unsigned bit;
+
+  for (; count; count--, addrs += ETHARP_HWADDR_LEN)
+  {
+    bit = ecm_mc_bit(addrs);
+    hash[bit >> 5] |= 1UL << (bit & 31);
+  }
+
+  __disable_irq();
+  filter->mc_hash[0] = hash[0];
+  filter->mc_hash[1] = hash[1];
+  __enable_irq();
+}
+
+bool ecm_filter_rx(unsigned index, const uint8_t *frame, unsigned length)
+{
+  struct ecm_filter *filter = &ecm_filters[index];
+  const struct eth_hdr *ethhdr = (const struct eth_hdr *)frame;
+  uint16_t type;
+
+  if (length < SIZEOF_ETH_HDR)
+  {
+    filter->stats.rx_runt++;
+    return false;
+  }
+
+  type = (uint16_t)frame[12] << 8 | frame[13];
+  if ((ETHTYPE_IP != type) && (ETHTYPE_ARP != type))
+  {
+    filter->stats.rx_ethertype++;
+    return false;
+  }
+
+  if (ethhdr->dest.addr[0] & 0x01)
+  {
+    if (eth_addr_cmp(&ethhdr->dest, &ethbroadcast))
+      return true;
+
+    filter->stats.rx_multicast++;
+    return false;
+  }
+
+  if (filter->hwaddr_valid && memcmp(ethhdr->dest.addr, filter->hwaddr, ETHARP_HWADDR_LEN))
+  {
+    filter->stats.rx_unicast++;
+    return false;
+  }
+
+  return true;
+}
+
+bool ecm_filter_tx(unsigned index, const struct pbuf *p)
+{
+  struct ecm_filter *filter = &ecm_filters[index];
+  const struct eth_hdr *ethhdr = (const struct eth_hdr *)p->payload;
+  uint16_t wanted;
+
+  if (filter->packet_filter & ECM_PACKET_TYPE_PROMISCUOUS)
+    return true;
+
+  if (p->len < SIZEOF_ETH_HDR)
+    wanted = 0;
+  else if (eth_addr_cmp(&ethhdr->dest, &ethbroadcast))
+    wanted = ECM_PACKET_TYPE_BROADCAST;
+  else if (ethhdr->dest.addr[0] & 0x01)
+    wanted = ECM_PACKET_TYPE_ALL_MULTICAST | (ecm_mc_match(filter, ethhdr->dest.addr) ? ECM_PACKET_TYPE_MULTICAST : 0);
+  else
+    wanted = ECM_PACKET_TYPE_DIRECTED;
+
+  if (filter->packet_filter & wanted)
+    return true;
+
+  filter->stats.tx_filtered++;
+  return false;
+}
+
+void ecm_filter_count_oversize(unsigned index)
+{
+  ecm_filters[index].stats.rx_oversize++;
+}
+
+void usb_ecm_set_hwaddr(unsigned index, const uint8_t *hwaddr)
+{
+  struct ecm_filter *filter = &ecm_filters[index];
+
+  __disable_irq();
+  memcpy(filter->hwaddr, hwaddr, ETHARP_HWADDR_LEN);
+  filter->hwaddr_valid = true;
+  __enable_irq();
+}
+
+void usb_ecm_get_filter_stats(unsigned index, struct ecm_filter_stats *stats)
+{
+  __disable_irq();
+  *stats = ecm_filters[index].stats;
+  __enable_irq();
+}
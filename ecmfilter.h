@@ -0,0 +1,62 @@
+/*
+    Ethernet frame filtering for USB CDC-ECM/NCM
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef __ECM_FILTER_H
+#define __ECM_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/pbuf.h"
+
+/* bits of the SET_ETHERNET_PACKET_FILTER bitmap */
+#define ECM_PACKET_TYPE_PROMISCUOUS   0x01
+#define ECM_PACKET_TYPE_ALL_MULTICAST 0x02
+#define ECM_PACKET_TYPE_DIRECTED      0x04
+#define ECM_PACKET_TYPE_BROADCAST     0x08
+#define ECM_PACKET_TYPE_MULTICAST     0x10
+
+struct ecm_filter_stats
+{
+  uint32_t rx_runt;          /* frames from the host shorter than an Ethernet header */
+  uint32_t rx_oversize;      /* frames from the host longer than ECM_MAX_SEGMENT_SIZE */
+  uint32_t rx_ethertype;     /* frames from the host that lwIP has no use for (neither IPv4 nor ARP) */
+  uint32_t rx_unicast;       /* frames from the host addressed to another station */
+  uint32_t rx_multicast;     /* multicast (but not broadcast) frames from the host; lwIP joins no groups */
+  uint32_t tx_filtered;      /* frames to the host withheld by its SET_ETHERNET_PACKET_FILTER bitmap */
+};
+
+/* called (from the ISR) by usbd_ecm.c or usbd_ncm.c; index is that of the ECM function (see NUM_OF_ECM) */
+void ecm_filter_reset(unsigned index);
+void ecm_filter_set_packet_filter(unsigned index, uint16_t bitmap);
+void ecm_filter_set_multicast(unsigned index, const uint8_t *addrs, unsigned count);
+/* returns false if the frame (of which at least the Ethernet header is given) should be dropped */
+bool ecm_filter_rx(unsigned index, const uint8_t *frame, unsigned length);
+bool ecm_filter_tx(unsigned index, const struct pbuf *p);
+void ecm_filter_count_oversize(unsigned index);
+
+/* set the device's own MAC address on the given ECM function; unicast frames from the host to any other address are dropped (until this is called, none are) */
+void usb_ecm_set_hwaddr(unsigned index, const uint8_t *hwaddr);
+void usb_ecm_get_filter_stats(unsigned index, struct ecm_filter_stats *stats);
+
+#endif /* __ECM_FILTER_H */
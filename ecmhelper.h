@@ -1,5 +1,5 @@
 /*
-    USB descriptor macros for CDC-ECM
+    USB descriptor macros for CDC-ECM and CDC-NCM
 
     Copyright (C) 2015,2016,2018 Peter Lawrence
 
@@ -31,6 +31,12 @@
 
 #define ECM_MAX_SEGMENT_SIZE           1514
 
+/* number of multicast addresses the host may give with SET_ETHERNET_MULTICAST_FILTERS; they are hashed (see ecmfilter.c), so the filtering is imperfect */
+#ifndef ECM_MC_FILTERS
+#define ECM_MC_FILTERS                 32
+#endif
+#define ECM_WMCFILTERS                 (0x8000 | ECM_MC_FILTERS)
+
 struct ecm_interface
 {
   struct interface_descriptor             ctl_interface;
@@ -83,9 +89,9 @@ struct ecm_interface
         .bDescriptorType    = 0x24,                                            /* CS_INTERFACE */ \
         .bDescriptorSubtype = 0x0F,                                            /* Ethernet Networking */ \
         .iMACAddress        = IMAC_STRING,                                     /* mandatory string providing MAC address */ \
-        .bmEthernetStatistics = {0,0,0,0},                                     \
+        .bmEthernetStatistics = {0x17,0x00,0x40,0x00},                         /* XMIT_OK, RCV_OK, XMIT_ERROR, RCV_NO_BUFFER, XMIT_DEFERRED */ \
         .wMaxSegmentSize    = USB_UINT16(ECM_MAX_SEGMENT_SIZE),                /* in bytes, usually 1514 */ \
-        .wMCFilters         = USB_UINT16(0),                                   /* no filters */ \
+        .wMCFilters         = USB_UINT16(ECM_WMCFILTERS),                      /* imperfect (hashed) filtering */ \
         .bNumberPowerFilters = 0,                                              /* no filters */ \
       }, \
  \
@@ -133,4 +139,130 @@ struct ecm_interface
       }, \
     },
 
+struct ncm_interface
+{
+  struct interface_descriptor             ctl_interface;
+  struct cdc_functional_descriptor_header cdc_ncm_header;
+  struct cdc_union_functional_descriptor  cdc_ncm_union;
+  struct cdc_enet_functional_descriptor   cdc_ecm_functional;
+  struct cdc_ncm_functional_descriptor    cdc_ncm_functional;
+  struct endpoint_descriptor              ctl_ep;
+  struct interface_descriptor             dat_interface_alt0;
+  struct interface_descriptor             dat_interface;
+  struct endpoint_descriptor              ep_in;
+  struct endpoint_descriptor              ep_out;
+};
+
+/* macro to help generate CDC NCM USB descriptors; the data interface has no endpoints until alternate setting 1 is selected */
+
+#define NCM_DESCRIPTOR(NOTIFY_ITF, DATA_ITF, NOTIFY_EP, DATAOUT_EP, DATAIN_EP, IMAC_STRING) \
+    { \
+      .ctl_interface = { \
+        /*Interface Descriptor */ \
+        .bLength            = sizeof(struct interface_descriptor),             /* Interface Descriptor size */ \
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,                         /* Interface */ \
+        .bInterfaceNumber   = NOTIFY_ITF,                                      /* Number of Interface */ \
+        .bAlternateSetting  = 0x00,                                            /* Alternate setting */ \
+        .bNumEndpoints      = 0x01,                                            /* One endpoints used */ \
+        .bInterfaceClass    = 0x02,                                            /* Communication Interface Class */ \
+        .bInterfaceSubclass = 0x0D,                                            /* Network Control Model */ \
+        .bInterfaceProtocol = 0x00,                                            /* No specific protocol */ \
+        .iInterface         = 0x00,                                            \
+      }, \
+ \
+      .cdc_ncm_header = { \
+        /*Header Functional Descriptor*/ \
+        .bFunctionLength    = sizeof(struct cdc_functional_descriptor_header), /* bLength: Endpoint Descriptor size */ \
+        .bDescriptorType    = 0x24,                                            /* bDescriptorType: CS_INTERFACE */ \
+        .bDescriptorSubtype = 0x00,                                            /* bDescriptorSubtype: Header Func Desc */ \
+        .bcdCDC             = USB_UINT16(0x0110),                              /* bcdCDC: spec release number */ \
+      }, \
+ \
+      .cdc_ncm_union = { \
+        /*Union Functional Descriptor*/ \
+        .bFunctionLength    = sizeof(struct cdc_union_functional_descriptor),  \
+        .bDescriptorType    = 0x24,                                            /* CS_INTERFACE */ \
+        .bDescriptorSubtype = 0x06,                                            /* Union func desc */ \
+        .bMasterInterface   = NOTIFY_ITF,                                      /* Notify interface */ \
+        .bSlaveInterface0   = DATA_ITF,                                        /* Data Interface */ \
+      }, \
+ \
+      .cdc_ecm_functional = { \
+        /*Ethernet Networking Functional Descriptor*/ \
+        .bFunctionLength    = sizeof(struct cdc_enet_functional_descriptor),   \
+        .bDescriptorType    = 0x24,                                            /* CS_INTERFACE */ \
+        .bDescriptorSubtype = 0x0F,                                            /* Ethernet Networking */ \
+        .iMACAddress        = IMAC_STRING,                                     /* mandatory string providing MAC address */ \
+        .bmEthernetStatistics = {0x17,0x00,0x40,0x00},                         /* XMIT_OK, RCV_OK, XMIT_ERROR, RCV_NO_BUFFER, XMIT_DEFERRED */ \
+        .wMaxSegmentSize    = USB_UINT16(ECM_MAX_SEGMENT_SIZE),                /* in bytes, usually 1514 */ \
+        .wMCFilters         = USB_UINT16(ECM_WMCFILTERS),                      /* imperfect (hashed) filtering */ \
+        .bNumberPowerFilters = 0,                                              /* no filters */ \
+      }, \
+ \
+      .cdc_ncm_functional = { \
+        /*NCM Functional Descriptor*/ \
+        .bFunctionLength    = sizeof(struct cdc_ncm_functional_descriptor),    \
+        .bDescriptorType    = 0x24,                                            /* CS_INTERFACE */ \
+        .bDescriptorSubtype = 0x1A,                                            /* NCM */ \
+        .bcdNcmVersion      = USB_UINT16(0x0100),                              /* NCM 1.0 */ \
+        .bmNetworkCapabilities = 0x01,                                         /* Ethernet filter requests */ \
+      }, \
+ \
+      .ctl_ep = { \
+        /* Notify Endpoint Descriptor*/ \
+        .bLength            = sizeof(struct endpoint_descriptor),              /* Endpoint Descriptor size */ \
+        .bDescriptorType    = USB_DESC_TYPE_ENDPOINT,                          /* Endpoint */ \
+        .bEndpointAddress   = NOTIFY_EP,                                       \
+        .bmAttributes       = 0x03,                                            /* Interrupt */ \
+        .wMaxPacketSize     = USB_UINT16(ECM_NOTIFICATION_IN_SZ),              \
+        .bInterval          = 0xFF,                                            \
+      }, \
+ \
+      .dat_interface_alt0 = { \
+        /*Data class interface descriptor (no data traffic)*/ \
+        .bLength            = sizeof(struct interface_descriptor),             /* Endpoint Descriptor size */ \
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,                         \
+        .bInterfaceNumber   = DATA_ITF,                                        /* Number of Interface */ \
+        .bAlternateSetting  = 0x00,                                            /* Alternate setting */ \
+        .bNumEndpoints      = 0x00,                                            /* No endpoints used */ \
+        .bInterfaceClass    = 0x0A,                                            /* CDC */ \
+        .bInterfaceSubclass = 0x00,                                            \
+        .bInterfaceProtocol = 0x01,                                            /* Network Transfer Block */ \
+        .iInterface         = 0x00,                                            \
+      }, \
+ \
+      .dat_interface = { \
+        /*Data class interface descriptor*/ \
+        .bLength            = sizeof(struct interface_descriptor),             /* Endpoint Descriptor size */ \
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,                         \
+        .bInterfaceNumber   = DATA_ITF,                                        /* Number of Interface */ \
+        .bAlternateSetting  = 0x01,                                            /* Alternate setting */ \
+        .bNumEndpoints      = 0x02,                                            /* Two endpoints used */ \
+        .bInterfaceClass    = 0x0A,                                            /* CDC */ \
+        .bInterfaceSubclass = 0x00,                                            \
+        .bInterfaceProtocol = 0x01,                                            /* Network Transfer Block */ \
+        .iInterface         = 0x00,                                            \
+      }, \
+ \
+      .ep_in = { \
+        /* Data Endpoint IN Descriptor*/ \
+        .bLength            = sizeof(struct endpoint_descriptor),              /* Endpoint Descriptor size */ \
+        .bDescriptorType    = USB_DESC_TYPE_ENDPOINT,                          /* Endpoint */ \
+        .bEndpointAddress   = DATAIN_EP,                                       \
+        .bmAttributes       = 0x02,                                            /* Bulk */ \
+        .wMaxPacketSize     = USB_UINT16(ECM_DATA_IN_SZ),                      \
+        .bInterval          = 0x00                                             /* ignore for Bulk transfer */ \
+      }, \
+ \
+      .ep_out = { \
+        /* Data Endpoint OUT Descriptor */ \
+        .bLength            = sizeof(struct endpoint_descriptor),              /* Endpoint Descriptor size */ \
+        .bDescriptorType    = USB_DESC_TYPE_ENDPOINT,                          /* Endpoint */ \
+        .bEndpointAddress   = DATAOUT_EP,                                      \
+        .bmAttributes       = 0x02,                                            /* Bulk */ \
+        .wMaxPacketSize     = USB_UINT16(ECM_DATA_OUT_SZ),                     \
+        .bInterval          = 0x00,                                            /* ignore for Bulk transfer */ \
+      }, \
+    },
+
 #endif /* __ECM_HELPER_H */
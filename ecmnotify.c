@@ -0,0 +1,141 @@
+/*
+    Notifications for USB CDC-ECM/NCM
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+Each ECM (or NCM) function tells the host about its link through its interrupt endpoint, one notification at a time.
+CONNECTION_SPEED_CHANGE gives the bit rates of the link, which hosts use to size their queues and to pace traffic;
+without it, Linux's cdc_ether falls back to defaults that don't suit a USB full-speed link.
+NETWORK_CONNECTION gives the link state, which follows the netif (see usb_ecm_set_link).
+
+Notifications wait in a small queue until the interrupt endpoint is free; the DataIn completion of one starts the next.
+Nothing is sent until the host is known to be listening (ecm_notify_start), which is
+when it first sets the packet filter (ECM) or selects the data interface (NCM); the whole state is then sent afresh.
+A notification that the HAL refuses (as it is busy) is retried on the next SOF.
+*/
+
+#include "ecmnotify.h"
+#include "usbd_core.h"
+
+#if (ECM_NOTIFY_QUEUE_SIZE & (ECM_NOTIFY_QUEUE_SIZE - 1)) || (ECM_NOTIFY_QUEUE_SIZE < 2)
+#error ECM_NOTIFY_QUEUE_SIZE must be a power of two
+#endif
+
+void ecm_notify_init(struct ecm_notify *notify, uint8_t ep, uint16_t itf)
+{
+  notify->pdev = NULL;
+  notify->ep = ep;
+  notify->itf = itf;
+  notify->busy = false;
+  notify->head = notify->tail = 0;
+}
+
+/* queue a notification (of up to eight bytes of data) */
+static void ecm_notify_queue(struct ecm_notify *notify, uint8_t code, uint16_t value, const uint32_t *data, unsigned words)
+{
+  struct ecm_notification *entry;
+  uint8_t *dst;
+  unsigned i;
+
+  if ((notify->head - notify->tail) >= ECM_NOTIFY_QUEUE_SIZE)
+  {
+    notify->drops++;
+    return;
+  }
+
+  entry = &notify->queue[notify->head % ECM_NOTIFY_QUEUE_SIZE];
+  dst = (uint8_t *)entry->data;
+
+  dst[0] = 0xA1; /* bmRequestType: device to host, class, interface */
+  dst[1] = code;
+  dst[2] = LOBYTE(value);
+  dst[3] = HIBYTE(value);
+  dst[4] = LOBYTE(notify->itf);
+  dst[5] = HIBYTE(notify->itf);
+  dst[6] = LOBYTE(4 * words);
+  dst[7] = HIBYTE(4 * words);
+
+  for (i = 0; i < 4 * words; i++)
+    dst[8 + i] = data[i / 4] >> (8 * (i % 4));
+
+  entry->length = 8 + 4 * words;
+  notify->head++;
+
+  ecm_notify_service(notify);
+}
+
+static void ecm_notify_state(struct ecm_notify *notify)
+{
+  static const uint32_t bit_rates[2] = { ECM_DOWNSTREAM_BIT_RATE, ECM_UPSTREAM_BIT_RATE };
+
+  /* the speed is only meaningful with the link up */
+  if (!notify->link_down)
+    ecm_notify_queue(notify, 0x2A /* CONNECTION_SPEED_CHANGE */, 0, bit_rates, 2);
+
+  ecm_notify_queue(notify, 0x00 /* NETWORK_CONNECTION */, notify->link_down ? 0 /* Disconnected */ : 1 /* Connected */, NULL, 0);
+}
+
+void ecm_notify_start(struct ecm_notify *notify, USBD_HandleTypeDef *pdev)
+{
+  notify->pdev = pdev;
+  ecm_notify_state(notify);
+}
+
+void ecm_notify_link(struct ecm_notify *notify, bool up)
+{
+  if (notify->link_down == !up)
+    return;
+
+  notify->link_down = !up;
+
+  if (notify->pdev)
+    ecm_notify_state(notify);
+}
+
+void ecm_notify_complete(struct ecm_notify *notify)
+{
+  if (notify->busy)
+  {
+    notify->busy = false;
+    notify->tail++;
+    notify->sent++;
+  }
+
+  ecm_notify_service(notify);
+}
+
+/* hand the oldest notification to the HAL if the endpoint is free; called again on each SOF in case the HAL was busy */
+void ecm_notify_service(struct ecm_notify *notify)
+{
+  struct ecm_notification *entry;
+
+  if (!notify->pdev || notify->busy || (notify->tail == notify->head))
+    return;
+
+  entry = &notify->queue[notify->tail % ECM_NOTIFY_QUEUE_SIZE];
+
+  if (USBD_OK == USBD_LL_Transmit(notify->pdev, notify->ep, (uint8_t *)entry->data, entry->length))
+    notify->busy = true;
+}
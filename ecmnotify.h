@@ -0,0 +1,75 @@
+/*
+    Notifications for USB CDC-ECM/NCM
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef __ECM_NOTIFY_H
+#define __ECM_NOTIFY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usbd_def.h"
+
+/* number of notifications that can wait for the interrupt endpoint; must be a power of two */
+#ifndef ECM_NOTIFY_QUEUE_SIZE
+#define ECM_NOTIFY_QUEUE_SIZE 4
+#endif
+
+/*
+bit rates (to and from the host) advertised with CONNECTION_SPEED_CHANGE;
+19 bulk packets of 64 bytes in each 1ms frame is the most that USB full-speed can carry
+*/
+#ifndef ECM_DOWNSTREAM_BIT_RATE
+#define ECM_DOWNSTREAM_BIT_RATE 9728000
+#endif
+#ifndef ECM_UPSTREAM_BIT_RATE
+#define ECM_UPSTREAM_BIT_RATE   9728000
+#endif
+
+struct ecm_notification
+{
+  uint16_t data[8];                /* the notification, including any data stage; halfwords keep it aligned for the copy to PMA */
+  uint16_t length;
+};
+
+/* the notification state of one ECM (or NCM) function */
+struct ecm_notify
+{
+  USBD_HandleTypeDef *pdev;        /* set once the host is listening; NULL until then */
+  uint8_t ep;                      /* notification IN endpoint */
+  uint16_t itf;                    /* interface that the notifications are from */
+  bool link_down;                  /* as last reported by usb_ecm_set_link() */
+  bool busy;                       /* a notification is with the HAL */
+  struct ecm_notification queue[ECM_NOTIFY_QUEUE_SIZE];
+  unsigned head, tail;             /* free-running */
+  uint32_t sent;                   /* notifications sent to the host */
+  uint32_t drops;                  /* notifications lost to a full queue */
+};
+
+/* called (from the ISR, or with interrupts disabled) by usbd_ecm.c or usbd_ncm.c */
+void ecm_notify_init(struct ecm_notify *notify, uint8_t ep, uint16_t itf);
+void ecm_notify_start(struct ecm_notify *notify, USBD_HandleTypeDef *pdev);
+void ecm_notify_link(struct ecm_notify *notify, bool up);
+void ecm_notify_complete(struct ecm_notify *notify);
+void ecm_notify_service(struct ecm_notify *notify);
+
+#endif /* __ECM_NOTIFY_H */
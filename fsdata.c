@@ -843,12 +843,12 @@ static const unsigned char data__index_html[] = {
 " (27 bytes) */
 0x43,0x6f,0x6e,0x74,0x65,0x6e,0x74,0x2d,0x74,0x79,0x70,0x65,0x3a,0x20,0x74,0x65,
 0x78,0x74,0x2f,0x68,0x74,0x6d,0x6c,0x0d,0x0a,0x0d,0x0a,
-/* raw file data (2302 bytes) */
+/* raw file data (2470 bytes) */
 0x3c,0x68,0x74,0x6d,0x6c,0x3e,0x0d,0x0a,0x3c,0x68,0x65,0x61,0x64,0x3e,0x3c,0x74,
 0x69,0x74,0x6c,0x65,0x3e,0x54,0x6f,0x61,0x73,0x74,0x65,0x72,0x20,0x45,0x78,0x61,
 0x6d,0x70,0x6c,0x65,0x3c,0x2f,0x74,0x69,0x74,0x6c,0x65,0x3e,0x0d,0x0a,0x0d,0x0a,
 0x3c,0x73,0x74,0x79,0x6c,0x65,0x3e,0x0d,0x0a,0x2e,0x72,0x64,0x69,0x76,0x20,0x7b,
-0x0d,0x0a,0x09,0x68,0x65,0x69,0x67,0x68,0x74,0x3a,0x20,0x32,0x34,0x30,0x70,0x78,
+0x0d,0x0a,0x09,0x68,0x65,0x69,0x67,0x68,0x74,0x3a,0x20,0x33,0x30,0x30,0x70,0x78,
 0x3b,0x0d,0x0a,0x09,0x77,0x69,0x64,0x74,0x68,0x3a,0x20,0x31,0x35,0x30,0x70,0x78,
 0x3b,0x0d,0x0a,0x09,0x62,0x6f,0x72,0x64,0x65,0x72,0x2d,0x72,0x61,0x64,0x69,0x75,
 0x73,0x3a,0x20,0x35,0x70,0x78,0x3b,0x0d,0x0a,0x20,0x20,0x20,0x20,0x2d,0x6d,0x6f,
@@ -888,106 +888,117 @@ static const unsigned char data__index_html[] = {
 0x2e,0x73,0x79,0x73,0x74,0x69,0x63,0x6b,0x20,0x2f,0x20,0x31,0x30,0x30,0x30,0x29,
 0x20,0x2b,0x20,0x27,0x20,0x73,0x65,0x63,0x6f,0x6e,0x64,0x73,0x27,0x3b,0x0d,0x0a,
 0x09,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x2e,0x67,0x65,0x74,0x45,0x6c,0x65,
-0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x61,0x6c,0x70,0x68,0x61,0x22,
-0x29,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3d,0x20,0x73,0x74,0x61,0x74,
-0x65,0x2e,0x75,0x73,0x65,0x72,0x2e,0x61,0x20,0x3d,0x3d,0x20,0x31,0x3b,0x0d,0x0a,
-0x09,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x2e,0x67,0x65,0x74,0x45,0x6c,0x65,
-0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x62,0x72,0x61,0x76,0x6f,0x22,
-0x29,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3d,0x20,0x73,0x74,0x61,0x74,
-0x65,0x2e,0x75,0x73,0x65,0x72,0x2e,0x62,0x20,0x3d,0x3d,0x20,0x31,0x3b,0x0d,0x0a,
-0x09,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x2e,0x67,0x65,0x74,0x45,0x6c,0x65,
-0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x63,0x68,0x61,0x72,0x6c,0x69,
-0x65,0x22,0x29,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3d,0x20,0x73,0x74,
-0x61,0x74,0x65,0x2e,0x75,0x73,0x65,0x72,0x2e,0x63,0x20,0x3d,0x3d,0x20,0x31,0x3b,
-0x0d,0x0a,0x7d,0x0d,0x0a,0x0d,0x0a,0x76,0x61,0x72,0x20,0x73,0x65,0x6e,0x64,0x53,
-0x74,0x61,0x74,0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x20,0x3d,0x20,0x66,0x75,
-0x6e,0x63,0x74,0x69,0x6f,0x6e,0x20,0x28,0x29,0x0d,0x0a,0x7b,0x0d,0x0a,0x09,0x24,
-0x2e,0x61,0x6a,0x61,0x78,0x28,0x7b,0x0d,0x0a,0x09,0x09,0x75,0x72,0x6c,0x3a,0x20,
-0x22,0x2f,0x73,0x74,0x61,0x74,0x65,0x2e,0x63,0x67,0x69,0x22,0x2c,0x0d,0x0a,0x09,
-0x09,0x74,0x69,0x6d,0x65,0x6f,0x75,0x74,0x3a,0x20,0x32,0x30,0x30,0x30,0x2c,0x0d,
-0x0a,0x09,0x09,0x73,0x75,0x63,0x63,0x65,0x73,0x73,0x3a,0x20,0x66,0x75,0x6e,0x63,
-0x74,0x69,0x6f,0x6e,0x28,0x64,0x61,0x74,0x61,0x29,0x0d,0x0a,0x09,0x09,0x7b,0x0d,
-0x0a,0x09,0x09,0x09,0x73,0x65,0x74,0x54,0x69,0x6d,0x65,0x6f,0x75,0x74,0x28,0x73,
-0x65,0x6e,0x64,0x53,0x74,0x61,0x74,0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x2c,
-0x20,0x32,0x30,0x30,0x29,0x3b,0x0d,0x0a,0x09,0x09,0x09,0x70,0x6f,0x6c,0x6c,0x69,
-0x6e,0x67,0x45,0x72,0x72,0x6f,0x72,0x20,0x3d,0x20,0x66,0x61,0x6c,0x73,0x65,0x3b,
-0x0d,0x0a,0x09,0x09,0x09,0x64,0x6f,0x55,0x70,0x64,0x61,0x74,0x65,0x28,0x64,0x61,
-0x74,0x61,0x29,0x3b,0x0d,0x0a,0x09,0x09,0x7d,0x2c,0x0d,0x0a,0x09,0x09,0x65,0x72,
-0x72,0x6f,0x72,0x3a,0x20,0x66,0x75,0x6e,0x63,0x74,0x69,0x6f,0x6e,0x28,0x64,0x61,
-0x74,0x61,0x29,0x0d,0x0a,0x09,0x09,0x7b,0x0d,0x0a,0x09,0x09,0x09,0x73,0x65,0x74,
-0x54,0x69,0x6d,0x65,0x6f,0x75,0x74,0x28,0x73,0x65,0x6e,0x64,0x53,0x74,0x61,0x74,
-0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x2c,0x20,0x31,0x30,0x30,0x30,0x29,0x3b,
-0x0d,0x0a,0x09,0x09,0x09,0x70,0x6f,0x6c,0x6c,0x69,0x6e,0x67,0x45,0x72,0x72,0x6f,
-0x72,0x20,0x3d,0x20,0x74,0x72,0x75,0x65,0x3b,0x0d,0x0a,0x09,0x09,0x09,0x64,0x6f,
-0x55,0x70,0x64,0x61,0x74,0x65,0x28,0x64,0x61,0x74,0x61,0x29,0x3b,0x0d,0x0a,0x09,
-0x09,0x7d,0x2c,0x0d,0x0a,0x09,0x09,0x64,0x61,0x74,0x61,0x54,0x79,0x70,0x65,0x3a,
-0x20,0x22,0x6a,0x73,0x6f,0x6e,0x22,0x0d,0x0a,0x09,0x7d,0x29,0x3b,0x0d,0x0a,0x7d,
-0x0d,0x0a,0x0d,0x0a,0x66,0x75,0x6e,0x63,0x74,0x69,0x6f,0x6e,0x20,0x63,0x74,0x6c,
-0x28,0x64,0x61,0x74,0x61,0x6f,0x62,0x6a,0x29,0x0d,0x0a,0x7b,0x0d,0x0a,0x09,0x24,
-0x2e,0x61,0x6a,0x61,0x78,0x28,0x7b,0x0d,0x0a,0x09,0x09,0x75,0x72,0x6c,0x3a,0x20,
-0x22,0x2f,0x63,0x74,0x6c,0x2e,0x63,0x67,0x69,0x22,0x2c,0x0d,0x0a,0x09,0x09,0x64,
-0x61,0x74,0x61,0x3a,0x20,0x64,0x61,0x74,0x61,0x6f,0x62,0x6a,0x2c,0x0d,0x0a,0x09,
-0x09,0x73,0x75,0x63,0x63,0x65,0x73,0x73,0x3a,0x20,0x66,0x75,0x6e,0x63,0x74,0x69,
-0x6f,0x6e,0x28,0x64,0x61,0x74,0x61,0x29,0x20,0x7b,0x20,0x64,0x6f,0x55,0x70,0x64,
-0x61,0x74,0x65,0x28,0x64,0x61,0x74,0x61,0x29,0x3b,0x20,0x7d,0x2c,0x0d,0x0a,0x09,
-0x09,0x64,0x61,0x74,0x61,0x54,0x79,0x70,0x65,0x3a,0x20,0x22,0x6a,0x73,0x6f,0x6e,
-0x22,0x0d,0x0a,0x09,0x7d,0x29,0x3b,0x0d,0x0a,0x7d,0x0d,0x0a,0x0d,0x0a,0x66,0x75,
-0x6e,0x63,0x74,0x69,0x6f,0x6e,0x20,0x64,0x6f,0x63,0x52,0x65,0x61,0x64,0x79,0x28,
-0x29,0x0d,0x0a,0x7b,0x0d,0x0a,0x09,0x73,0x65,0x6e,0x64,0x53,0x74,0x61,0x74,0x65,
-0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x28,0x29,0x3b,0x0d,0x0a,0x7d,0x0d,0x0a,0x0d,
-0x0a,0x24,0x28,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x29,0x2e,0x72,0x65,0x61,
-0x64,0x79,0x28,0x64,0x6f,0x63,0x52,0x65,0x61,0x64,0x79,0x28,0x29,0x29,0x3b,0x0d,
-0x0a,0x0d,0x0a,0x3c,0x2f,0x73,0x63,0x72,0x69,0x70,0x74,0x3e,0x20,0x0d,0x0a,0x0d,
-0x0a,0x3c,0x2f,0x68,0x65,0x61,0x64,0x3e,0x0d,0x0a,0x3c,0x62,0x6f,0x64,0x79,0x20,
-0x62,0x67,0x63,0x6f,0x6c,0x6f,0x72,0x3d,0x22,0x77,0x68,0x69,0x74,0x65,0x22,0x20,
-0x74,0x65,0x78,0x74,0x3d,0x22,0x62,0x6c,0x61,0x63,0x6b,0x22,0x3e,0x0d,0x0a,0x3c,
-0x63,0x65,0x6e,0x74,0x65,0x72,0x3e,0x3c,0x74,0x61,0x62,0x6c,0x65,0x20,0x63,0x65,
-0x6c,0x6c,0x73,0x70,0x61,0x63,0x69,0x6e,0x67,0x3d,0x22,0x33,0x32,0x22,0x3e,0x0d,
-0x0a,0x3c,0x74,0x72,0x3e,0x0d,0x0a,0x09,0x3c,0x74,0x64,0x3e,0x0d,0x0a,0x3c,0x21,
-0x2d,0x2d,0x5b,0x69,0x66,0x20,0x6c,0x74,0x65,0x20,0x49,0x45,0x20,0x39,0x20,0x5d,
-0x3e,0x0d,0x0a,0x09,0x53,0x6f,0x72,0x72,0x79,0x2c,0x20,0x49,0x45,0x3c,0x39,0x20,
-0x62,0x72,0x6f,0x77,0x73,0x65,0x72,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x64,0x6f,
-0x65,0x73,0x20,0x6e,0x6f,0x74,0x20,0x73,0x75,0x70,0x70,0x6f,0x72,0x74,0x20,0x53,
-0x56,0x47,0x0d,0x0a,0x3c,0x21,0x5b,0x65,0x6e,0x64,0x69,0x66,0x5d,0x2d,0x2d,0x3e,
-0x0d,0x0a,0x3c,0x21,0x2d,0x2d,0x5b,0x69,0x66,0x20,0x21,0x6c,0x74,0x65,0x20,0x49,
-0x45,0x20,0x39,0x5d,0x3e,0x20,0x2d,0x2d,0x3e,0x0d,0x0a,0x09,0x3c,0x69,0x6d,0x67,
-0x20,0x68,0x65,0x69,0x67,0x68,0x74,0x3d,0x22,0x34,0x30,0x30,0x22,0x20,0x73,0x72,
-0x63,0x3d,0x22,0x2e,0x2f,0x69,0x6d,0x67,0x2f,0x74,0x6f,0x61,0x73,0x74,0x65,0x72,
-0x2e,0x73,0x76,0x67,0x22,0x3e,0x0d,0x0a,0x3c,0x21,0x2d,0x2d,0x20,0x3c,0x21,0x5b,
-0x65,0x6e,0x64,0x69,0x66,0x5d,0x2d,0x2d,0x3e,0x0d,0x0a,0x0d,0x0a,0x09,0x3c,0x2f,
-0x74,0x64,0x3e,0x0d,0x0a,0x09,0x3c,0x74,0x64,0x3e,0x0d,0x0a,0x09,0x09,0x3c,0x64,
-0x69,0x76,0x20,0x63,0x6c,0x61,0x73,0x73,0x3d,0x22,0x72,0x64,0x69,0x76,0x22,0x3e,
-0x0d,0x0a,0x09,0x09,0x09,0x3c,0x62,0x3e,0x44,0x65,0x76,0x69,0x63,0x65,0x20,0x73,
-0x74,0x61,0x74,0x65,0x3c,0x2f,0x62,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,
-0x09,0x3c,0x64,0x69,0x76,0x20,0x69,0x64,0x3d,0x22,0x64,0x65,0x76,0x73,0x74,0x61,
-0x74,0x65,0x22,0x3e,0x3c,0x2f,0x64,0x69,0x76,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,
-0x09,0x09,0x09,0x3c,0x62,0x3e,0x44,0x65,0x76,0x69,0x63,0x65,0x20,0x74,0x69,0x6d,
-0x65,0x3c,0x2f,0x62,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x64,
-0x69,0x76,0x20,0x69,0x64,0x3d,0x22,0x73,0x79,0x73,0x74,0x69,0x63,0x6b,0x22,0x3e,
-0x3c,0x2f,0x64,0x69,0x76,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,
-0x62,0x3e,0x55,0x73,0x65,0x72,0x20,0x43,0x6f,0x6e,0x74,0x72,0x6f,0x6c,0x73,0x3c,
-0x2f,0x62,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x69,0x6e,0x70,
-0x75,0x74,0x20,0x69,0x64,0x3d,0x22,0x61,0x6c,0x70,0x68,0x61,0x22,0x20,0x74,0x79,
-0x70,0x65,0x3d,0x22,0x63,0x68,0x65,0x63,0x6b,0x62,0x6f,0x78,0x22,0x20,0x6f,0x6e,
-0x63,0x6c,0x69,0x63,0x6b,0x3d,0x22,0x63,0x74,0x6c,0x28,0x7b,0x61,0x3a,0x20,0x28,
-0x74,0x68,0x69,0x73,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3f,0x20,0x31,
-0x20,0x3a,0x20,0x30,0x29,0x7d,0x29,0x22,0x3e,0x61,0x6c,0x70,0x68,0x61,0x3c,0x62,
-0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x69,0x6e,0x70,0x75,0x74,0x20,0x69,0x64,
-0x3d,0x22,0x62,0x72,0x61,0x76,0x6f,0x22,0x20,0x74,0x79,0x70,0x65,0x3d,0x22,0x63,
-0x68,0x65,0x63,0x6b,0x62,0x6f,0x78,0x22,0x20,0x6f,0x6e,0x63,0x6c,0x69,0x63,0x6b,
-0x3d,0x22,0x63,0x74,0x6c,0x28,0x7b,0x62,0x3a,0x20,0x28,0x74,0x68,0x69,0x73,0x2e,
-0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3f,0x20,0x31,0x20,0x3a,0x20,0x30,0x29,
-0x7d,0x29,0x22,0x3e,0x62,0x72,0x61,0x76,0x6f,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,
-0x09,0x09,0x3c,0x69,0x6e,0x70,0x75,0x74,0x20,0x69,0x64,0x3d,0x22,0x63,0x68,0x61,
-0x72,0x6c,0x69,0x65,0x22,0x20,0x74,0x79,0x70,0x65,0x3d,0x22,0x63,0x68,0x65,0x63,
+0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x6c,0x6f,0x6f,0x70,0x22,0x29,
+0x2e,0x69,0x6e,0x6e,0x65,0x72,0x48,0x54,0x4d,0x4c,0x20,0x3d,0x20,0x27,0x27,0x20,
+0x2b,0x20,0x73,0x74,0x61,0x74,0x65,0x2e,0x6c,0x6f,0x6f,0x70,0x2e,0x70,0x61,0x73,
+0x73,0x65,0x73,0x20,0x2b,0x20,0x27,0x20,0x70,0x61,0x73,0x73,0x65,0x73,0x2c,0x20,
+0x27,0x20,0x2b,0x20,0x73,0x74,0x61,0x74,0x65,0x2e,0x6c,0x6f,0x6f,0x70,0x2e,0x69,
+0x64,0x6c,0x65,0x20,0x2b,0x20,0x27,0x25,0x20,0x69,0x64,0x6c,0x65,0x27,0x3b,0x0d,
+0x0a,0x09,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x2e,0x67,0x65,0x74,0x45,0x6c,
+0x65,0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x61,0x6c,0x70,0x68,0x61,
+0x22,0x29,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3d,0x20,0x73,0x74,0x61,
+0x74,0x65,0x2e,0x75,0x73,0x65,0x72,0x2e,0x61,0x20,0x3d,0x3d,0x20,0x31,0x3b,0x0d,
+0x0a,0x09,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x2e,0x67,0x65,0x74,0x45,0x6c,
+0x65,0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x62,0x72,0x61,0x76,0x6f,
+0x22,0x29,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3d,0x20,0x73,0x74,0x61,
+0x74,0x65,0x2e,0x75,0x73,0x65,0x72,0x2e,0x62,0x20,0x3d,0x3d,0x20,0x31,0x3b,0x0d,
+0x0a,0x09,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x2e,0x67,0x65,0x74,0x45,0x6c,
+0x65,0x6d,0x65,0x6e,0x74,0x42,0x79,0x49,0x64,0x28,0x22,0x63,0x68,0x61,0x72,0x6c,
+0x69,0x65,0x22,0x29,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3d,0x20,0x73,
+0x74,0x61,0x74,0x65,0x2e,0x75,0x73,0x65,0x72,0x2e,0x63,0x20,0x3d,0x3d,0x20,0x31,
+0x3b,0x0d,0x0a,0x7d,0x0d,0x0a,0x0d,0x0a,0x76,0x61,0x72,0x20,0x73,0x65,0x6e,0x64,
+0x53,0x74,0x61,0x74,0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x20,0x3d,0x20,0x66,
+0x75,0x6e,0x63,0x74,0x69,0x6f,0x6e,0x20,0x28,0x29,0x0d,0x0a,0x7b,0x0d,0x0a,0x09,
+0x24,0x2e,0x61,0x6a,0x61,0x78,0x28,0x7b,0x0d,0x0a,0x09,0x09,0x75,0x72,0x6c,0x3a,
+0x20,0x22,0x2f,0x73,0x74,0x61,0x74,0x65,0x2e,0x63,0x67,0x69,0x22,0x2c,0x0d,0x0a,
+0x09,0x09,0x74,0x69,0x6d,0x65,0x6f,0x75,0x74,0x3a,0x20,0x32,0x30,0x30,0x30,0x2c,
+0x0d,0x0a,0x09,0x09,0x73,0x75,0x63,0x63,0x65,0x73,0x73,0x3a,0x20,0x66,0x75,0x6e,
+0x63,0x74,0x69,0x6f,0x6e,0x28,0x64,0x61,0x74,0x61,0x29,0x0d,0x0a,0x09,0x09,0x7b,
+0x0d,0x0a,0x09,0x09,0x09,0x73,0x65,0x74,0x54,0x69,0x6d,0x65,0x6f,0x75,0x74,0x28,
+0x73,0x65,0x6e,0x64,0x53,0x74,0x61,0x74,0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,
+0x2c,0x20,0x32,0x30,0x30,0x29,0x3b,0x0d,0x0a,0x09,0x09,0x09,0x70,0x6f,0x6c,0x6c,
+0x69,0x6e,0x67,0x45,0x72,0x72,0x6f,0x72,0x20,0x3d,0x20,0x66,0x61,0x6c,0x73,0x65,
+0x3b,0x0d,0x0a,0x09,0x09,0x09,0x64,0x6f,0x55,0x70,0x64,0x61,0x74,0x65,0x28,0x64,
+0x61,0x74,0x61,0x29,0x3b,0x0d,0x0a,0x09,0x09,0x7d,0x2c,0x0d,0x0a,0x09,0x09,0x65,
+0x72,0x72,0x6f,0x72,0x3a,0x20,0x66,0x75,0x6e,0x63,0x74,0x69,0x6f,0x6e,0x28,0x64,
+0x61,0x74,0x61,0x29,0x0d,0x0a,0x09,0x09,0x7b,0x0d,0x0a,0x09,0x09,0x09,0x73,0x65,
+0x74,0x54,0x69,0x6d,0x65,0x6f,0x75,0x74,0x28,0x73,0x65,0x6e,0x64,0x53,0x74,0x61,
+0x74,0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x2c,0x20,0x31,0x30,0x30,0x30,0x29,
+0x3b,0x0d,0x0a,0x09,0x09,0x09,0x70,0x6f,0x6c,0x6c,0x69,0x6e,0x67,0x45,0x72,0x72,
+0x6f,0x72,0x20,0x3d,0x20,0x74,0x72,0x75,0x65,0x3b,0x0d,0x0a,0x09,0x09,0x09,0x64,
+0x6f,0x55,0x70,0x64,0x61,0x74,0x65,0x28,0x64,0x61,0x74,0x61,0x29,0x3b,0x0d,0x0a,
+0x09,0x09,0x7d,0x2c,0x0d,0x0a,0x09,0x09,0x64,0x61,0x74,0x61,0x54,0x79,0x70,0x65,
+0x3a,0x20,0x22,0x6a,0x73,0x6f,0x6e,0x22,0x0d,0x0a,0x09,0x7d,0x29,0x3b,0x0d,0x0a,
+0x7d,0x0d,0x0a,0x0d,0x0a,0x66,0x75,0x6e,0x63,0x74,0x69,0x6f,0x6e,0x20,0x63,0x74,
+0x6c,0x28,0x64,0x61,0x74,0x61,0x6f,0x62,0x6a,0x29,0x0d,0x0a,0x7b,0x0d,0x0a,0x09,
+0x24,0x2e,0x61,0x6a,0x61,0x78,0x28,0x7b,0x0d,0x0a,0x09,0x09,0x75,0x72,0x6c,0x3a,
+0x20,0x22,0x2f,0x63,0x74,0x6c,0x2e,0x63,0x67,0x69,0x22,0x2c,0x0d,0x0a,0x09,0x09,
+0x64,0x61,0x74,0x61,0x3a,0x20,0x64,0x61,0x74,0x61,0x6f,0x62,0x6a,0x2c,0x0d,0x0a,
+0x09,0x09,0x73,0x75,0x63,0x63,0x65,0x73,0x73,0x3a,0x20,0x66,0x75,0x6e,0x63,0x74,
+0x69,0x6f,0x6e,0x28,0x64,0x61,0x74,0x61,0x29,0x20,0x7b,0x20,0x64,0x6f,0x55,0x70,
+0x64,0x61,0x74,0x65,0x28,0x64,0x61,0x74,0x61,0x29,0x3b,0x20,0x7d,0x2c,0x0d,0x0a,
+0x09,0x09,0x64,0x61,0x74,0x61,0x54,0x79,0x70,0x65,0x3a,0x20,0x22,0x6a,0x73,0x6f,
+0x6e,0x22,0x0d,0x0a,0x09,0x7d,0x29,0x3b,0x0d,0x0a,0x7d,0x0d,0x0a,0x0d,0x0a,0x66,
+0x75,0x6e,0x63,0x74,0x69,0x6f,0x6e,0x20,0x64,0x6f,0x63,0x52,0x65,0x61,0x64,0x79,
+0x28,0x29,0x0d,0x0a,0x7b,0x0d,0x0a,0x09,0x73,0x65,0x6e,0x64,0x53,0x74,0x61,0x74,
+0x65,0x52,0x65,0x71,0x75,0x65,0x73,0x74,0x28,0x29,0x3b,0x0d,0x0a,0x7d,0x0d,0x0a,
+0x0d,0x0a,0x24,0x28,0x64,0x6f,0x63,0x75,0x6d,0x65,0x6e,0x74,0x29,0x2e,0x72,0x65,
+0x61,0x64,0x79,0x28,0x64,0x6f,0x63,0x52,0x65,0x61,0x64,0x79,0x28,0x29,0x29,0x3b,
+0x0d,0x0a,0x0d,0x0a,0x3c,0x2f,0x73,0x63,0x72,0x69,0x70,0x74,0x3e,0x20,0x0d,0x0a,
+0x0d,0x0a,0x3c,0x2f,0x68,0x65,0x61,0x64,0x3e,0x0d,0x0a,0x3c,0x62,0x6f,0x64,0x79,
+0x20,0x62,0x67,0x63,0x6f,0x6c,0x6f,0x72,0x3d,0x22,0x77,0x68,0x69,0x74,0x65,0x22,
+0x20,0x74,0x65,0x78,0x74,0x3d,0x22,0x62,0x6c,0x61,0x63,0x6b,0x22,0x3e,0x0d,0x0a,
+0x3c,0x63,0x65,0x6e,0x74,0x65,0x72,0x3e,0x3c,0x74,0x61,0x62,0x6c,0x65,0x20,0x63,
+0x65,0x6c,0x6c,0x73,0x70,0x61,0x63,0x69,0x6e,0x67,0x3d,0x22,0x33,0x32,0x22,0x3e,
+0x0d,0x0a,0x3c,0x74,0x72,0x3e,0x0d,0x0a,0x09,0x3c,0x74,0x64,0x3e,0x0d,0x0a,0x3c,
+0x21,0x2d,0x2d,0x5b,0x69,0x66,0x20,0x6c,0x74,0x65,0x20,0x49,0x45,0x20,0x39,0x20,
+0x5d,0x3e,0x0d,0x0a,0x09,0x53,0x6f,0x72,0x72,0x79,0x2c,0x20,0x49,0x45,0x3c,0x39,
+0x20,0x62,0x72,0x6f,0x77,0x73,0x65,0x72,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x64,
+0x6f,0x65,0x73,0x20,0x6e,0x6f,0x74,0x20,0x73,0x75,0x70,0x70,0x6f,0x72,0x74,0x20,
+0x53,0x56,0x47,0x0d,0x0a,0x3c,0x21,0x5b,0x65,0x6e,0x64,0x69,0x66,0x5d,0x2d,0x2d,
+0x3e,0x0d,0x0a,0x3c,0x21,0x2d,0x2d,0x5b,0x69,0x66,0x20,0x21,0x6c,0x74,0x65,0x20,
+0x49,0x45,0x20,0x39,0x5d,0x3e,0x20,0x2d,0x2d,0x3e,0x0d,0x0a,0x09,0x3c,0x69,0x6d,
+0x67,0x20,0x68,0x65,0x69,0x67,0x68,0x74,0x3d,0x22,0x34,0x30,0x30,0x22,0x20,0x73,
+0x72,0x63,0x3d,0x22,0x2e,0x2f,0x69,0x6d,0x67,0x2f,0x74,0x6f,0x61,0x73,0x74,0x65,
+0x72,0x2e,0x73,0x76,0x67,0x22,0x3e,0x0d,0x0a,0x3c,0x21,0x2d,0x2d,0x20,0x3c,0x21,
+0x5b,0x65,0x6e,0x64,0x69,0x66,0x5d,0x2d,0x2d,0x3e,0x0d,0x0a,0x0d,0x0a,0x09,0x3c,
+0x2f,0x74,0x64,0x3e,0x0d,0x0a,0x09,0x3c,0x74,0x64,0x3e,0x0d,0x0a,0x09,0x09,0x3c,
+0x64,0x69,0x76,0x20,0x63,0x6c,0x61,0x73,0x73,0x3d,0x22,0x72,0x64,0x69,0x76,0x22,
+0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x62,0x3e,0x44,0x65,0x76,0x69,0x63,0x65,0x20,
+0x73,0x74,0x61,0x74,0x65,0x3c,0x2f,0x62,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,
+0x09,0x09,0x3c,0x64,0x69,0x76,0x20,0x69,0x64,0x3d,0x22,0x64,0x65,0x76,0x73,0x74,
+0x61,0x74,0x65,0x22,0x3e,0x3c,0x2f,0x64,0x69,0x76,0x3e,0x3c,0x62,0x72,0x3e,0x0d,
+0x0a,0x09,0x09,0x09,0x3c,0x62,0x3e,0x44,0x65,0x76,0x69,0x63,0x65,0x20,0x74,0x69,
+0x6d,0x65,0x3c,0x2f,0x62,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,
+0x64,0x69,0x76,0x20,0x69,0x64,0x3d,0x22,0x73,0x79,0x73,0x74,0x69,0x63,0x6b,0x22,
+0x3e,0x3c,0x2f,0x64,0x69,0x76,0x3e,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,
+0x3c,0x62,0x3e,0x4d,0x61,0x69,0x6e,0x20,0x6c,0x6f,0x6f,0x70,0x3c,0x2f,0x62,0x3e,
+0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x64,0x69,0x76,0x20,0x69,0x64,
+0x3d,0x22,0x6c,0x6f,0x6f,0x70,0x22,0x3e,0x3c,0x2f,0x64,0x69,0x76,0x3e,0x3c,0x62,
+0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x62,0x3e,0x55,0x73,0x65,0x72,0x20,0x43,
+0x6f,0x6e,0x74,0x72,0x6f,0x6c,0x73,0x3c,0x2f,0x62,0x3e,0x3c,0x62,0x72,0x3e,0x0d,
+0x0a,0x09,0x09,0x09,0x3c,0x69,0x6e,0x70,0x75,0x74,0x20,0x69,0x64,0x3d,0x22,0x61,
+0x6c,0x70,0x68,0x61,0x22,0x20,0x74,0x79,0x70,0x65,0x3d,0x22,0x63,0x68,0x65,0x63,
 0x6b,0x62,0x6f,0x78,0x22,0x20,0x6f,0x6e,0x63,0x6c,0x69,0x63,0x6b,0x3d,0x22,0x63,
-0x74,0x6c,0x28,0x7b,0x63,0x3a,0x20,0x28,0x74,0x68,0x69,0x73,0x2e,0x63,0x68,0x65,
+0x74,0x6c,0x28,0x7b,0x61,0x3a,0x20,0x28,0x74,0x68,0x69,0x73,0x2e,0x63,0x68,0x65,
 0x63,0x6b,0x65,0x64,0x20,0x3f,0x20,0x31,0x20,0x3a,0x20,0x30,0x29,0x7d,0x29,0x22,
-0x3e,0x63,0x68,0x61,0x72,0x6c,0x69,0x65,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,
-0x3c,0x2f,0x64,0x69,0x76,0x3e,0x0d,0x0a,0x09,0x3c,0x2f,0x74,0x64,0x3e,0x0d,0x0a,
-0x3c,0x2f,0x74,0x72,0x3e,0x0d,0x0a,0x3c,0x2f,0x74,0x61,0x62,0x6c,0x65,0x3e,0x0d,
-0x0a,0x3c,0x2f,0x63,0x65,0x6e,0x74,0x65,0x72,0x3e,0x0d,0x0a,0x3c,0x2f,0x62,0x6f,
-0x64,0x79,0x3e,0x0d,0x0a,0x3c,0x2f,0x68,0x74,0x6d,0x6c,0x3e,0x0d,0x0a,};
+0x3e,0x61,0x6c,0x70,0x68,0x61,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,
+0x69,0x6e,0x70,0x75,0x74,0x20,0x69,0x64,0x3d,0x22,0x62,0x72,0x61,0x76,0x6f,0x22,
+0x20,0x74,0x79,0x70,0x65,0x3d,0x22,0x63,0x68,0x65,0x63,0x6b,0x62,0x6f,0x78,0x22,
+0x20,0x6f,0x6e,0x63,0x6c,0x69,0x63,0x6b,0x3d,0x22,0x63,0x74,0x6c,0x28,0x7b,0x62,
+0x3a,0x20,0x28,0x74,0x68,0x69,0x73,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,
+0x3f,0x20,0x31,0x20,0x3a,0x20,0x30,0x29,0x7d,0x29,0x22,0x3e,0x62,0x72,0x61,0x76,
+0x6f,0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x09,0x3c,0x69,0x6e,0x70,0x75,0x74,
+0x20,0x69,0x64,0x3d,0x22,0x63,0x68,0x61,0x72,0x6c,0x69,0x65,0x22,0x20,0x74,0x79,
+0x70,0x65,0x3d,0x22,0x63,0x68,0x65,0x63,0x6b,0x62,0x6f,0x78,0x22,0x20,0x6f,0x6e,
+0x63,0x6c,0x69,0x63,0x6b,0x3d,0x22,0x63,0x74,0x6c,0x28,0x7b,0x63,0x3a,0x20,0x28,
+0x74,0x68,0x69,0x73,0x2e,0x63,0x68,0x65,0x63,0x6b,0x65,0x64,0x20,0x3f,0x20,0x31,
+0x20,0x3a,0x20,0x30,0x29,0x7d,0x29,0x22,0x3e,0x63,0x68,0x61,0x72,0x6c,0x69,0x65,
+0x3c,0x62,0x72,0x3e,0x0d,0x0a,0x09,0x09,0x3c,0x2f,0x64,0x69,0x76,0x3e,0x0d,0x0a,
+0x09,0x3c,0x2f,0x74,0x64,0x3e,0x0d,0x0a,0x3c,0x2f,0x74,0x72,0x3e,0x0d,0x0a,0x3c,
+0x2f,0x74,0x61,0x62,0x6c,0x65,0x3e,0x0d,0x0a,0x3c,0x2f,0x63,0x65,0x6e,0x74,0x65,
+0x72,0x3e,0x0d,0x0a,0x3c,0x2f,0x62,0x6f,0x64,0x79,0x3e,0x0d,0x0a,0x3c,0x2f,0x68,
+0x74,0x6d,0x6c,0x3e,0x0d,0x0a,};
 
 static const unsigned int dummy_align__state_shtml = 3;
 static const unsigned char data__state_shtml[] = {
@@ -1016,14 +1027,18 @@ Pragma: no-cache
 0x30,0x38,0x20,0x31,0x34,0x3a,0x30,0x30,0x3a,0x30,0x30,0x20,0x47,0x4d,0x54,0x0d,
 0x0a,0x50,0x72,0x61,0x67,0x6d,0x61,0x3a,0x20,0x6e,0x6f,0x2d,0x63,0x61,0x63,0x68,
 0x65,0x0d,0x0a,0x0d,0x0a,
-/* raw file data (111 bytes) */
+/* raw file data (172 bytes) */
 0x7b,0x0d,0x0a,0x09,0x22,0x73,0x79,0x73,0x74,0x69,0x63,0x6b,0x22,0x3a,0x20,0x3c,
 0x21,0x2d,0x2d,0x23,0x73,0x79,0x73,0x74,0x69,0x63,0x6b,0x2d,0x2d,0x3e,0x2c,0x0d,
 0x0a,0x09,0x22,0x75,0x73,0x65,0x72,0x22,0x3a,0x20,0x7b,0x20,0x22,0x61,0x22,0x3a,
 0x20,0x3c,0x21,0x2d,0x2d,0x23,0x61,0x6c,0x70,0x68,0x61,0x2d,0x2d,0x3e,0x2c,0x20,
 0x22,0x62,0x22,0x3a,0x20,0x3c,0x21,0x2d,0x2d,0x23,0x62,0x72,0x61,0x76,0x6f,0x2d,
 0x2d,0x3e,0x2c,0x20,0x22,0x63,0x22,0x3a,0x20,0x3c,0x21,0x2d,0x2d,0x23,0x63,0x68,
-0x61,0x72,0x6c,0x69,0x65,0x2d,0x2d,0x3e,0x20,0x7d,0x0d,0x0a,0x7d,0x0d,0x0a,};
+0x61,0x72,0x6c,0x69,0x65,0x2d,0x2d,0x3e,0x20,0x7d,0x2c,0x0d,0x0a,0x09,0x22,0x6c,
+0x6f,0x6f,0x70,0x22,0x3a,0x20,0x7b,0x20,0x22,0x70,0x61,0x73,0x73,0x65,0x73,0x22,
+0x3a,0x20,0x3c,0x21,0x2d,0x2d,0x23,0x6c,0x6f,0x6f,0x70,0x73,0x2d,0x2d,0x3e,0x2c,
+0x20,0x22,0x69,0x64,0x6c,0x65,0x22,0x3a,0x20,0x3c,0x21,0x2d,0x2d,0x23,0x69,0x64,
+0x6c,0x65,0x2d,0x2d,0x3e,0x20,0x7d,0x0d,0x0a,0x7d,0x0d,0x0a,};
 
 static const unsigned int dummy_align__zepto_min_js = 4;
 static const unsigned char data__zepto_min_js[] = {
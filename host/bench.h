@@ -0,0 +1,87 @@
+/*
+    Timing for the benchmarks of the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The benchmarks of the host build time their kernels with bench_now(), which counts the host CPU's cycles
+(the time stamp counter) on x86, or else nanoseconds; BENCH_UNIT names which.
+They say how the code compares with what it replaced on the same machine; what the Cortex-M0 sees is another matter,
+as the host has caches, a wider bus and (unless left out) SIMD.
+
+bench_run() calls a kernel BENCH_CALLS times in a row, BENCH_ROUNDS times over, and returns the best round's average;
+the best, rather than the mean, leaves out the rounds that were interrupted or found the caches cold.
+*/
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define BENCH_CALLS   1000
+#define BENCH_ROUNDS  20
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT    "cycles"
+
+static inline uint64_t bench_now(void)
+{
+  return __rdtsc();
+}
+#else
+#define BENCH_UNIT    "ns"
+
+static inline uint64_t bench_now(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+#endif
+
+/* results are added to this, so that the compiler can't leave out the work that made them */
+extern volatile uint32_t bench_sink;
+
+static inline double bench_run(void (*kernel)(void *context), void *context)
+{
+  uint64_t start, best = UINT64_MAX;
+  unsigned round, call;
+
+  for (round = 0; round < BENCH_ROUNDS; round++)
+  {
+    start = bench_now();
+    for (call = 0; call < BENCH_CALLS; call++)
+      kernel(context);
+    start = bench_now() - start;
+    if (start < best)
+      best = start;
+  }
+
+  return (double)best / BENCH_CALLS;
+}
+
+#endif /* __BENCH_H */
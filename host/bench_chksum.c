@@ -0,0 +1,170 @@
+/*
+    Benchmark of the Internet checksum routines against lwIP's own
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Before and after for the checksum routines, on the lengths that the firmware sums most:
+an IP header (20), a USB packet's worth (64), a DHCP reply (300), a default TCP MSS (536) and a full one (1460).
+
+  sum        lwIP's algorithm 2 (as it was) against fast_chksum()
+  copy+sum   copying then summing (as tcp_write() and the responders did), with each, against fast_chksum_copy()
+  pbuf       pbuf_take() then summing the chain, with each, against pbuf_take_chksum(), into a chain of two pbufs
+             (which copies with lwIP's LWIP_CHKSUM_COPY, as lwipopts.h leaves it; see chksum.c)
+
+The figures are per call (see bench.h for the unit); the Makefile builds this with and without chksum.c's SSE2 path.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "refchksum.h"
+#include "lwip/pbuf.h"
+#include "chksum.h"
+
+#define MAX_LEN  1460
+
+struct case_data
+{
+  uint8_t *src, *dst;
+  unsigned len;
+  struct pbuf *chain;
+};
+
+volatile uint32_t bench_sink;
+
+static uint8_t src[MAX_LEN] __attribute__ ((aligned (16)));
+static uint8_t dst[MAX_LEN] __attribute__ ((aligned (16)));
+static uint8_t payloads[2][MAX_LEN] __attribute__ ((aligned (16)));
+static struct pbuf chain[2];
+
+static void sum_ref(void *context)
+{
+  struct case_data *c = context;
+
+  bench_sink += lwip_standard_chksum(c->src, c->len);
+}
+
+static void sum_fast(void *context)
+{
+  struct case_data *c = context;
+
+  bench_sink += fast_chksum(c->src, c->len);
+}
+
+static void copy_sum_ref(void *context)
+{
+  struct case_data *c = context;
+
+  memcpy(c->dst, c->src, c->len);
+  bench_sink += lwip_standard_chksum(c->dst, c->len);
+}
+
+static void copy_sum_fast(void *context)
+{
+  struct case_data *c = context;
+
+  memcpy(c->dst, c->src, c->len);
+  bench_sink += fast_chksum(c->dst, c->len);
+}
+
+static void copy_fused(void *context)
+{
+  struct case_data *c = context;
+
+  bench_sink += fast_chksum_copy(c->dst, c->src, c->len);
+}
+
+/* pbuf_take(), then the sum of each pbuf as inet_chksum_pseudo() would take it */
+static void take_sum(struct case_data *c, u16_t (*chksum)(void *dataptr, int len))
+{
+  struct pbuf *q;
+  uint32_t acc = 0;
+
+  pbuf_take(c->chain, c->src, c->len);
+  for (q = c->chain; q; q = q->next)
+    acc += chksum(q->payload, q->len);
+  bench_sink += acc;
+}
+
+static u16_t chksum_ref(void *dataptr, int len)
+{
+  return lwip_standard_chksum(dataptr, len);
+}
+
+static void take_sum_ref(void *context)
+{
+  take_sum(context, chksum_ref);
+}
+
+static void take_sum_fast(void *context)
+{
+  take_sum(context, fast_chksum);
+}
+
+static void take_fused(void *context)
+{
+  struct case_data *c = context;
+  u16_t sum = 0;
+
+  pbuf_take_chksum(c->chain, c->src, c->len, 0, &sum);
+  bench_sink += sum;
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned lengths[] = { 20, 64, 300, 536, 1460 };
+  struct case_data c;
+  unsigned i;
+
+  for (i = 0; i < sizeof(src); i++)
+    src[i] = (uint8_t)(i * 13 + 7);
+
+  c.src = src;
+  c.dst = dst;
+  c.chain = chain;
+
+  printf("%s: %s per call\n", argv[0], BENCH_UNIT);
+  printf("%6s | %8s %8s | %8s %8s %8s | %8s %8s %8s\n", "bytes", "alg 2", "fast", "cp+alg2", "cp+fast", "fused", "tk+alg2", "tk+fast", "fused");
+
+  for (i = 0; i < sizeof(lengths) / sizeof(*lengths); i++)
+  {
+    c.len = lengths[i];
+
+    /* the data split unevenly (and at an odd boundary) over two pbufs, as a header pbuf and a pool pbuf might have it */
+    chain[0].payload = payloads[0];
+    chain[0].len = c.len / 3 | 1;
+    chain[1].payload = payloads[1];
+    chain[1].len = c.len - chain[0].len;
+    chain[0].next = &chain[1];
+    chain[1].next = NULL;
+    chain[1].tot_len = chain[1].len;
+    chain[0].tot_len = c.len;
+
+    printf("%6u | %8.1f %8.1f | %8.1f %8.1f %8.1f | %8.1f %8.1f %8.1f\n", c.len,
+      bench_run(sum_ref, &c), bench_run(sum_fast, &c),
+      bench_run(copy_sum_ref, &c), bench_run(copy_sum_fast, &c), bench_run(copy_fused, &c),
+      bench_run(take_sum_ref, &c), bench_run(take_sum_fast, &c), bench_run(take_fused, &c));
+  }
+
+  return 0;
+}
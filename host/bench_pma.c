@@ -0,0 +1,113 @@
+/*
+    Benchmark of the PMA copy loops of the HAL against ST's
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Before and after for the PMA copy loops: ST's (refpma.h) against PCD_WritePMA() and PCD_ReadPMA() as they are,
+on the simulated PMA of the host build, for a CDC notification (8 or 16), a full-speed bulk packet (64),
+and the odd lengths of a frame's last packet; the user buffer is word aligned, then at 2 and then at 1 past.
+The host's PMA is ordinary memory; on the Cortex-M0 every access to it is a halfword on the APB, which the host
+can't show, so what this says is how many instructions the loops spend around those accesses.
+
+The figures are per call (see bench.h for the unit).
+*/
+
+#include <stdio.h>
+#include "bench.h"
+#include "refpma.h"
+
+#define MAX_LEN     64
+#define PMA_OFFSET  0x40
+
+struct case_data
+{
+  uint8_t *user;
+  unsigned len;
+};
+
+volatile uint32_t bench_sink;
+
+static uint8_t user[4 + MAX_LEN + 1] __attribute__ ((aligned (4)));
+
+static void write_ref(void *context)
+{
+  struct case_data *c = context;
+
+  ref_write_pma(USB, c->user, PMA_OFFSET, c->len);
+  bench_sink += host_pma[PMA_OFFSET / 2];
+}
+
+static void write_new(void *context)
+{
+  struct case_data *c = context;
+
+  PCD_WritePMA(USB, c->user, PMA_OFFSET, c->len);
+  bench_sink += host_pma[PMA_OFFSET / 2];
+}
+
+static void read_ref(void *context)
+{
+  struct case_data *c = context;
+
+  ref_read_pma(USB, c->user, PMA_OFFSET, c->len);
+  bench_sink += c->user[0];
+}
+
+static void read_new(void *context)
+{
+  struct case_data *c = context;
+
+  PCD_ReadPMA(USB, c->user, PMA_OFFSET, c->len);
+  bench_sink += c->user[0];
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned lengths[] = { 8, 16, 63, 64 };
+  static const unsigned offsets[] = { 0, 2, 1 };
+  struct case_data c;
+  unsigned i, j;
+
+  for (i = 0; i < sizeof(user); i++)
+    user[i] = (uint8_t)(i * 13 + 7);
+  for (i = 0; i < sizeof(host_pma) / sizeof(*host_pma); i++)
+    host_pma[i] = (uint16_t)(i * 0x0d07);
+
+  printf("%s: %s per call\n", argv[0], BENCH_UNIT);
+  printf("%6s %6s | %8s %8s | %8s %8s\n", "bytes", "offset", "wr ST", "wr new", "rd ST", "rd new");
+
+  for (i = 0; i < sizeof(lengths) / sizeof(*lengths); i++)
+  {
+    for (j = 0; j < sizeof(offsets) / sizeof(*offsets); j++)
+    {
+      c.user = user + offsets[j];
+      c.len = lengths[i];
+
+      printf("%6u %6u | %8.1f %8.1f | %8.1f %8.1f\n", c.len, offsets[j],
+        bench_run(write_ref, &c), bench_run(write_new, &c),
+        bench_run(read_ref, &c), bench_run(read_new, &c));
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+/*
+    Benchmark of the receive ring of main.c at several depths, in the simulator
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Frames per second from the host at a given depth of main.c's receive ring (RX_RING_SIZE, which the Makefile
+builds this with at several): the whole firmware runs in the simulator (see simcpu.c), and the scripted host
+(usbhost.c) sends it frames back to back, as fast as the device will take them.
+
+The simulated firmware is otherwise infinitely fast, which no ring could help; so, here its main loop is given
+a cost (usbhost_cpu_time): CPU_WAKE_BYTES each time it runs, and some number of byte times for each frame that it
+takes off the ring (one column for each of frame_costs[]). Byte times are the bus's, of which a 48 MHz Cortex-M0
+has 32 cycles; the costs are rough guesses at the loop's overhead and at what lwIP spends on a frame, not measurements.
+Whilst the main loop is busy, the USB ISR carries on filling the ring; once it is full, the device NAKs.
+
+Each frame in the ring holds a PBUF_POOL pbuf, and usbd_ecm.c holds one more for the frame to come, so the firmware's
+PBUF_POOL_SIZE of 3 lets no more than 2 frames wait whatever the depth; the Makefile gives each depth a pool to match.
+
+The frames are broadcasts (which the packet filter passes) with an IPv4 header that lwIP drops as malformed,
+so that nothing is sent back; the figures are frames per simulated second, and don't depend on the host's speed.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "simcpu.h"
+#include "usbsim.h"
+#include "usbhost.h"
+#include "usbd_conf.h"
+#include "usbd_ecm.h"
+#include "link.h"
+
+#define CPU_WAKE_BYTES   48
+
+/* frames sent at each length and cost */
+#define FRAMES           1000
+
+/* byte times of the full-speed bus in a second */
+#define BUS_BYTES        1500000
+
+static struct usbhost_ecm ecm;
+static uint8_t frame[1514];
+static uint32_t drained;
+static unsigned frame_cost;
+
+/* frames that service_traffic() has taken off the ring since start-up */
+static uint32_t frames_drained(void)
+{
+  struct ecm_stats stats;
+  struct rx_ring_stats ring;
+
+  usb_ecm_get_stats(0, &stats);
+  rx_ring_get_stats(0, &ring);
+  return stats.frames_in - ring.occupancy;
+}
+
+static unsigned cpu_time(void)
+{
+  uint32_t now = frames_drained();
+  unsigned cost = CPU_WAKE_BYTES + frame_cost * (now - drained);
+
+  drained = now;
+  return cost;
+}
+
+static double frames_per_second(unsigned len)
+{
+  uint64_t start;
+  unsigned i;
+
+  memset(frame, 0xFF, 6);
+  memcpy(frame + 6, ecm.mac, 6);
+  frame[12] = ETHTYPE_IP >> 8;
+  frame[13] = ETHTYPE_IP & 0xFF;
+  memset(frame + 14, 0, len - 14);
+
+  start = usbhost_bytes;
+  for (i = 0; i < FRAMES; i++)
+  {
+    if (!usbhost_send(&ecm, frame, len))
+      return 0;
+  }
+
+  return (double)FRAMES * BUS_BYTES / (usbhost_bytes - start);
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned lengths[] = { 60, 300, 1514 };
+  static const unsigned frame_costs[] = { 32, 96, 256 };
+  struct rx_ring_stats ring;
+  unsigned i, j;
+
+  sim_start();
+
+  if (!usbhost_enumerate(&ecm))
+  {
+    fprintf(stderr, "%s: the device didn't enumerate\n", argv[0]);
+    return 1;
+  }
+  usbhost_wait(100);
+
+  drained = frames_drained();
+  usbhost_cpu_time = cpu_time;
+
+  printf("%s: RX_RING_SIZE %u, PBUF_POOL_SIZE %u; frames/s (simulated) at a cost per frame (byte times)\n",
+    argv[0], RX_RING_SIZE, PBUF_POOL_SIZE);
+  printf("%6s |", "bytes");
+  for (j = 0; j < sizeof(frame_costs) / sizeof(*frame_costs); j++)
+    printf(" %8u", frame_costs[j]);
+  printf("\n");
+
+  for (i = 0; i < sizeof(lengths) / sizeof(*lengths); i++)
+  {
+    printf("%6u |", lengths[i]);
+    for (j = 0; j < sizeof(frame_costs) / sizeof(*frame_costs); j++)
+    {
+      frame_cost = frame_costs[j];
+      printf(" %8.0f", frames_per_second(lengths[i]));
+
+      /* let the ring drain before the next run */
+      usbhost_wait(10);
+    }
+    printf("\n");
+  }
+
+  rx_ring_get_stats(0, &ring);
+  printf("ring: %u high water, %u overflows\n", ring.high_water, (unsigned)ring.overflows);
+
+  return (usbsim_errors || usbhost_errors) ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/*
+    Core, clock and HAL stand-ins for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+The host build links this in place of ST's stm32f0xx_hal.c, stm32f0xx_hal_cortex.c, stm32f0xx_hal_gpio.c,
+stm32f0xx_hal_rcc.c, stm32f0xx_hal_helper.c and system_stm32f0xx.c.
+The peripherals declared in stm32f0xx.h are plain memory, defined here; SysTick only counts the milliseconds that
+the host build delivers by calling SysTick_Handler() (see time.c), so VAL stays at LOAD and time advances a whole millisecond at a time.
+The clock, GPIO and NVIC setup has nothing to do on the host, except that the NVIC remembers which interrupts are enabled.
+*/
+
+#include "stm32f0xx_hal.h"
+#include "time.h"
+
+SysTick_Type host_systick;
+SCB_Type host_scb;
+RCC_TypeDef host_rcc;
+GPIO_TypeDef host_gpioa;
+USB_TypeDef host_usb;
+uint16_t host_pma[USB_PMA_SIZE / 2] __attribute__ ((aligned (8)));
+
+volatile uint32_t host_primask;
+
+uint32_t SystemCoreClock = 48000000;
+uint32_t host_device_id2 = 0x12345678;
+
+static uint32_t nvic_enabled;
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+  if ((ticks - 1) > SysTick_LOAD_RELOAD_Msk)
+    return 1;
+
+  SysTick->LOAD = ticks - 1;
+  SysTick->VAL = SysTick->LOAD;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+  return 0;
+}
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+  return HAL_OK;
+}
+
+void SystemClock_Config(void)
+{
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return mtime();
+}
+
+/* time only passes whilst the host build is asleep, so this sleeps rather than spins */
+void HAL_Delay(__IO uint32_t Delay)
+{
+  uint32_t start = HAL_GetTick();
+
+  while ((HAL_GetTick() - start) < Delay)
+    __WFI();
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+  (void)GPIOx;
+  (void)GPIO_Init;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  if (IRQn >= 0)
+    nvic_enabled |= 1UL << IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  if (IRQn >= 0)
+    nvic_enabled &= ~(1UL << IRQn);
+}
+
+int host_irq_enabled(IRQn_Type IRQn)
+{
+  return (IRQn >= 0) && (nvic_enabled & (1UL << IRQn));
+}
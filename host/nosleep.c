@@ -0,0 +1,39 @@
+/*
+    __WFI() for the host programs without the firmware's main loop
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+__WFI() (host_wfi()) for the programs of the host build that link parts of the firmware without its main loop,
+neither over TAP (taphost.c) nor in the simulator (simcpu.c): nothing could wake them, so it's a bug for them to sleep.
+They link hostcpu.c (and so time.c) only for the simulated peripherals.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "stm32f0xx.h"
+
+void host_wfi(void)
+{
+  fprintf(stderr, "nosleep: __WFI() with nothing to wake the CPU\n");
+  abort();
+}
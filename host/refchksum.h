@@ -0,0 +1,44 @@
+/*
+    lwIP's checksum (algorithm 2), as the reference for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The reference for the tests and benchmarks of the checksum routines: lwIP's own algorithm 2 from inet_chksum.c,
+as lwIP builds it when lwipopts.h leaves LWIP_CHKSUM alone. The file is compiled into whichever includes this one
+(once per program), its external functions renamed with ref_ so as not to clash with the lwIP that is linked in;
+lwip_standard_chksum() itself is static.
+*/
+
+#ifndef __REFCHKSUM_H
+#define __REFCHKSUM_H
+
+#define LWIP_CHKSUM                  lwip_standard_chksum
+#define LWIP_CHKSUM_ALGORITHM        2
+#define inet_chksum                  ref_inet_chksum
+#define inet_chksum_pbuf             ref_inet_chksum_pbuf
+#define inet_chksum_pseudo           ref_inet_chksum_pseudo
+#define inet_chksum_pseudo_partial   ref_inet_chksum_pseudo_partial
+#define lwip_chksum_copy             ref_lwip_chksum_copy
+#include "../lwip-1.4.1/src/core/ipv4/inet_chksum.c"
+
+#endif /* __REFCHKSUM_H */
@@ -0,0 +1,74 @@
+/*
+    ST's PMA copy loops, as the reference for the host build's test and benchmark
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The reference for the test and benchmark of the PMA copy loops (PCD_WritePMA() and PCD_ReadPMA()):
+the loops as ST's HAL had them, but for the PMA address, which they reckoned as a 32-bit integer; here it is PCD_PMA(),
+which the host build points at its simulated PMA. ST's PCD_ReadPMA() stored halfwords at whatever address it was given,
+which faults on the Cortex-M0 (and is undefined in C) for an odd one; here, memcpy() stores the same two bytes.
+Both copy whole halfwords, so an odd length takes (or leaves) one byte more than it names.
+*/
+
+#ifndef __REFPMA_H
+#define __REFPMA_H
+
+#include <string.h>
+#include "stm32f0xx_hal.h"
+
+/* not declared by stm32f0xx_hal_pcd.h */
+void PCD_WritePMA(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes);
+void PCD_ReadPMA(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes);
+
+static void ref_write_pma(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
+{
+  uint32_t n = (wNBytes + 1) >> 1;
+  uint32_t i;
+  uint16_t temp1, temp2;
+  uint16_t *pdwVal;
+  pdwVal = PCD_PMA(USBx, wPMABufAddr);
+
+  for (i = n; i != 0; i--)
+  {
+    temp1 = (uint16_t) * pbUsrBuf;
+    pbUsrBuf++;
+    temp2 = temp1 | (uint16_t) * pbUsrBuf << 8;
+    *pdwVal++ = temp2;
+    pbUsrBuf++;
+  }
+}
+
+static void ref_read_pma(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
+{
+  uint32_t n = (wNBytes + 1) >> 1;
+  uint32_t i;
+  uint16_t *pdwVal;
+  pdwVal = PCD_PMA(USBx, wPMABufAddr);
+  for (i = n; i != 0; i--)
+  {
+    memcpy(pbUsrBuf, pdwVal++, 2);
+    pbUsrBuf += 2;
+  }
+}
+
+#endif /* __REFPMA_H */
@@ -0,0 +1,106 @@
+/*
+    Simulated CPU of the STM32F072, for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+firmware_main() gets its own stack and ucontext; sim_start() and sim_resume() switch to it, and host_wfi() (i.e. __WFI()) switches back.
+So, the firmware only ever stops in WFI, and only ever runs when the host lets it.
+The interrupt handlers are called by the host, on its own stack, whilst the firmware is asleep; as on the real core,
+they run even if the firmware went to sleep with interrupts disabled (which main.c does), as it would handle them
+as soon as it re-enabled them, before checking for events again.
+Interrupts never arrive anywhere else in the main loop, so the simulator is no help in finding races with the ISR.
+
+Time is counted in USB frames: sim_millisecond() gives a SOF (if the firmware has enabled its interrupt) and a SysTick,
+after which the host resumes the firmware as it would after any other interrupt.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "simcpu.h"
+#include "usbsim.h"
+#include "stm32f0xx_it.h"
+
+/* more than enough for main.c and lwIP; the firmware gets by with a few kB */
+#define FIRMWARE_STACK_SIZE (256 * 1024)
+
+/* a handler that fails to clear its interrupt would otherwise hang the simulator */
+#define IRQ_LIMIT 64
+
+static ucontext_t host_context, firmware_context;
+static uint64_t firmware_stack[FIRMWARE_STACK_SIZE / sizeof(uint64_t)];
+
+static void firmware_entry(void)
+{
+  firmware_main();
+
+  fprintf(stderr, "simcpu: the firmware's main() returned\n");
+  exit(EXIT_FAILURE);
+}
+
+void host_wfi(void)
+{
+  swapcontext(&firmware_context, &host_context);
+}
+
+void sim_start(void)
+{
+  getcontext(&firmware_context);
+  firmware_context.uc_stack.ss_sp = firmware_stack;
+  firmware_context.uc_stack.ss_size = sizeof(firmware_stack);
+  firmware_context.uc_link = NULL;
+  makecontext(&firmware_context, firmware_entry, 0);
+
+  sim_resume();
+}
+
+void sim_resume(void)
+{
+  swapcontext(&host_context, &firmware_context);
+}
+
+void sim_irq(void)
+{
+  unsigned count;
+
+  for (count = 0; host_irq_enabled(USB_IRQn) && usbsim_irq_pending(); count++)
+  {
+    if (count == IRQ_LIMIT)
+    {
+      fprintf(stderr, "simcpu: USB_IRQHandler() leaves its interrupt pending (ISTR 0x%04X)\n", host_usb.ISTR);
+      exit(EXIT_FAILURE);
+    }
+    USB_IRQHandler();
+  }
+}
+
+void sim_millisecond(void)
+{
+  usbsim_sof();
+  sim_irq();
+
+  if (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk)
+    SysTick_Handler();
+}
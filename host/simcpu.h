@@ -0,0 +1,51 @@
+/*
+    Simulated CPU of the STM32F072, for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The simulator runs the firmware's main() (built as firmware_main()) as a coroutine of the scripted USB host (see usbhost.c).
+The firmware runs until it sleeps in __WFI(), which hands back to the host; the host then puts transactions on the bus,
+runs the interrupt handlers that they call for (as the core would wake from WFI to do), and resumes the firmware.
+*/
+
+#ifndef __SIMCPU_H
+#define __SIMCPU_H
+
+#include <stdint.h>
+
+/* main() of the firmware (main.c), renamed by the build */
+int firmware_main(void);
+
+/* start the firmware, and run it until it first sleeps */
+void sim_start(void);
+
+/* run USB_IRQHandler() for as long as the peripheral asks for it */
+void sim_irq(void);
+
+/* run the firmware until it next sleeps */
+void sim_resume(void);
+
+/* one millisecond (i.e. one USB frame) passes: a SOF, and a SysTick; the caller then resumes the firmware, which either may wake */
+void sim_millisecond(void);
+
+#endif /* __SIMCPU_H */
@@ -0,0 +1,286 @@
+/*
+    Stand-in for the STM32F0xx device header, for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The firmware sources (and ST's HAL headers) are compiled unchanged for the host, with this in place of the CMSIS device header.
+Only what they use is here: the register layouts and bits of the core (SysTick, SCB), RCC, GPIO and the USB peripheral,
+and the Cortex-M0 intrinsics.
+
+The peripherals are plain memory (see hostcpu.c), so a register reads back what was last written to it;
+hostcpu.c and (for the USB peripheral) the model in usbsim.c stand in for the hardware behind them.
+PRIMASK is a variable, and __WFI() calls host_wfi(), which is where the host build's "interrupts" are delivered:
+taphost.c polls the TAP interfaces there, and the simulator (simcpu.c) hands over to the scripted USB host.
+*/
+
+#ifndef __HOST_STM32F0XX_H
+#define __HOST_STM32F0XX_H
+
+#include <stdint.h>
+
+#define STM32F072xB
+
+#define __IO volatile
+#define __I  volatile const
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { ERROR = 0, SUCCESS = !ERROR } ErrorStatus;
+#define IS_FUNCTIONAL_STATE(STATE) (((STATE) == DISABLE) || ((STATE) == ENABLE))
+
+#define SET_BIT(REG, BIT)     ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)   ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)    ((REG) & (BIT))
+#define CLEAR_REG(REG)        ((REG) = (0x0))
+#define WRITE_REG(REG, VAL)   ((REG) = (VAL))
+#define READ_REG(REG)         ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)  WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+typedef enum
+{
+  NonMaskableInt_IRQn = -14,
+  HardFault_IRQn      = -13,
+  SVC_IRQn            = -5,
+  PendSV_IRQn         = -2,
+  SysTick_IRQn        = -1,
+  USB_IRQn            = 31,
+} IRQn_Type;
+
+/* core */
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t LOAD;
+  __IO uint32_t VAL;
+  __I  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1)
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0)
+#define SysTick_LOAD_RELOAD_Msk     (0xFFFFFFUL)
+
+typedef struct
+{
+  __I  uint32_t CPUID;
+  __IO uint32_t ICSR;
+  uint32_t RESERVED0;
+  __IO uint32_t AIRCR;
+  __IO uint32_t SCR;
+  __IO uint32_t CCR;
+} SCB_Type;
+
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26)
+#define SCB_SCR_SEVONPEND_Msk       (1UL << 4)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+
+/* RCC and GPIO (only ever written, by HAL_PCD_MspInit()) */
+
+typedef struct
+{
+  __IO uint32_t CR;
+  __IO uint32_t CFGR;
+  __IO uint32_t CIR;
+  __IO uint32_t APB2RSTR;
+  __IO uint32_t APB1RSTR;
+  __IO uint32_t AHBENR;
+  __IO uint32_t APB2ENR;
+  __IO uint32_t APB1ENR;
+  __IO uint32_t BDCR;
+  __IO uint32_t CSR;
+  __IO uint32_t AHBRSTR;
+  __IO uint32_t CFGR2;
+  __IO uint32_t CFGR3;
+  __IO uint32_t CR2;
+} RCC_TypeDef;
+
+#define RCC_AHBENR_GPIOAEN          (1UL << 17)
+#define RCC_APB1ENR_USBEN           (1UL << 23)
+
+typedef struct
+{
+  __IO uint32_t MODER;
+  __IO uint32_t OTYPER;
+  __IO uint32_t OSPEEDR;
+  __IO uint32_t PUPDR;
+  __IO uint32_t IDR;
+  __IO uint32_t ODR;
+  __IO uint32_t BSRR;
+  __IO uint32_t LCKR;
+  __IO uint32_t AFR[2];
+  __IO uint32_t BRR;
+} GPIO_TypeDef;
+
+/* USB full-speed device peripheral; each 16-bit register sits in a 32-bit slot */
+
+typedef struct
+{
+  __IO uint16_t EP0R;  uint16_t RESERVED0;
+  __IO uint16_t EP1R;  uint16_t RESERVED1;
+  __IO uint16_t EP2R;  uint16_t RESERVED2;
+  __IO uint16_t EP3R;  uint16_t RESERVED3;
+  __IO uint16_t EP4R;  uint16_t RESERVED4;
+  __IO uint16_t EP5R;  uint16_t RESERVED5;
+  __IO uint16_t EP6R;  uint16_t RESERVED6;
+  __IO uint16_t EP7R;  uint16_t RESERVED7[17];
+  __IO uint16_t CNTR;  uint16_t RESERVED8;
+  __IO uint16_t ISTR;  uint16_t RESERVED9;
+  __IO uint16_t FNR;   uint16_t RESERVEDA;
+  __IO uint16_t DADDR; uint16_t RESERVEDB;
+  __IO uint16_t BTABLE; uint16_t RESERVEDC;
+  __IO uint16_t LPMCSR; uint16_t RESERVEDD;
+  __IO uint16_t BCDR;  uint16_t RESERVEDE;
+} USB_TypeDef;
+
+#define USB_PMAADDR                 0x40006000
+#define USB_PMA_SIZE                1024
+
+#define USB_CNTR_CTRM               0x8000
+#define USB_CNTR_PMAOVRM            0x4000
+#define USB_CNTR_ERRM               0x2000
+#define USB_CNTR_WKUPM              0x1000
+#define USB_CNTR_SUSPM              0x0800
+#define USB_CNTR_RESETM             0x0400
+#define USB_CNTR_SOFM               0x0200
+#define USB_CNTR_ESOFM              0x0100
+#define USB_CNTR_L1REQM             0x0080
+#define USB_CNTR_L1RESUME           0x0020
+#define USB_CNTR_RESUME             0x0010
+#define USB_CNTR_FSUSP              0x0008
+#define USB_CNTR_LPMODE             0x0004
+#define USB_CNTR_PDWN               0x0002
+#define USB_CNTR_FRES               0x0001
+
+#define USB_ISTR_CTR                0x8000
+#define USB_ISTR_PMAOVR             0x4000
+#define USB_ISTR_ERR                0x2000
+#define USB_ISTR_WKUP               0x1000
+#define USB_ISTR_SUSP               0x0800
+#define USB_ISTR_RESET              0x0400
+#define USB_ISTR_SOF                0x0200
+#define USB_ISTR_ESOF               0x0100
+#define USB_ISTR_L1REQ              0x0080
+#define USB_ISTR_DIR                0x0010
+#define USB_ISTR_EP_ID              0x000F
+
+#define USB_FNR_RXDP                0x8000
+#define USB_FNR_RXDM                0x4000
+#define USB_FNR_LCK                 0x2000
+#define USB_FNR_LSOF                0x1800
+#define USB_FNR_FN                  0x07FF
+
+#define USB_DADDR_EF                0x80
+#define USB_DADDR_ADD               0x7F
+
+#define USB_BCDR_DPPU               0x8000
+
+#define USB_EP_CTR_RX               0x8000
+#define USB_EP_DTOG_RX              0x4000
+#define USB_EPRX_STAT               0x3000
+#define USB_EP_SETUP                0x0800
+#define USB_EP_T_FIELD              0x0600
+#define USB_EP_KIND                 0x0100
+#define USB_EP_CTR_TX               0x0080
+#define USB_EP_DTOG_TX              0x0040
+#define USB_EPTX_STAT               0x0030
+#define USB_EPADDR_FIELD            0x000F
+
+#define USB_EPREG_MASK              (USB_EP_CTR_RX | USB_EP_SETUP | USB_EP_T_FIELD | USB_EP_KIND | USB_EP_CTR_TX | USB_EPADDR_FIELD)
+
+#define USB_EP_TYPE_MASK            0x0600
+#define USB_EP_BULK                 0x0000
+#define USB_EP_CONTROL              0x0200
+#define USB_EP_ISOCHRONOUS          0x0400
+#define USB_EP_INTERRUPT            0x0600
+#define USB_EP_T_MASK               (~USB_EP_T_FIELD & USB_EPREG_MASK)
+#define USB_EPKIND_MASK             (~USB_EP_KIND & USB_EPREG_MASK)
+
+#define USB_EP_TX_DIS               0x0000
+#define USB_EP_TX_STALL             0x0010
+#define USB_EP_TX_NAK               0x0020
+#define USB_EP_TX_VALID             0x0030
+#define USB_EPTX_DTOG1              0x0010
+#define USB_EPTX_DTOG2              0x0020
+#define USB_EPTX_DTOGMASK           (USB_EPTX_STAT | USB_EPREG_MASK)
+
+#define USB_EP_RX_DIS               0x0000
+#define USB_EP_RX_STALL             0x1000
+#define USB_EP_RX_NAK               0x2000
+#define USB_EP_RX_VALID             0x3000
+#define USB_EPRX_DTOG1              0x1000
+#define USB_EPRX_DTOG2              0x2000
+#define USB_EPRX_DTOGMASK           (USB_EPRX_STAT | USB_EPREG_MASK)
+
+/* the peripherals (see hostcpu.c) */
+
+extern SysTick_Type host_systick;
+extern SCB_Type host_scb;
+extern RCC_TypeDef host_rcc;
+extern GPIO_TypeDef host_gpioa;
+extern USB_TypeDef host_usb;
+
+#define SysTick   (&host_systick)
+#define SCB       (&host_scb)
+#define RCC       (&host_rcc)
+#define GPIOA     (&host_gpioa)
+#define USB       (&host_usb)
+
+/* the EPnR registers toggle (or clear) the bits that are written as 1 (or 0), which plain memory can't, so their writes go to the model */
+void usbsim_write_epr(USB_TypeDef *USBx, unsigned reg, uint16_t value);
+#define PCD_SET_ENDPOINT(USBx, bEpNum, wRegValue) usbsim_write_epr((USBx), (bEpNum), (uint16_t)(wRegValue))
+
+/* the PMA is a separate array (rather than following the registers), so that it can be aligned like the real one */
+extern uint16_t host_pma[USB_PMA_SIZE / 2];
+#define PCD_PMA_BASE(USBx) ((uint8_t *)host_pma)
+
+extern uint32_t SystemCoreClock;
+
+/* the second word of the device's unique ID, from which usbd_desc.c makes the serial number (and MAC address strings) */
+extern uint32_t host_device_id2;
+#define DEVICE_ID2 host_device_id2
+
+uint32_t SysTick_Config(uint32_t ticks);
+
+/* whether HAL_NVIC_EnableIRQ() has enabled an interrupt */
+int host_irq_enabled(IRQn_Type IRQn);
+
+/* intrinsics */
+
+extern volatile uint32_t host_primask;
+
+/* sleep until an interrupt; provided by the host build's main (taphost.c, or the simulator's simcpu.c) */
+void host_wfi(void);
+
+static inline void __disable_irq(void) { host_primask = 1; __asm__ volatile ("" ::: "memory"); }
+static inline void __enable_irq(void) { __asm__ volatile ("" ::: "memory"); host_primask = 0; }
+static inline uint32_t __get_PRIMASK(void) { return host_primask; }
+static inline void __set_PRIMASK(uint32_t priMask) { host_primask = priMask; __asm__ volatile ("" ::: "memory"); }
+static inline void __WFI(void) { host_wfi(); }
+static inline void __DSB(void) { __asm__ volatile ("" ::: "memory"); }
+static inline void __ISB(void) { __asm__ volatile ("" ::: "memory"); }
+static inline void __DMB(void) { __asm__ volatile ("" ::: "memory"); }
+static inline void __NOP(void) { }
+
+#endif /* __HOST_STM32F0XX_H */
@@ -0,0 +1,72 @@
+/*
+    Sleeping and timekeeping for the Linux host build over TAP interfaces
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+In the TAP build (LINK_TAP; see link.h and taplink.c), main.c's main() is the process's main(), and runs unchanged.
+Its loop sleeps in __WFI(), which comes here: host_wfi() waits in link_poll() for frames from the TAP interfaces
+(link_poll() offers them to link_recv_callback(), which posts EVENT_USB just as it does from the USB interrupt),
+but for no longer than until the soonest stmr timer is due (see next_deadline()).
+It then calls SysTick_Handler() once for each millisecond of CLOCK_MONOTONIC that has passed, which posts EVENT_TICK once a timer is due.
+So, the process sleeps in poll() whenever it has nothing to do, just as the firmware sleeps in WFI.
+*/
+
+#include <time.h>
+#include "link.h"
+#include "time.h"
+#include "stm32f0xx_it.h"
+
+/* milliseconds already delivered to SysTick_Handler() */
+static uint64_t tick_ms;
+
+static uint64_t clock_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void host_wfi(void)
+{
+  uint32_t deadline;
+  int32_t wait;
+  int timeout = -1;
+  uint64_t now;
+
+  if (!tick_ms)
+    tick_ms = clock_ms();
+
+  if (next_deadline(&deadline))
+  {
+    wait = (int32_t)(deadline - mtime());
+    timeout = (wait > 0) ? wait : 0;
+  }
+
+  link_poll(timeout);
+
+  for (now = clock_ms(); tick_ms < now; tick_ms++)
+    SysTick_Handler();
+}
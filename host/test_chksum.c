@@ -0,0 +1,215 @@
+/*
+    Test of the Internet checksum routines against lwIP's own
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+fast_chksum() and fast_chksum_copy() (chksum.c) and pbuf_take_chksum() (pbuf.c) are checked against lwIP's own
+algorithm 2 (see refchksum.h).
+fast_chksum() and fast_chksum_copy() are tried on every length below MAX_LEN at every alignment of source
+and destination within MAX_ALIGN bytes (so every entry into the SSE2 loop, where the build has one); the copy
+must also leave the bytes around the destination alone. pbuf_take_chksum() is tried on random pbuf chains,
+offsets and lengths, and must fill the chain as pbuf_take() would.
+
+The Makefile builds this twice: once as the host compiles chksum.c, and once with chksum.c's SSE2 path left out.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "refchksum.h"
+#include "lwip/pbuf.h"
+#include "chksum.h"
+
+#define CHECK(cond) do { checks++; if (!(cond)) { failures++; fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define MAX_LEN         700
+#define MAX_ALIGN       16
+#define GUARD           16
+#define PBUF_TRIALS     100000
+#define PBUF_MAX_LINKS  6
+
+static unsigned checks, failures;
+
+/* a fixed xorshift, so that a failure can be repeated */
+static uint32_t random_state = 2463534242UL;
+
+static uint32_t random32(void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+static void fill_random(uint8_t *p, unsigned len)
+{
+  while (len--)
+    *p++ = (uint8_t)random32();
+}
+
+/* ones' complement sums are equal if they differ only in the representation of zero (0x0000 or 0xFFFF) */
+static int same_sum(uint32_t a, uint32_t b)
+{
+  return (a % 0xFFFF) == (b % 0xFFFF);
+}
+
+static void test_fast_chksum(void)
+{
+  static uint8_t data[MAX_ALIGN + MAX_LEN] __attribute__ ((aligned (MAX_ALIGN)));
+  unsigned align, len, wrong = 0;
+
+  fill_random(data, sizeof(data));
+
+  for (align = 0; align < MAX_ALIGN; align++)
+  {
+    for (len = 0; len < MAX_LEN; len++)
+    {
+      if (!same_sum(fast_chksum(data + align, len), lwip_standard_chksum(data + align, len)))
+      {
+        if (!wrong++)
+          fprintf(stderr, "fast_chksum() differs for %u bytes at offset %u\n", len, align);
+      }
+    }
+  }
+  CHECK(0 == wrong);
+
+  /* sums that carry out of every lane and halfword */
+  memset(data, 0xFF, sizeof(data));
+  for (align = 0; align < MAX_ALIGN; align++)
+    CHECK(same_sum(fast_chksum(data + align, MAX_LEN), lwip_standard_chksum(data + align, MAX_LEN)));
+}
+
+static void test_fast_chksum_copy(void)
+{
+  static uint8_t src[MAX_ALIGN + MAX_LEN] __attribute__ ((aligned (MAX_ALIGN)));
+  static uint8_t dst[GUARD + MAX_ALIGN + MAX_LEN + GUARD] __attribute__ ((aligned (MAX_ALIGN)));
+  static uint8_t expected[sizeof(dst)];
+  unsigned src_align, dst_align, len, wrong = 0;
+  u16_t sum;
+
+  fill_random(src, sizeof(src));
+
+  for (src_align = 0; src_align < MAX_ALIGN; src_align++)
+  {
+    for (dst_align = 0; dst_align < MAX_ALIGN; dst_align++)
+    {
+      for (len = 0; len < MAX_LEN; len++)
+      {
+        fill_random(dst, sizeof(dst));
+        memcpy(expected, dst, sizeof(dst));
+        memcpy(expected + GUARD + dst_align, src + src_align, len);
+
+        sum = fast_chksum_copy(dst + GUARD + dst_align, src + src_align, len);
+
+        if (!same_sum(sum, lwip_standard_chksum(src + src_align, len)) || memcmp(dst, expected, sizeof(dst)))
+        {
+          if (!wrong++)
+            fprintf(stderr, "fast_chksum_copy() differs for %u bytes from offset %u to offset %u\n", len, src_align, dst_align);
+        }
+      }
+    }
+  }
+  CHECK(0 == wrong);
+}
+
+static void test_pbuf_take_chksum(void)
+{
+  static uint8_t payloads[PBUF_MAX_LINKS][MAX_ALIGN + MAX_LEN] __attribute__ ((aligned (MAX_ALIGN)));
+  static uint8_t data[MAX_ALIGN + PBUF_MAX_LINKS * MAX_LEN] __attribute__ ((aligned (MAX_ALIGN)));
+  static uint8_t flat[PBUF_MAX_LINKS * MAX_LEN], expected[PBUF_MAX_LINKS * MAX_LEN], filled[PBUF_MAX_LINKS * MAX_LEN];
+  struct pbuf chain[PBUF_MAX_LINKS];
+  unsigned trial, links, i, tot_len, offset, len, align, wrong = 0;
+  u16_t sum, initial;
+  uint32_t reference;
+  err_t err;
+  int ok;
+
+  for (trial = 0; trial < PBUF_TRIALS; trial++)
+  {
+    /* a chain of links pbufs, each with its payload at a random alignment */
+    links = 1 + random32() % PBUF_MAX_LINKS;
+    tot_len = 0;
+    for (i = links; i-- > 0; )
+    {
+      chain[i].next = (i + 1 < links) ? &chain[i + 1] : NULL;
+      chain[i].payload = payloads[i] + random32() % MAX_ALIGN;
+      chain[i].len = 1 + random32() % (MAX_LEN - 1);
+      tot_len += chain[i].len;
+      chain[i].tot_len = tot_len;
+      chain[i].type = PBUF_REF;
+      chain[i].ref = 1;
+      fill_random(chain[i].payload, chain[i].len);
+    }
+
+    /* data to go at a random offset, usually (but not always) fitting within the chain */
+    offset = random32() % tot_len;
+    len = random32() % (tot_len - offset + ((random32() % 16) ? 1 : 8));
+    align = random32() % MAX_ALIGN;
+    fill_random(data + align, len);
+    initial = (u16_t)random32();
+
+    for (i = 0, tot_len = 0; i < links; tot_len += chain[i].len, i++)
+      memcpy(flat + tot_len, chain[i].payload, chain[i].len);
+    memcpy(expected, flat, tot_len);
+
+    sum = initial;
+    err = pbuf_take_chksum(chain, data + align, len, offset, &sum);
+
+    for (i = 0, tot_len = 0; i < links; tot_len += chain[i].len, i++)
+      memcpy(filled + tot_len, chain[i].payload, chain[i].len);
+
+    if ((offset + len) > tot_len)
+    {
+      /* too long: refused, with nothing touched */
+      ok = (ERR_ARG == err) && (sum == initial) && !memcmp(filled, flat, tot_len);
+    }
+    else
+    {
+      /* the data's sum, as if it sat at offset within a flat packet */
+      memcpy(expected + offset, data + align, len);
+      memset(flat, 0, tot_len);
+      memcpy(flat + offset, data + align, len);
+      reference = (uint32_t)initial + lwip_standard_chksum(flat, offset + len);
+
+      ok = (ERR_OK == err) && same_sum(sum, reference) && !memcmp(filled, expected, tot_len);
+    }
+
+    if (!ok)
+    {
+      if (!wrong++)
+        fprintf(stderr, "pbuf_take_chksum() differs for %u bytes at offset %u of %u pbufs (trial %u)\n", len, offset, links, trial);
+    }
+  }
+  CHECK(0 == wrong);
+}
+
+int main(int argc, char *argv[])
+{
+  test_fast_chksum();
+  test_fast_chksum_copy();
+  test_pbuf_take_chksum();
+
+  printf("%s: %u checks, %u failed\n", argv[0], checks, failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/*
+    Test of the PMA copy loops of the HAL against ST's
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+PCD_WritePMA() and PCD_ReadPMA() (stm32f0xx_hal_pcd.c) are checked against the loops that ST's HAL had (refpma.h),
+on the simulated PMA of the host build (host_pma; see stm32f0xx.h).
+Every length below MAX_LEN is tried at every alignment of the user buffer within MAX_ALIGN bytes; the PMA and
+the user buffer must come out byte for byte as the reference leaves them, including what lies around the copy.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "refpma.h"
+
+#define CHECK(cond) do { checks++; if (!(cond)) { failures++; fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define MAX_LEN     200
+#define MAX_ALIGN   8
+#define GUARD       8
+#define PMA_OFFSET  0x40
+
+static unsigned checks, failures;
+
+static void fill(uint8_t *p, unsigned len, unsigned seed)
+{
+  while (len--)
+  {
+    seed = seed * 1103515245u + 12345u;
+    *p++ = (uint8_t)(seed >> 16);
+  }
+}
+
+static void test_write_pma(void)
+{
+  static uint8_t user[MAX_ALIGN + MAX_LEN + 1] __attribute__ ((aligned (MAX_ALIGN)));
+  static uint16_t expected[USB_PMA_SIZE / 2];
+  unsigned align, len, wrong;
+
+  fill(user, sizeof(user), 1);
+
+  for (align = 0; align < MAX_ALIGN; align++)
+  {
+    wrong = 0;
+    for (len = 0; len < MAX_LEN; len++)
+    {
+      fill((uint8_t *)host_pma, sizeof(host_pma), align * MAX_LEN + len);
+      ref_write_pma(USB, user + align, PMA_OFFSET, len);
+      memcpy(expected, host_pma, sizeof(host_pma));
+
+      fill((uint8_t *)host_pma, sizeof(host_pma), align * MAX_LEN + len);
+      PCD_WritePMA(USB, user + align, PMA_OFFSET, len);
+
+      if (memcmp(expected, host_pma, sizeof(host_pma)))
+      {
+        if (!wrong++)
+          fprintf(stderr, "PCD_WritePMA() differs for %u bytes from offset %u\n", len, align);
+      }
+    }
+    CHECK(0 == wrong);
+  }
+}
+
+static void test_read_pma(void)
+{
+  static uint8_t user[GUARD + MAX_ALIGN + MAX_LEN + 1 + GUARD] __attribute__ ((aligned (MAX_ALIGN)));
+  static uint8_t expected[sizeof(user)];
+  unsigned align, len, wrong;
+
+  fill((uint8_t *)host_pma, sizeof(host_pma), 2);
+
+  for (align = 0; align < MAX_ALIGN; align++)
+  {
+    wrong = 0;
+    for (len = 0; len < MAX_LEN; len++)
+    {
+      fill(expected, sizeof(expected), align * MAX_LEN + len);
+      ref_read_pma(USB, expected + GUARD + align, PMA_OFFSET, len);
+
+      fill(user, sizeof(user), align * MAX_LEN + len);
+      PCD_ReadPMA(USB, user + GUARD + align, PMA_OFFSET, len);
+
+      if (memcmp(expected, user, sizeof(user)))
+      {
+        if (!wrong++)
+          fprintf(stderr, "PCD_ReadPMA() differs for %u bytes to offset %u\n", len, align);
+      }
+    }
+    CHECK(0 == wrong);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  test_write_pma();
+  test_read_pma();
+
+  printf("%s: %u checks, %u failed\n", argv[0], checks, failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,566 @@
+/*
+    Test of the whole firmware in the simulator of the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The whole firmware (main.c, lwIP, the USB device library, usbd_ecm.c and the HAL) is run in the simulator (see simcpu.c),
+and the scripted host (usbhost.c) then does what a Linux PC does on plugging it in:
+it enumerates the device, waits for the link to come up, gets an address by DHCP, looks the device up with ARP,
+pings it (with small and full-size packets), and fetches its web page (and the state that the page polls for) over TCP.
+Finally, frames of every length are sent each way, to catch any mistake in the framing by short and zero-length packets,
+and the host's own multicast is checked to be dropped.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "simcpu.h"
+#include "usbsim.h"
+#include "usbhost.h"
+#include "usbd_conf.h"
+#include "usbd_ecm.h"
+
+#define CHECK(cond) do { checks++; if (!(cond)) { failures++; fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+/* (ETHTYPE_IP and ETHTYPE_ARP come from lwIP, through usbd_ecm.h) */
+#define ETH_HLEN        14
+#define IP_HLEN         20
+#define UDP_HLEN        8
+#define TCP_HLEN        20
+#define PROTO_ICMP      1
+#define PROTO_TCP       6
+#define PROTO_UDP       17
+#define TCP_FIN         0x01
+#define TCP_SYN         0x02
+#define TCP_PSH         0x08
+#define TCP_ACK         0x10
+
+/* frames that a reply may take */
+#define REPLY_TIMEOUT   100
+
+static unsigned checks, failures;
+
+static struct usbhost_ecm ecm;
+static const uint8_t broadcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+static const uint8_t device_ip[4] = { 192, 168, 7, 1 };
+static uint8_t device_mac[6];
+static uint8_t host_ip[4];
+static uint16_t ip_id;
+
+static uint8_t frame[1600];
+
+static void put16(uint8_t *p, uint16_t value)
+{
+  p[0] = value >> 8;
+  p[1] = value;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+  return p[0] << 8 | p[1];
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+  put16(p, value >> 16);
+  put16(p + 2, value);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+  return (uint32_t)get16(p) << 16 | get16(p + 2);
+}
+
+/* the Internet checksum (RFC 1071), done the slow and obvious way */
+static uint32_t sum16(const uint8_t *data, unsigned len, uint32_t sum)
+{
+  unsigned i;
+
+  for (i = 0; (i + 1) < len; i += 2)
+    sum += get16(data + i);
+  if (len & 1)
+    sum += data[len - 1] << 8;
+  return sum;
+}
+
+static uint16_t fold(uint32_t sum)
+{
+  while (sum >> 16)
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  return ~sum;
+}
+
+static uint8_t *eth_header(const uint8_t *dest, uint16_t type)
+{
+  memcpy(frame, dest, 6);
+  memcpy(frame + 6, ecm.mac, 6);
+  put16(frame + 12, type);
+  return frame + ETH_HLEN;
+}
+
+/* IPv4 header (from src to dst), in front of len bytes of payload */
+static uint8_t *ip_header(uint8_t proto, const uint8_t *src, const uint8_t *dst, unsigned len)
+{
+  uint8_t *ip = eth_header(memcmp(dst, "\xFF\xFF\xFF\xFF", 4) ? device_mac : broadcast, ETHTYPE_IP);
+
+  memset(ip, 0, IP_HLEN);
+  ip[0] = 0x45;
+  put16(ip + 2, IP_HLEN + len);
+  put16(ip + 4, ++ip_id);
+  ip[8] = 64;
+  ip[9] = proto;
+  memcpy(ip + 12, src, 4);
+  memcpy(ip + 16, dst, 4);
+  put16(ip + 10, fold(sum16(ip, IP_HLEN, 0)));
+  return ip + IP_HLEN;
+}
+
+/* checksum of a TCP (or UDP) segment with its pseudo-header */
+static uint16_t transport_checksum(const uint8_t *ip, const uint8_t *segment, unsigned len)
+{
+  uint32_t sum = sum16(ip + 12, 8, 0) + ip[9] + len;
+
+  return fold(sum16(segment, len, sum));
+}
+
+static void send_frame(unsigned len)
+{
+  CHECK(usbhost_send(&ecm, frame, len));
+}
+
+static void arp(uint16_t op, const uint8_t *dest_mac, const uint8_t *target_mac, const uint8_t *target_ip)
+{
+  uint8_t *arp = eth_header(dest_mac, ETHTYPE_ARP);
+
+  put16(arp, 1);
+  put16(arp + 2, ETHTYPE_IP);
+  arp[4] = 6;
+  arp[5] = 4;
+  put16(arp + 6, op);
+  memcpy(arp + 8, ecm.mac, 6);
+  memcpy(arp + 14, host_ip, 4);
+  memcpy(arp + 18, target_mac, 6);
+  memcpy(arp + 24, target_ip, 4);
+  send_frame(ETH_HLEN + 28);
+}
+
+/*
+wait for a frame of the given type (and IP protocol) from the device; returns its length, or -1 if none came in time
+any ARP request for the host's address that arrives meanwhile is answered
+*/
+static int await(uint16_t type, uint8_t proto)
+{
+  uint32_t start = usbhost_frames;
+  int len;
+
+  while ((usbhost_frames - start) < REPLY_TIMEOUT)
+  {
+    len = usbhost_recv(&ecm, frame, sizeof(frame), REPLY_TIMEOUT - (usbhost_frames - start));
+    if (len < ETH_HLEN)
+      continue;
+
+    if ((ETHTYPE_ARP == get16(frame + 12)) && (ETHTYPE_ARP != type) && (1 == get16(frame + ETH_HLEN + 6)) && !memcmp(frame + ETH_HLEN + 24, host_ip, 4))
+    {
+      uint8_t mac[6], ip[4];
+
+      memcpy(mac, frame + ETH_HLEN + 8, 6);
+      memcpy(ip, frame + ETH_HLEN + 14, 4);
+      arp(2, mac, mac, ip);
+      continue;
+    }
+
+    if ((type == get16(frame + 12)) && ((ETHTYPE_IP != type) || (proto == frame[ETH_HLEN + 9])))
+      return len;
+  }
+
+  return -1;
+}
+
+static void test_enumeration(void)
+{
+  static const uint8_t mac[6] = { 0x02, 0x02, 0x12, 0x34, 0x56, 0x78 };
+
+  CHECK(usbhost_enumerate(&ecm));
+  CHECK(0x81 == ecm.notify_ep);
+  CHECK(0x82 == ecm.in_ep);
+  CHECK(0x03 == ecm.out_ep);
+  CHECK((64 == ecm.in_mps) && (64 == ecm.out_mps));
+
+  /* locally administered, from the serial number (host_device_id2 of hostcpu.c) */
+  CHECK(!memcmp(ecm.mac, mac, 6));
+}
+
+static void test_notifications(void)
+{
+  uint8_t data[64];
+  int len;
+
+  /* the packet filter has been set, so the device gives its speed and then the link state */
+  len = usbhost_notification(&ecm, data, sizeof(data), REPLY_TIMEOUT);
+  CHECK((16 == len) && (0xA1 == data[0]) && (0x2A /* CONNECTION_SPEED_CHANGE */ == data[1]) && (8 == data[6]));
+
+  len = usbhost_notification(&ecm, data, sizeof(data), REPLY_TIMEOUT);
+  CHECK((8 == len) && (0xA1 == data[0]) && (0x00 /* NETWORK_CONNECTION */ == data[1]) && (1 == data[2]) && (ecm.comm_itf == data[4]));
+}
+
+static void dhcp(uint8_t type, const uint8_t *requested)
+{
+  static const uint8_t any[4] = { 0, 0, 0, 0 };
+  static const uint8_t all[4] = { 255, 255, 255, 255 };
+  unsigned len = 240 + 3 + (requested ? 6 : 0) + 1;
+  uint8_t *udp = ip_header(PROTO_UDP, any, all, UDP_HLEN + len);
+  uint8_t *bootp = udp + UDP_HLEN;
+  uint8_t *option = bootp + 240;
+
+  put16(udp, 68);
+  put16(udp + 2, 67);
+  put16(udp + 4, UDP_HLEN + len);
+  put16(udp + 6, 0);
+
+  memset(bootp, 0, len);
+  bootp[0] = 1; /* request */
+  bootp[1] = 1; /* Ethernet */
+  bootp[2] = 6;
+  put32(bootp + 4, 0x2A2A0000 | type);
+  put16(bootp + 10, 0x8000); /* broadcast */
+  memcpy(bootp + 28, ecm.mac, 6);
+  put32(bootp + 236, 0x63825363);
+
+  *option++ = 53;
+  *option++ = 1;
+  *option++ = type;
+  if (requested)
+  {
+    *option++ = 50;
+    *option++ = 4;
+    memcpy(option, requested, 4);
+    option += 4;
+  }
+  *option = 255;
+
+  send_frame(ETH_HLEN + IP_HLEN + UDP_HLEN + len);
+}
+
+/* the DHCP message type of a reply to the client port, or 0 */
+static uint8_t dhcp_reply(int len)
+{
+  const uint8_t *udp = frame + ETH_HLEN + IP_HLEN;
+
+  if ((len < (ETH_HLEN + IP_HLEN + UDP_HLEN + 243)) || (68 != get16(udp + 2)) || (2 != udp[UDP_HLEN]))
+    return 0;
+  if ((0x63825363 != get32(udp + UDP_HLEN + 236)) || (53 != udp[UDP_HLEN + 240]))
+    return 0;
+  return udp[UDP_HLEN + 242];
+}
+
+static void test_dhcp(void)
+{
+  uint8_t offered[4];
+  int len;
+
+  dhcp(1 /* DISCOVER */, NULL);
+  len = await(ETHTYPE_IP, PROTO_UDP);
+  CHECK(2 /* OFFER */ == dhcp_reply(len));
+  memcpy(offered, frame + ETH_HLEN + IP_HLEN + UDP_HLEN + 16, 4);
+  CHECK(!memcmp(offered, "\xC0\xA8\x07\x02", 4));
+
+  dhcp(3 /* REQUEST */, offered);
+  len = await(ETHTYPE_IP, PROTO_UDP);
+  CHECK(5 /* ACK */ == dhcp_reply(len));
+
+  memcpy(host_ip, offered, 4);
+}
+
+static void test_arp(void)
+{
+  static const uint8_t unknown[6];
+  int len;
+
+  arp(1, broadcast, unknown, device_ip);
+  len = await(ETHTYPE_ARP, 0);
+  CHECK((len >= (ETH_HLEN + 28)) && (2 == get16(frame + ETH_HLEN + 6)) && !memcmp(frame + ETH_HLEN + 14, device_ip, 4));
+  CHECK(!memcmp(frame, ecm.mac, 6));
+
+  memcpy(device_mac, frame + ETH_HLEN + 8, 6);
+}
+
+/* an echo request with size bytes of data must come back as it went, with every packet after the first prefilled */
+static void ping(unsigned size, uint16_t seq)
+{
+  uint8_t payload[1500];
+  uint8_t *icmp = ip_header(PROTO_ICMP, host_ip, device_ip, 8 + size);
+  unsigned i, prefilled;
+  int len;
+
+  for (i = 0; i < size; i++)
+    payload[i] = (uint8_t)(i * 7 + seq);
+
+  icmp[0] = 8;
+  icmp[1] = 0;
+  put16(icmp + 2, 0);
+  put16(icmp + 4, 0x1234);
+  put16(icmp + 6, seq);
+  memcpy(icmp + 8, payload, size);
+  put16(icmp + 2, fold(sum16(icmp, 8 + size, 0)));
+  send_frame(ETH_HLEN + IP_HLEN + 8 + size);
+
+  prefilled = usbsim_prefilled;
+  len = await(ETHTYPE_IP, PROTO_ICMP);
+  icmp = frame + ETH_HLEN + IP_HLEN;
+  CHECK(len == (int)(ETH_HLEN + IP_HLEN + 8 + size));
+  if (len != (int)(ETH_HLEN + IP_HLEN + 8 + size))
+    return;
+#if ECM_DOUBLE_BUFFER
+  CHECK((usbsim_prefilled - prefilled) >= (unsigned)(len / ecm.in_mps));
+#else
+  (void)prefilled;
+#endif
+  CHECK((0 == icmp[0]) && (seq == get16(icmp + 6)));
+  CHECK(0 == fold(sum16(icmp, 8 + size, 0)));
+  CHECK(!memcmp(icmp + 8, payload, size));
+}
+
+static void test_ping(void)
+{
+  /* the size of a default ping, and the largest that fits in an Ethernet frame */
+  ping(56, 1);
+  ping(1500 - IP_HLEN - 8, 2);
+}
+
+/* has the device taken a frame of len bytes from the host (or, if it is shorter than an Ethernet header, discarded it)? */
+static bool rx_taken(unsigned len)
+{
+  struct ecm_stats before, after;
+  struct ecm_filter_stats filter_before, filter_after;
+  uint32_t start = usbhost_frames;
+
+  usb_ecm_get_stats(0, &before);
+  usb_ecm_get_filter_stats(0, &filter_before);
+
+  send_frame(len);
+
+  do
+  {
+    usb_ecm_get_stats(0, &after);
+    usb_ecm_get_filter_stats(0, &filter_after);
+    if (len < ETH_HLEN)
+    {
+      if (filter_after.rx_runt != filter_before.rx_runt)
+        return (filter_after.rx_runt == (filter_before.rx_runt + 1)) && (after.frames_in == before.frames_in);
+    }
+    else if (after.frames_in != before.frames_in)
+    {
+      return (after.frames_in == (before.frames_in + 1)) && (after.bytes_in == (before.bytes_in + len));
+    }
+    usbhost_wait(1);
+  } while ((usbhost_frames - start) < REPLY_TIMEOUT);
+
+  return false;
+}
+
+/*
+every length of frame must arrive whole, and be ended by the first short packet; a frame that is a multiple of 64 bytes long
+is followed by a zero-length packet (usbhost_send() sends one from the host, and the device must send one in turn),
+and a lone zero-length packet is no frame at all
+*/
+static void test_frame_sizes(void)
+{
+  struct ecm_stats before, after;
+  unsigned len, size, wrong = 0;
+  uint8_t *ip;
+
+  /* from the host: the IP header (if there is room for one) has version 0, so that lwIP drops the frame once it is counted */
+  for (len = 1; len <= (ETH_HLEN + 1500); len++)
+  {
+    ip = eth_header(device_mac, ETHTYPE_IP);
+    memset(ip, 0, sizeof(frame) - ETH_HLEN);
+    if (!rx_taken(len))
+    {
+      fprintf(stderr, "frame of %u bytes from the host went astray\n", len);
+      wrong++;
+    }
+  }
+  CHECK(0 == wrong);
+
+  usb_ecm_get_stats(0, &before);
+  CHECK(usbhost_send(&ecm, frame, 0));
+  usbhost_wait(2);
+  usb_ecm_get_stats(0, &after);
+  CHECK(after.frames_in == before.frames_in);
+  CHECK(rx_taken(64) && rx_taken(ETH_HLEN));
+
+  /* to the host: echo replies from the smallest (42 bytes) to the largest, with nothing (such as a stray zero-length packet) after each */
+  for (size = 0; size <= (1500 - IP_HLEN - 8); size++)
+  {
+    ping(size, (uint16_t)(size + 3));
+    CHECK(-1 == usbhost_recv(&ecm, frame, sizeof(frame), 2));
+  }
+}
+
+/*
+SET_ETHERNET_MULTICAST_FILTERS names the groups that the host receives; it must let the host's own multicast on those groups
+(mDNS here) no further than the device's filter, as lwIP joins no group, whilst broadcasts still get through
+*/
+static void test_multicast(void)
+{
+  static const uint8_t mdns[6] = { 0x01, 0x00, 0x5E, 0x00, 0x00, 0xFB };
+  struct ecm_stats before, after;
+  struct ecm_filter_stats filter_before, filter_after;
+  uint8_t groups[6];
+
+  memcpy(groups, mdns, sizeof(groups));
+  CHECK(sizeof(groups) == usbhost_control(0x21, 0x40 /* SET_ETHERNET_MULTICAST_FILTERS */, 1, ecm.comm_itf, groups, sizeof(groups)));
+
+  usb_ecm_get_stats(0, &before);
+  usb_ecm_get_filter_stats(0, &filter_before);
+  memset(eth_header(mdns, ETHTYPE_IP), 0, IP_HLEN);
+  send_frame(ETH_HLEN + IP_HLEN);
+  usbhost_wait(2);
+  usb_ecm_get_stats(0, &after);
+  usb_ecm_get_filter_stats(0, &filter_after);
+  CHECK(after.frames_in == before.frames_in);
+  CHECK(filter_after.rx_multicast == (filter_before.rx_multicast + 1));
+
+  memset(eth_header(broadcast, ETHTYPE_IP), 0, IP_HLEN);
+  CHECK(rx_taken(ETH_HLEN + IP_HLEN));
+}
+
+static uint32_t snd_nxt, rcv_nxt;
+static uint16_t host_port = 40000;
+
+static void tcp(uint8_t flags, const void *data, unsigned len)
+{
+  uint8_t *ip;
+  uint8_t *seg = ip_header(PROTO_TCP, host_ip, device_ip, TCP_HLEN + len);
+
+  ip = seg - IP_HLEN;
+  memset(seg, 0, TCP_HLEN);
+  put16(seg, host_port);
+  put16(seg + 2, 80);
+  put32(seg + 4, snd_nxt);
+  put32(seg + 8, (flags & TCP_ACK) ? rcv_nxt : 0);
+  seg[12] = (TCP_HLEN / 4) << 4;
+  seg[13] = flags;
+  put16(seg + 14, 8192);
+  memcpy(seg + TCP_HLEN, data, len);
+  put16(seg + 16, transport_checksum(ip, seg, TCP_HLEN + len));
+  send_frame(ETH_HLEN + IP_HLEN + TCP_HLEN + len);
+
+  snd_nxt += len + ((flags & (TCP_SYN | TCP_FIN)) ? 1 : 0);
+}
+
+/* fetch path over a new connection (from the next port) into page, as a string; false if it went wrong */
+static bool http_get(const char *path, char *page, unsigned size)
+{
+  char request[64];
+  const uint8_t *ip = frame + ETH_HLEN;
+  const uint8_t *seg = ip + IP_HLEN;
+  unsigned received = 0, hlen, dlen;
+  bool closed = false;
+  int len;
+
+  host_port++;
+  snd_nxt = 1000;
+  tcp(TCP_SYN, NULL, 0);
+  len = await(ETHTYPE_IP, PROTO_TCP);
+  CHECK((len > 0) && ((TCP_SYN | TCP_ACK) == (seg[13] & (TCP_SYN | TCP_ACK))) && (snd_nxt == get32(seg + 8)));
+  if (len <= 0)
+    return false;
+  rcv_nxt = get32(seg + 4) + 1;
+
+  len = snprintf(request, sizeof(request), "GET %s HTTP/1.0\r\n\r\n", path);
+  tcp(TCP_ACK | TCP_PSH, request, len);
+
+  while (!closed)
+  {
+    len = await(ETHTYPE_IP, PROTO_TCP);
+    CHECK(len > 0);
+    if (len <= 0)
+      return false;
+    CHECK(0 == transport_checksum(ip, seg, get16(ip + 2) - IP_HLEN));
+
+    hlen = (seg[12] >> 4) * 4;
+    dlen = get16(ip + 2) - IP_HLEN - hlen;
+
+    /* only what is next in sequence is taken (so anything else is sent again) */
+    if (get32(seg + 4) == rcv_nxt)
+    {
+      if ((received + dlen) < size)
+        memcpy(page + received, seg + hlen, dlen);
+      received += dlen;
+      rcv_nxt += dlen;
+      if (seg[13] & TCP_FIN)
+      {
+        rcv_nxt++;
+        closed = true;
+      }
+    }
+    if (dlen || (seg[13] & TCP_FIN))
+      tcp(TCP_ACK, NULL, 0);
+  }
+
+  tcp(TCP_FIN | TCP_ACK, NULL, 0);
+  len = await(ETHTYPE_IP, PROTO_TCP);
+  CHECK((len > 0) && (seg[13] & TCP_ACK) && (snd_nxt == get32(seg + 8)));
+
+  CHECK(received < size);
+  page[received < size ? received : size - 1] = '\0';
+  return received < size;
+}
+
+static void test_http(void)
+{
+  static char page[16384];
+  const char *loop;
+  unsigned passes, idle;
+
+  CHECK(http_get("/", page, sizeof(page)));
+  CHECK(!strncmp(page, "HTTP/1.0 200 OK", 15));
+  CHECK(strstr(page, "<title>Toaster Example</title>") != NULL);
+
+  /* the state that the page polls for, with the main loop's passes and idle time (the SSI tags "loops" and "idle") */
+  CHECK(http_get("/state.cgi", page, sizeof(page)));
+  CHECK(!strncmp(page, "HTTP/1.0 200 OK", 15));
+  loop = strstr(page, "\"loop\":");
+  CHECK(loop && (2 == sscanf(loop, "\"loop\": { \"passes\": %u, \"idle\": %u }", &passes, &idle)));
+  CHECK(loop && (passes > 0) && (idle <= 100));
+}
+
+int main(int argc, char *argv[])
+{
+  sim_start();
+
+  test_enumeration();
+  test_notifications();
+  test_dhcp();
+  test_arp();
+  test_ping();
+  test_http();
+  test_frame_sizes();
+  test_multicast();
+
+  CHECK(0 == usbsim_errors);
+  CHECK(0 == usbhost_errors);
+
+  printf("%s: %u checks, %u failed (%u ms simulated)\n", argv[0], checks, failures, (unsigned)usbhost_frames);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,476 @@
+/*
+    Scripted USB host for the simulator of the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+Each transaction is offered to the model (usbsim.c) until it is answered with something other than a NAK, or the timeout passes.
+Once the device has ACKed one, it is given its interrupt at once, and then its main loop is run until it sleeps again
+(see simcpu.c); so, the firmware is infinitely fast next to the bus, and a NAK means that it is waiting for something.
+Unless usbhost_cpu_time is set: then each run of the main loop keeps it busy for as many byte times as that says,
+during which the host carries on with its transactions (and the interrupt handlers run), but the main loop is only
+run again once they have passed.
+A bulk endpoint is retried straight away (as a host controller does), and an interrupt endpoint in the next frame.
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "usbhost.h"
+#include "usbsim.h"
+#include "simcpu.h"
+
+/* byte times in a full-speed frame, and those taken by a transaction besides its data (tokens, PIDs, CRC, handshake and gaps) */
+#define FRAME_BYTES       1500
+#define TRANSACTION_BYTES 16
+
+#define EP0_MPS           64
+
+/* frames that the device may NAK a control transaction (or the rest of a bulk transfer) for before the host gives up */
+#define HANDSHAKE_TIMEOUT 1000
+
+unsigned usbhost_errors;
+uint32_t usbhost_frames;
+uint64_t usbhost_bytes;
+unsigned (*usbhost_cpu_time)(void);
+
+static uint8_t address;
+static unsigned frame_used;
+static uint64_t busy_until;
+static bool firmware_due;
+static uint8_t toggle_in[16], toggle_out[16];
+
+static void usbhost_error(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  fprintf(stderr, "usbhost: ");
+  vfprintf(stderr, format, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+
+  usbhost_errors++;
+}
+
+/* run the firmware's main loop until it sleeps, or leave that until it is no longer busy */
+static void run_firmware(void)
+{
+  if (usbhost_bytes < busy_until)
+  {
+    firmware_due = true;
+    return;
+  }
+
+  firmware_due = false;
+  sim_resume();
+  if (usbhost_cpu_time)
+    busy_until = usbhost_bytes + usbhost_cpu_time();
+}
+
+static void next_frame(void)
+{
+  if (frame_used < FRAME_BYTES)
+    usbhost_bytes += FRAME_BYTES - frame_used;
+  frame_used = 0;
+  usbhost_frames++;
+  sim_millisecond();
+  run_firmware();
+}
+
+/* account for a transaction, moving on to the next frame once this one is full */
+static void spend(unsigned len)
+{
+  frame_used += TRANSACTION_BYTES + len;
+  usbhost_bytes += TRANSACTION_BYTES + len;
+  if (frame_used >= FRAME_BYTES)
+    next_frame();
+  else if (firmware_due && (usbhost_bytes >= busy_until))
+    run_firmware();
+}
+
+void usbhost_wait(unsigned ms)
+{
+  while (ms--)
+    next_frame();
+}
+
+static void reset_toggles(void)
+{
+  memset(toggle_in, 0, sizeof(toggle_in));
+  memset(toggle_out, 0, sizeof(toggle_out));
+}
+
+void usbhost_reset(void)
+{
+  usbsim_bus_reset();
+  sim_irq();
+  run_firmware();
+
+  address = 0;
+  reset_toggles();
+
+  /* the recovery interval */
+  usbhost_wait(10);
+}
+
+static enum usbsim_handshake out_packet(uint8_t ep, const uint8_t *data, unsigned len, unsigned timeout)
+{
+  enum usbsim_handshake handshake;
+  uint32_t start = usbhost_frames;
+
+  do
+  {
+    handshake = usbsim_out(address, ep, toggle_out[ep], data, len);
+    spend(len);
+  } while ((USBSIM_NAK == handshake) && ((usbhost_frames - start) < timeout));
+
+  if (USBSIM_ACK == handshake)
+  {
+    toggle_out[ep] ^= 1;
+    sim_irq();
+    run_firmware();
+  }
+
+  return handshake;
+}
+
+static enum usbsim_handshake in_packet(uint8_t ep, uint8_t *data, unsigned *len, unsigned timeout, bool interrupt)
+{
+  enum usbsim_handshake handshake;
+  uint32_t start = usbhost_frames;
+  unsigned toggle;
+
+  for (;;)
+  {
+    handshake = usbsim_in(address, ep, data, len, &toggle);
+    if (USBSIM_NAK != handshake)
+      break;
+    spend(0);
+    if ((usbhost_frames - start) >= timeout)
+      return handshake;
+    if (interrupt)
+      next_frame();
+  }
+
+  if (USBSIM_ACK == handshake)
+  {
+    spend(*len);
+    if (toggle != toggle_in[ep])
+      usbhost_error("EP%u IN: DATA%u when DATA%u was due", ep, toggle, toggle_in[ep]);
+    toggle_in[ep] = toggle ^ 1;
+    sim_irq();
+    run_firmware();
+  }
+
+  return handshake;
+}
+
+int usbhost_control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, void *data, uint16_t wLength)
+{
+  uint8_t setup[8] = { bmRequestType, bRequest, wValue, wValue >> 8, wIndex, wIndex >> 8, wLength, wLength >> 8 };
+  uint8_t packet[1024];
+  enum usbsim_handshake handshake;
+  unsigned done = 0, len;
+
+  handshake = usbsim_setup(address, setup);
+  spend(sizeof(setup));
+  if (USBSIM_ACK != handshake)
+  {
+    usbhost_error("SETUP %02X %02X not acknowledged", bmRequestType, bRequest);
+    return -1;
+  }
+  sim_irq();
+  run_firmware();
+
+  /* the data stage (if any) and the status stage start with DATA1 */
+  toggle_in[0] = toggle_out[0] = 1;
+
+  if (bmRequestType & 0x80)
+  {
+    while (done < wLength)
+    {
+      handshake = in_packet(0, packet, &len, HANDSHAKE_TIMEOUT, false);
+      if (USBSIM_ACK != handshake)
+        break;
+      if ((len > EP0_MPS) || (len > (wLength - done)))
+      {
+        usbhost_error("request %02X: %u bytes too many", bRequest, len);
+        len = wLength - done;
+      }
+      memcpy((uint8_t *)data + done, packet, len);
+      done += len;
+      if (len < EP0_MPS)
+        break;
+    }
+    if (USBSIM_ACK == handshake)
+      handshake = out_packet(0, NULL, 0, HANDSHAKE_TIMEOUT);
+  }
+  else
+  {
+    while ((done < wLength) && (USBSIM_ACK == handshake))
+    {
+      len = ((wLength - done) < EP0_MPS) ? (wLength - done) : EP0_MPS;
+      handshake = out_packet(0, (const uint8_t *)data + done, len, HANDSHAKE_TIMEOUT);
+      done += len;
+    }
+    if (USBSIM_ACK == handshake)
+    {
+      handshake = in_packet(0, packet, &len, HANDSHAKE_TIMEOUT, false);
+      if ((USBSIM_ACK == handshake) && len)
+        usbhost_error("request %02X: status stage of %u bytes", bRequest, len);
+    }
+  }
+
+  if (USBSIM_ACK != handshake)
+  {
+    /* a STALL is the device refusing the request, which is up to the caller to judge */
+    if (USBSIM_STALL != handshake)
+      usbhost_error("request %02X: no answer", bRequest);
+    return -1;
+  }
+
+  if ((0x00 == bmRequestType) && (0x05 /* SET_ADDRESS */ == bRequest))
+    address = wValue;
+
+  /* the endpoints start again from DATA0 */
+  if (((0x00 == bmRequestType) && (0x09 /* SET_CONFIGURATION */ == bRequest)) || ((0x01 == bmRequestType) && (0x0B /* SET_INTERFACE */ == bRequest)))
+    reset_toggles();
+
+  return done;
+}
+
+static int hex_digit(uint8_t c)
+{
+  if ((c >= '0') && (c <= '9'))
+    return c - '0';
+  if ((c >= 'A') && (c <= 'F'))
+    return c - 'A' + 10;
+  if ((c >= 'a') && (c <= 'f'))
+    return c - 'a' + 10;
+  return -1;
+}
+
+/* pick out the interfaces and endpoints of the first ECM function */
+static bool parse_configuration(struct usbhost_ecm *ecm, const uint8_t *desc, int total, uint8_t *imac)
+{
+  enum { OTHER, COMM, DATA, DONE } in = OTHER;
+  bool comm_found = false, data_found = false;
+  int offset;
+
+  memset(ecm, 0, sizeof(*ecm));
+  *imac = 0;
+
+  for (offset = 0; (offset + 2 <= total) && (desc[offset] >= 2) && (in != DONE); offset += desc[offset])
+  {
+    const uint8_t *d = desc + offset;
+
+    switch (d[1])
+    {
+    case 0x04: /* INTERFACE */
+      if ((0x02 == d[5]) && (0x06 == d[6]) && comm_found)
+      {
+        /* the second ECM function */
+        in = DONE;
+      }
+      else if ((0x02 == d[5]) && (0x06 == d[6]))
+      {
+        in = COMM;
+        comm_found = true;
+        ecm->comm_itf = d[2];
+      }
+      else if ((0x0A == d[5]) && comm_found && (d[4] >= 2))
+      {
+        in = DATA;
+        ecm->data_itf = d[2];
+        ecm->data_alt = d[3];
+      }
+      else
+      {
+        in = (DATA == in) ? DONE : OTHER;
+      }
+      break;
+    case 0x24: /* CS_INTERFACE */
+      if ((COMM == in) && (0x0F /* Ethernet Networking */ == d[2]))
+        *imac = d[3];
+      break;
+    case 0x05: /* ENDPOINT */
+      if ((COMM == in) && (0x03 == (d[3] & 0x03)))
+      {
+        ecm->notify_ep = d[2];
+        ecm->notify_mps = d[4] | d[5] << 8;
+      }
+      else if ((DATA == in) && (0x02 == (d[3] & 0x03)))
+      {
+        data_found = true;
+        if (d[2] & 0x80)
+        {
+          ecm->in_ep = d[2];
+          ecm->in_mps = d[4] | d[5] << 8;
+        }
+        else
+        {
+          ecm->out_ep = d[2];
+          ecm->out_mps = d[4] | d[5] << 8;
+        }
+      }
+      break;
+    }
+  }
+
+  return comm_found && data_found && *imac && ecm->notify_ep && ecm->notify_mps && ecm->in_ep && ecm->out_ep && ecm->in_mps && ecm->out_mps;
+}
+
+bool usbhost_enumerate(struct usbhost_ecm *ecm)
+{
+  uint8_t desc[512];
+  uint8_t imac, config;
+  int len, total, i, hi, lo;
+
+  /* as Linux, read the start of the device descriptor at address 0, and then reset again */
+  usbhost_reset();
+  len = usbhost_control(0x80, 0x06 /* GET_DESCRIPTOR */, 0x0100, 0, desc, 64);
+  if ((len < 18) || (desc[0] != 18) || (desc[1] != 0x01) || (desc[7] != EP0_MPS))
+  {
+    usbhost_error("bad device descriptor");
+    return false;
+  }
+  usbhost_reset();
+
+  if (usbhost_control(0x00, 0x05 /* SET_ADDRESS */, USBHOST_ADDRESS, 0, NULL, 0) < 0)
+    return false;
+  usbhost_wait(2);
+
+  if (usbhost_control(0x80, 0x06, 0x0100, 0, desc, 18) != 18)
+  {
+    usbhost_error("device descriptor unreadable at the new address");
+    return false;
+  }
+
+  if (usbhost_control(0x80, 0x06, 0x0200, 0, desc, 9) != 9)
+    return false;
+  total = desc[2] | desc[3] << 8;
+  config = desc[5];
+  if ((total > (int)sizeof(desc)) || (usbhost_control(0x80, 0x06, 0x0200, 0, desc, total) != total))
+  {
+    usbhost_error("bad configuration descriptor");
+    return false;
+  }
+  if (!parse_configuration(ecm, desc, total, &imac))
+  {
+    usbhost_error("no ECM function in the configuration descriptor");
+    return false;
+  }
+
+  /* iMACAddress is twelve hex digits */
+  len = usbhost_control(0x80, 0x06, 0x0300 | imac, 0x0409, desc, 255);
+  if (len != (2 + 12 * 2))
+  {
+    usbhost_error("bad iMACAddress string");
+    return false;
+  }
+  for (i = 0; i < 6; i++)
+  {
+    hi = hex_digit(desc[2 + 4 * i]);
+    lo = hex_digit(desc[2 + 4 * i + 2]);
+    if ((hi < 0) || (lo < 0))
+    {
+      usbhost_error("bad iMACAddress string");
+      return false;
+    }
+    ecm->mac[i] = hi << 4 | lo;
+  }
+
+  if (usbhost_control(0x00, 0x09 /* SET_CONFIGURATION */, config, 0, NULL, 0) < 0)
+    return false;
+
+  if (usbhost_control(0x01, 0x0B /* SET_INTERFACE */, ecm->data_alt, ecm->data_itf, NULL, 0) < 0)
+    return false;
+
+  /* directed, broadcast and all multicast; the device starts sending notifications once this is set */
+  if (usbhost_control(0x21, 0x43 /* SET_ETHERNET_PACKET_FILTER */, 0x000E, ecm->comm_itf, NULL, 0) < 0)
+    return false;
+
+  return true;
+}
+
+bool usbhost_send(const struct usbhost_ecm *ecm, const void *frame, unsigned len)
+{
+  const uint8_t *data = frame;
+  uint8_t ep = ecm->out_ep & 0x0F;
+  unsigned chunk;
+
+  for (;;)
+  {
+    chunk = (len < ecm->out_mps) ? len : ecm->out_mps;
+    if (USBSIM_ACK != out_packet(ep, data, chunk, HANDSHAKE_TIMEOUT))
+    {
+      usbhost_error("EP%u OUT: frame not taken", ep);
+      return false;
+    }
+    data += chunk;
+    len -= chunk;
+    if (chunk < ecm->out_mps)
+      return true;
+  }
+}
+
+static int receive(uint8_t ep, uint16_t mps, uint8_t *frame, unsigned max, unsigned timeout, bool interrupt)
+{
+  uint8_t packet[1024];
+  enum usbsim_handshake handshake;
+  unsigned len, total = 0;
+
+  for (;;)
+  {
+    handshake = in_packet(ep, packet, &len, total ? HANDSHAKE_TIMEOUT : timeout, interrupt);
+    if (USBSIM_ACK != handshake)
+    {
+      if (total || (USBSIM_NAK != handshake))
+        usbhost_error("EP%u IN: transfer cut short", ep);
+      return -1;
+    }
+
+    if (len > mps)
+      usbhost_error("EP%u IN: packet of %u bytes", ep, len);
+    if ((total + len) > max)
+      usbhost_error("EP%u IN: transfer overruns %u bytes", ep, max);
+    else
+      memcpy(frame + total, packet, len);
+    total += len;
+
+    if (len < mps)
+      return total;
+  }
+}
+
+int usbhost_recv(const struct usbhost_ecm *ecm, void *frame, unsigned max, unsigned timeout)
+{
+  return receive(ecm->in_ep & 0x0F, ecm->in_mps, frame, max, timeout, false);
+}
+
+int usbhost_notification(const struct usbhost_ecm *ecm, void *data, unsigned max, unsigned timeout)
+{
+  return receive(ecm->notify_ep & 0x0F, ecm->notify_mps, data, max, timeout, true);
+}
@@ -0,0 +1,87 @@
+/*
+    Scripted USB host for the simulator of the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+A scripted USB host for the simulator: it enumerates the device, and then exchanges Ethernet frames with its
+(first) ECM function, much as Linux's cdc_ether would. Every transaction goes through the peripheral model (usbsim.c).
+The data toggles are kept by the host and checked against the device's; a mismatch (or anything else that a real host
+would object to) is reported on stderr and counted in usbhost_errors.
+
+Bus time is accounted in byte times (12 Mbit/s gives 1500 to a frame); once the transactions fill a frame,
+the next one begins (see sim_millisecond()). So, the simulated time is that which a real full-speed bus would take.
+*/
+
+#ifndef __USBHOST_H
+#define __USBHOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* the address given to the device by usbhost_enumerate() */
+#define USBHOST_ADDRESS 7
+
+/* what the host found in the descriptors of the first ECM function */
+struct usbhost_ecm
+{
+  uint8_t comm_itf, data_itf;          /* interface numbers */
+  uint8_t data_alt;                    /* alternate setting of the data interface with the endpoints */
+  uint8_t notify_ep, in_ep, out_ep;    /* endpoint addresses */
+  uint16_t notify_mps, in_mps, out_mps; /* wMaxPacketSize of each */
+  uint8_t mac[6];                      /* host's end of the link, from iMACAddress */
+};
+
+/* protocol errors seen since start-up */
+extern unsigned usbhost_errors;
+
+/* frames since start-up (i.e. the simulated time, ms) */
+extern uint32_t usbhost_frames;
+
+/* byte times since start-up; the simulated time in finer steps (1500 to the ms) */
+extern uint64_t usbhost_bytes;
+
+/* if set, called after each run of the firmware's main loop for the byte times that it took; otherwise it takes none */
+extern unsigned (*usbhost_cpu_time)(void);
+
+/* let the bus idle for the given number of frames */
+void usbhost_wait(unsigned ms);
+
+/* signal a bus reset, and wait for the device to recover; it is then at address 0 */
+void usbhost_reset(void);
+
+/* a control transfer on EP0; returns the length of the data stage, or -1 if the device stalled (or never answered) */
+int usbhost_control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, void *data, uint16_t wLength);
+
+/* the enumeration of Linux: descriptors, SET_ADDRESS, SET_CONFIGURATION, SET_INTERFACE and SET_ETHERNET_PACKET_FILTER */
+bool usbhost_enumerate(struct usbhost_ecm *ecm);
+
+/* bulk OUT transfer of a frame (ended by a short packet, which is zero-length if need be); false if the device never took it */
+bool usbhost_send(const struct usbhost_ecm *ecm, const void *frame, unsigned len);
+
+/* bulk IN transfer of a frame (up to a short packet); returns its length, or -1 if none arrived within timeout frames */
+int usbhost_recv(const struct usbhost_ecm *ecm, void *frame, unsigned max, unsigned timeout);
+
+/* as usbhost_recv(), but a notification from the interrupt endpoint */
+int usbhost_notification(const struct usbhost_ecm *ecm, void *data, unsigned max, unsigned timeout);
+
+#endif /* __USBHOST_H */
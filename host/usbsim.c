@@ -0,0 +1,375 @@
+/*
+    Model of the STM32F072 USB peripheral, for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+The firmware reaches the peripheral through host_usb (the registers) and host_pma (the packet memory), as it would the real thing.
+Most registers behave as plain memory would, but the EPnR registers have bits that toggle when 1 is written (DTOG_x, STAT_x)
+and bits that are cleared by writing 0 (CTR_x), so every write to them comes here, through PCD_SET_ENDPOINT().
+ISTR is recalculated whenever an EPnR changes, so that CTR, DIR and EP_ID always describe the most urgent endpoint.
+
+A transaction finds its endpoint register through the EA field (as the hardware does), and follows STAT_RX or STAT_TX.
+A single-buffered endpoint takes (or gives) one packet at its ADDR_x/COUNT_x, and then NAKs until the firmware re-validates it.
+A double-buffered bulk endpoint uses buffer DTOG (buffer 0 being the ADDR_TX/COUNT_TX pair, and buffer 1 the ADDR_RX/COUNT_RX pair),
+but only whilst DTOG differs from SW_BUF (DTOG_TX of an OUT endpoint, DTOG_RX of an IN one); otherwise, both buffers are
+the firmware's, and the host is NAKed. STAT stays VALID throughout.
+Either way, the data toggle of a transaction is the DTOG bit of its direction, which then toggles, and CTR_x is set.
+
+A SETUP is always taken by EP0 (whatever its STAT_RX), which sets SETUP, NAKs both directions, and makes the next data DATA1.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "usbsim.h"
+
+#define EP_REGS      8
+#define MAX_PACKET   64
+#define EP_TOGGLES   (USB_EP_DTOG_RX | USB_EPRX_STAT | USB_EP_DTOG_TX | USB_EPTX_STAT)
+#define EP_RW        (USB_EP_T_FIELD | USB_EP_KIND | USB_EPADDR_FIELD)
+#define EP_CTR       (USB_EP_CTR_RX | USB_EP_CTR_TX)
+
+/* BTABLE entry of an endpoint register: ADDR_TX, COUNT_TX, ADDR_RX, COUNT_RX */
+#define BT_ADDR_TX   0
+#define BT_COUNT_TX  2
+#define BT_ADDR_RX   4
+#define BT_COUNT_RX  6
+
+unsigned usbsim_errors;
+unsigned usbsim_prefilled;
+
+/* what the free buffer of each double-buffered IN endpoint held when its last packet was acknowledged */
+static struct
+{
+  bool valid;
+  unsigned len;
+  uint8_t data[MAX_PACKET];
+} staged[EP_REGS];
+
+static __IO uint16_t *epr(unsigned reg)
+{
+  return &host_usb.EP0R + 2 * reg;
+}
+
+static void usbsim_error(const char *what, unsigned reg)
+{
+  fprintf(stderr, "usbsim: EP%uR: %s\n", reg, what);
+  usbsim_errors++;
+}
+
+static bool pma_check(unsigned offset, unsigned len, unsigned reg)
+{
+  if ((offset + len) > USB_PMA_SIZE)
+  {
+    usbsim_error("PMA access out of range", reg);
+    return false;
+  }
+  return true;
+}
+
+static uint16_t btable(unsigned reg, unsigned field)
+{
+  unsigned offset = host_usb.BTABLE + 8 * reg + field;
+
+  if (!pma_check(offset, 2, reg))
+    return 0;
+  return host_pma[offset / 2];
+}
+
+static void set_btable(unsigned reg, unsigned field, uint16_t value)
+{
+  unsigned offset = host_usb.BTABLE + 8 * reg + field;
+
+  if (pma_check(offset, 2, reg))
+    host_pma[offset / 2] = value;
+}
+
+/* size of the receive buffer described by a COUNT_RX (or, when double-buffered, a COUNT_TX) entry */
+static unsigned rx_allocation(uint16_t count)
+{
+  unsigned blocks = (count >> 10) & 0x1F;
+
+  return (count & 0x8000) ? (blocks + 1) * 32 : blocks * 2;
+}
+
+static void pma_write(unsigned offset, const uint8_t *data, unsigned len, unsigned reg)
+{
+  unsigned i;
+
+  if (!pma_check(offset, len, reg))
+    return;
+  for (i = 0; i < len; i++)
+    ((uint8_t *)host_pma)[offset + i] = data[i];
+}
+
+static void pma_read(unsigned offset, uint8_t *data, unsigned len, unsigned reg)
+{
+  unsigned i;
+
+  if (!pma_check(offset, len, reg))
+    return;
+  for (i = 0; i < len; i++)
+    data[i] = ((uint8_t *)host_pma)[offset + i];
+}
+
+static bool double_buffered(uint16_t value)
+{
+  return ((value & USB_EP_T_FIELD) == USB_EP_BULK) && (value & USB_EP_KIND);
+}
+
+/* CTR, DIR and EP_ID follow the endpoint registers; isochronous and double-buffered bulk endpoints come first, then the lowest numbered */
+static void update_istr(void)
+{
+  uint16_t istr = host_usb.ISTR & ~(USB_ISTR_CTR | USB_ISTR_DIR | USB_ISTR_EP_ID);
+  uint16_t value;
+  unsigned pass, reg;
+
+  for (pass = 0; pass < 2; pass++)
+  {
+    for (reg = 0; reg < EP_REGS; reg++)
+    {
+      value = *epr(reg);
+      if (!(value & EP_CTR))
+        continue;
+      if (!pass && ((value & USB_EP_T_FIELD) != USB_EP_ISOCHRONOUS) && !double_buffered(value))
+        continue;
+
+      istr |= USB_ISTR_CTR | reg;
+      if (value & USB_EP_CTR_RX)
+        istr |= USB_ISTR_DIR;
+      host_usb.ISTR = istr;
+      return;
+    }
+  }
+
+  host_usb.ISTR = istr;
+}
+
+void usbsim_write_epr(USB_TypeDef *USBx, unsigned reg, uint16_t value)
+{
+  uint16_t old = *epr(reg);
+
+  (void)USBx;
+
+  *epr(reg) = (value & EP_RW) | (old & value & EP_CTR) | ((old ^ value) & EP_TOGGLES) | (old & USB_EP_SETUP);
+  update_istr();
+}
+
+bool usbsim_irq_pending(void)
+{
+  return (host_usb.ISTR & host_usb.CNTR & 0xFF80) != 0;
+}
+
+/* the peripheral only answers once the pull-up is on, and whilst it is neither held in reset nor powered down */
+static bool attached(void)
+{
+  return (host_usb.BCDR & USB_BCDR_DPPU) && !(host_usb.CNTR & (USB_CNTR_FRES | USB_CNTR_PDWN));
+}
+
+void usbsim_bus_reset(void)
+{
+  unsigned reg;
+
+  if (!attached())
+    return;
+
+  for (reg = 0; reg < EP_REGS; reg++)
+  {
+    *epr(reg) = 0;
+    staged[reg].valid = false;
+  }
+  host_usb.DADDR = 0;
+  host_usb.ISTR = USB_ISTR_RESET;
+}
+
+void usbsim_sof(void)
+{
+  if (!attached())
+    return;
+
+  host_usb.FNR = (host_usb.FNR & ~USB_FNR_FN) | ((host_usb.FNR + 1) & USB_FNR_FN);
+  host_usb.ISTR |= USB_ISTR_SOF;
+}
+
+/* the endpoint register that answers to a token for addr and ep, or -1 */
+static int find_endpoint(uint8_t addr, uint8_t ep)
+{
+  unsigned reg;
+
+  if (!attached() || !(host_usb.DADDR & USB_DADDR_EF) || ((host_usb.DADDR & USB_DADDR_ADD) != addr))
+    return -1;
+
+  for (reg = 0; reg < EP_REGS; reg++)
+  {
+    if ((*epr(reg) & USB_EPADDR_FIELD) == (ep & 0x0F))
+      return reg;
+  }
+  return -1;
+}
+
+enum usbsim_handshake usbsim_setup(uint8_t addr, const uint8_t setup[8])
+{
+  int reg = find_endpoint(addr, 0);
+  uint16_t value;
+
+  if ((reg < 0) || ((*epr(reg) & USB_EP_T_FIELD) != USB_EP_CONTROL))
+    return USBSIM_NONE;
+
+  if (rx_allocation(btable(reg, BT_COUNT_RX)) < 8)
+    usbsim_error("SETUP overruns the EP0 buffer", reg);
+  else
+    pma_write(btable(reg, BT_ADDR_RX), setup, 8, reg);
+  set_btable(reg, BT_COUNT_RX, (btable(reg, BT_COUNT_RX) & ~0x3FF) | 8);
+
+  value = *epr(reg) & ~(EP_TOGGLES | USB_EP_SETUP);
+  *epr(reg) = value | USB_EP_CTR_RX | USB_EP_SETUP | USB_EP_DTOG_RX | USB_EP_RX_NAK | USB_EP_DTOG_TX | USB_EP_TX_NAK;
+  update_istr();
+
+  return USBSIM_ACK;
+}
+
+enum usbsim_handshake usbsim_out(uint8_t addr, uint8_t ep, unsigned toggle, const uint8_t *data, unsigned len)
+{
+  int reg = find_endpoint(addr, ep);
+  uint16_t value;
+  unsigned addr_field, count_field, buffer;
+
+  if (reg < 0)
+    return USBSIM_NONE;
+
+  value = *epr(reg);
+
+  switch (value & USB_EPRX_STAT)
+  {
+  case USB_EP_RX_DIS:
+    return USBSIM_NONE;
+  case USB_EP_RX_STALL:
+    return USBSIM_STALL;
+  case USB_EP_RX_NAK:
+    return USBSIM_NAK;
+  }
+
+  if (double_buffered(value))
+  {
+    /* the buffer that DTOG_RX points at must have been handed over with SW_BUF (DTOG_TX) */
+    buffer = (value & USB_EP_DTOG_RX) ? 1 : 0;
+    if (buffer == ((value & USB_EP_DTOG_TX) ? 1U : 0U))
+      return USBSIM_NAK;
+    addr_field = buffer ? BT_ADDR_RX : BT_ADDR_TX;
+    count_field = buffer ? BT_COUNT_RX : BT_COUNT_TX;
+  }
+  else
+  {
+    addr_field = BT_ADDR_RX;
+    count_field = BT_COUNT_RX;
+  }
+
+  /* a repeat of a packet that was taken (but whose ACK the host missed) is ACKed again, and ignored */
+  if (toggle != ((value & USB_EP_DTOG_RX) ? 1U : 0U))
+  {
+    usbsim_error("OUT data toggle mismatch", reg);
+    return USBSIM_ACK;
+  }
+
+  if (len > rx_allocation(btable(reg, count_field)))
+  {
+    usbsim_error("OUT packet overruns its buffer", reg);
+    return USBSIM_NONE;
+  }
+
+  pma_write(btable(reg, addr_field), data, len, reg);
+  set_btable(reg, count_field, (btable(reg, count_field) & ~0x3FF) | len);
+
+  /* a single-buffered endpoint NAKs until it is re-validated; SETUP only describes the last transaction */
+  value = (value & ~USB_EP_SETUP) ^ USB_EP_DTOG_RX;
+  if (!double_buffered(value))
+    value = (value & ~USB_EPRX_STAT) | USB_EP_RX_NAK;
+  value |= USB_EP_CTR_RX;
+  *epr(reg) = value;
+  update_istr();
+
+  return USBSIM_ACK;
+}
+
+enum usbsim_handshake usbsim_in(uint8_t addr, uint8_t ep, uint8_t *data, unsigned *len, unsigned *toggle)
+{
+  int reg = find_endpoint(addr, ep);
+  uint16_t value;
+  unsigned addr_field, count_field, buffer;
+
+  if (reg < 0)
+    return USBSIM_NONE;
+
+  value = *epr(reg);
+
+  switch (value & USB_EPTX_STAT)
+  {
+  case USB_EP_TX_DIS:
+    return USBSIM_NONE;
+  case USB_EP_TX_STALL:
+    return USBSIM_STALL;
+  case USB_EP_TX_NAK:
+    return USBSIM_NAK;
+  }
+
+  if (double_buffered(value))
+  {
+    /* the buffer that DTOG_TX points at must have been handed over with SW_BUF (DTOG_RX) */
+    buffer = (value & USB_EP_DTOG_TX) ? 1 : 0;
+    if (buffer == ((value & USB_EP_DTOG_RX) ? 1U : 0U))
+      return USBSIM_NAK;
+    addr_field = buffer ? BT_ADDR_RX : BT_ADDR_TX;
+    count_field = buffer ? BT_COUNT_RX : BT_COUNT_TX;
+  }
+  else
+  {
+    addr_field = BT_ADDR_TX;
+    count_field = BT_COUNT_TX;
+  }
+
+  *len = btable(reg, count_field) & 0x3FF;
+  *toggle = (value & USB_EP_DTOG_TX) ? 1 : 0;
+  pma_read(btable(reg, addr_field), data, *len, reg);
+
+  if (double_buffered(value))
+  {
+    if (staged[reg].valid && (staged[reg].len == *len) && !memcmp(staged[reg].data, data, *len))
+      usbsim_prefilled++;
+
+    /* the other buffer, as it stands now, before the firmware hears of this acknowledgement */
+    staged[reg].len = btable(reg, buffer ? BT_COUNT_TX : BT_COUNT_RX) & 0x3FF;
+    staged[reg].valid = staged[reg].len <= MAX_PACKET;
+    if (staged[reg].valid)
+      pma_read(btable(reg, buffer ? BT_ADDR_TX : BT_ADDR_RX), staged[reg].data, staged[reg].len, reg);
+  }
+
+  value ^= USB_EP_DTOG_TX;
+  if (!double_buffered(value))
+    value = (value & ~USB_EPTX_STAT) | USB_EP_TX_NAK;
+  value |= USB_EP_CTR_TX;
+  *epr(reg) = value;
+  update_istr();
+
+  return USBSIM_ACK;
+}
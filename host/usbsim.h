@@ -0,0 +1,73 @@
+/*
+    Model of the STM32F072 USB peripheral, for the Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+The USB peripheral of the host build (host_usb and host_pma; see stm32f0xx.h) is plain memory, which this brings to life.
+The scripted USB host (usbhost.c) puts each transaction on the "bus" by calling usbsim_setup(), usbsim_out() or usbsim_in();
+the model then does to the endpoint registers, BTABLE and PMA exactly what the peripheral would, and answers with a handshake.
+Any interrupt that it raises is delivered by the simulator (see simcpu.c), which calls USB_IRQHandler().
+
+Anything that the real peripheral would quietly get wrong (a buffer that overruns its allocation, a PMA access out of range,
+an OUT packet with the wrong data toggle) is reported on stderr and counted in usbsim_errors, so that a test can fail on it.
+*/
+
+#ifndef __USBSIM_H
+#define __USBSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f0xx.h"
+
+/* the handshakes of the device; USBSIM_NONE is no answer at all (e.g. an unknown address or a disabled endpoint) */
+enum usbsim_handshake
+{
+  USBSIM_NONE,
+  USBSIM_ACK,
+  USBSIM_NAK,
+  USBSIM_STALL,
+};
+
+/* protocol errors seen since start-up */
+extern unsigned usbsim_errors;
+
+/* packets sent by double-buffered IN endpoints that were already in their buffer when the packet ahead was acknowledged
+   (i.e. the firmware only had to hand the buffer over, rather than fill it, whilst the host waited) */
+extern unsigned usbsim_prefilled;
+
+/* what writing value to an EPnR register does; PCD_SET_ENDPOINT() comes here (see stm32f0xx.h) */
+void usbsim_write_epr(USB_TypeDef *USBx, unsigned reg, uint16_t value);
+
+/* whether the peripheral is asking for its interrupt */
+bool usbsim_irq_pending(void);
+
+/* bus events */
+void usbsim_bus_reset(void);
+void usbsim_sof(void);
+
+/* transactions; toggle is the data PID (0 for DATA0, 1 for DATA1) */
+enum usbsim_handshake usbsim_setup(uint8_t addr, const uint8_t setup[8]);
+enum usbsim_handshake usbsim_out(uint8_t addr, uint8_t ep, unsigned toggle, const uint8_t *data, unsigned len);
+enum usbsim_handshake usbsim_in(uint8_t addr, uint8_t ep, uint8_t *data, unsigned *len, unsigned *toggle);
+
+#endif /* __USBSIM_H */
@@ -0,0 +1,93 @@
+/*
+    Link layer beneath the network services
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+main.c's network services (lwIP glue, DHCP, DNS, HTTP and the timers) only reach the Ethernet link through the link_* names below.
+In the firmware, these are simply the usb_ecm_* functions of the ECM (or NCM) class, so there is no extra layer;
+with LINK_TAP set, they are provided by taplink.c instead, which exchanges frames with a Linux TAP interface.
+
+index is the number (from 0 to NUM_OF_ECM - 1) of the link concerned.
+link_recv_callback() is provided by the services: it is offered each received frame (as a PBUF_POOL pbuf),
+and returns true to take ownership of it, or false to have the frame held (and the link paused) until link_recv_renew().
+link_xmit_callback() is also provided by the services: it is called once a frame has been sent, so that link_xmit_reclaim()
+has a pbuf to release. Both callbacks may be called from an ISR, and must not block.
+*/
+
+#ifndef __LINK_H
+#define __LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/pbuf.h"
+
+/* set to 1 for a Linux host build over TAP interfaces (see taplink.c) */
+#ifndef LINK_TAP
+#define LINK_TAP 0
+#endif
+
+#if LINK_TAP
+
+/* number of links; in the firmware, this is the number of ECM functions */
+#ifndef NUM_OF_ECM
+#define NUM_OF_ECM 1
+#endif
+
+bool link_recv_callback(unsigned index, struct pbuf *frame);
+void link_recv_renew(unsigned index);
+void link_xmit_callback(unsigned index);
+bool link_xmit_packet(unsigned index, struct pbuf *p);
+void link_xmit_reclaim(unsigned index);
+void link_set_hwaddr(unsigned index, const uint8_t *hwaddr);
+void link_set_link(unsigned index, bool up);
+
+/* opens the TAP interfaces (named tap0, tap1 and so on) */
+bool link_open(void);
+/* waits up to timeout_ms (or forever, if negative) for a frame from any link, and offers what has arrived to link_recv_callback() */
+void link_poll(int timeout_ms);
+
+#else
+
+#include "usbd_ecm.h"
+
+#define link_recv_callback  usb_ecm_recv_callback
+#define link_recv_renew     usb_ecm_recv_renew
+#define link_xmit_callback  usb_ecm_xmit_callback
+#define link_xmit_packet    usb_ecm_xmit_packet
+#define link_xmit_reclaim   usb_ecm_xmit_reclaim
+#define link_set_hwaddr     usb_ecm_set_hwaddr
+#define link_set_link       usb_ecm_set_link
+
+#endif
+
+/* the services queue received frames (per link) for the main loop; rx_ring_get_stats() reports how that queue has fared */
+struct rx_ring_stats
+{
+  unsigned occupancy;      /* frames presently waiting for service_traffic() */
+  unsigned high_water;     /* largest occupancy seen */
+  uint32_t overflows;      /* frames that found the ring full (and were held back by the link) */
+};
+
+void rx_ring_get_stats(unsigned index, struct rx_ring_stats *stats);
+
+#endif /* __LINK_H */
@@ -46,6 +46,7 @@
 #include "lwip/snmp.h"
 #include "lwip/stats.h"
 #include "lwip/icmp.h"
+#include "lwip/timers.h"
 
 #include <string.h>
 
@@ -145,6 +146,15 @@ ip_reass_tmr(void)
    }
 }
 
+/**
+ * MODIFIED: Reports whether any datagram is being reassembled (and so needs ip_reass_tmr())
+ */
+u8_t
+ip_reass_active(void)
+{
+  return reassdatagrams != NULL;
+}
+
 /**
  * Free a datagram (struct ip_reassdata) and all its pbufs.
  * Updates the total count of enqueued pbufs (ip_reass_pbufcount),
@@ -290,6 +300,10 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
   /* enqueue the new structure to the front of the list */
   ipr->next = reassdatagrams;
   reassdatagrams = ipr;
+#if LWIP_TIMERS
+  /* MODIFIED: the new datagram needs aging */
+  ip_reass_timer_needed();
+#endif /* LWIP_TIMERS */
   /* copy the ip header for later tests and input */
   /* @todo: no ip options supported? */
   SMEMCPY(&(ipr->iphdr), fraghdr, IP_HLEN);
@@ -1064,6 +1064,65 @@ pbuf_fill_chksum(struct pbuf *p, u16_t start_offset, const void *dataptr,
   *chksum = FOLD_U32T(acc);
   return ERR_OK;
 }
+
+/**
+ * MODIFIED: Copies data into a pbuf chain at an offset, like pbuf_take(), and
+ * updates the checksum while copying (see udp_sendto_chksum()).
+ * Unlike pbuf_fill_chksum(), the data may span several pbufs.
+ *
+ * @param buf pbuf chain to copy data into
+ * @param dataptr data to copy into the pbuf chain
+ * @param len length of data to copy into the pbuf chain
+ * @param offset offset into buf where to copy the data to
+ * @param chksum pointer to the checksum which is updated
+ * @return ERR_OK if successful, ERR_ARG if the data does not fit
+ */
+err_t
+pbuf_take_chksum(struct pbuf *buf, const void *dataptr, u16_t len, u16_t offset,
+                 u16_t *chksum)
+{
+  struct pbuf *p;
+  u16_t buf_copy_len;
+  u16_t copy_chksum;
+  u16_t copied_total = 0;
+  u16_t pos = offset;
+  u32_t acc;
+
+  LWIP_ERROR("pbuf_take_chksum: invalid buf", (buf != NULL), return ERR_ARG;);
+  LWIP_ERROR("pbuf_take_chksum: invalid dataptr", (dataptr != NULL), return ERR_ARG;);
+  LWIP_ERROR("pbuf_take_chksum: invalid chksum", (chksum != NULL), return ERR_ARG;);
+
+  if ((u32_t)offset + len > buf->tot_len) {
+    return ERR_ARG;
+  }
+
+  /* find the pbuf holding offset */
+  for (p = buf; offset >= p->len; p = p->next) {
+    offset -= p->len;
+  }
+
+  acc = *chksum;
+  for (; copied_total < len; p = p->next) {
+    LWIP_ASSERT("pbuf_take_chksum: invalid pbuf", p != NULL);
+    buf_copy_len = p->len - offset;
+    if (buf_copy_len > len - copied_total) {
+      buf_copy_len = len - copied_total;
+    }
+    copy_chksum = LWIP_CHKSUM_COPY((u8_t*)p->payload + offset,
+                                   (const u8_t*)dataptr + copied_total, buf_copy_len);
+    /* the copy's checksum is as if it started at an even position in the packet */
+    if ((pos & 1) != 0) {
+      copy_chksum = SWAP_BYTES_IN_WORD(copy_chksum);
+    }
+    acc += copy_chksum;
+    acc = FOLD_U32T(acc);
+    pos += buf_copy_len;
+    copied_total += buf_copy_len;
+    offset = 0;
+  }
+  *chksum = (u16_t)acc;
+  return ERR_OK;
+}
 #endif /* LWIP_CHECKSUM_ON_COPY */
 
  /** Get one byte from the specified position in a pbuf
@@ -653,6 +653,10 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
     last_unsent->len += concat_p->tot_len;
 #if TCP_CHECKSUM_ON_COPY
     if (concat_chksummed) {
+      /* MODIFIED: concat_chksum is kept byte-swapped after an odd length (as in lwIP 2.x); undo that before adding it */
+      if (concat_chksum_swapped) {
+        concat_chksum = SWAP_BYTES_IN_WORD(concat_chksum);
+      }
       tcp_seg_add_chksum(concat_chksum, concat_chksummed, &last_unsent->chksum,
         &last_unsent->chksum_swapped);
       last_unsent->flags |= TF_SEG_DATA_CHECKSUMMED;
@@ -1052,6 +1056,15 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
   struct netif *netif;
   u32_t *opts;
 
+  if (seg->p->ref != 1) {
+    /* MODIFIED: This can happen if the pbuf of this segment is still referenced by the
+       netif driver due to deferred transmission. Since this function modifies
+       p->len and p->payload, we must not continue in this case (as in lwIP 2.x).
+       tcp_output() still moves the skipped segment onto pcb->unacked, so it is
+       not sent now, but only when the retransmission timer (RTO) expires. */
+    return;
+  }
+
   /** @bug Exclude retransmitted segments from this count. */
   snmp_inc_tcpoutsegs();
 
@@ -110,6 +110,9 @@ tcp_timer_needed(void)
 #endif /* LWIP_TCP */
 
 #if IP_REASSEMBLY
+/** MODIFIED: global variable that shows if the reassembly timer is currently scheduled or not */
+static int ip_reass_timer_active;
+
 /**
  * Timer callback function that calls ip_reass_tmr() and reschedules itself.
  *
@@ -121,11 +124,32 @@ ip_reass_timer(void *arg)
   LWIP_UNUSED_ARG(arg);
   LWIP_DEBUGF(TIMERS_DEBUG, ("tcpip: ip_reass_tmr()\n"));
   ip_reass_tmr();
-  sys_timeout(IP_TMR_INTERVAL, ip_reass_timer, NULL);
+  /* MODIFIED: timer still needed? */
+  if (ip_reass_active()) {
+    sys_timeout(IP_TMR_INTERVAL, ip_reass_timer, NULL);
+  } else {
+    ip_reass_timer_active = 0;
+  }
+}
+
+/**
+ * MODIFIED: Called by ip_frag.c when it starts reassembling a datagram,
+ * so that the reassembly timer only runs whilst there are datagrams to age.
+ */
+void
+ip_reass_timer_needed(void)
+{
+  if (!ip_reass_timer_active) {
+    ip_reass_timer_active = 1;
+    sys_timeout(IP_TMR_INTERVAL, ip_reass_timer, NULL);
+  }
 }
 #endif /* IP_REASSEMBLY */
 
 #if LWIP_ARP
+/** MODIFIED: global variable that shows if the ARP timer is currently scheduled or not */
+static int arp_timer_active;
+
 /**
  * Timer callback function that calls etharp_tmr() and reschedules itself.
  *
@@ -137,7 +161,25 @@ arp_timer(void *arg)
   LWIP_UNUSED_ARG(arg);
   LWIP_DEBUGF(TIMERS_DEBUG, ("tcpip: etharp_tmr()\n"));
   etharp_tmr();
-  sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
+  /* MODIFIED: timer still needed? */
+  if (etharp_active()) {
+    sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
+  } else {
+    arp_timer_active = 0;
+  }
+}
+
+/**
+ * MODIFIED: Called by etharp.c when it adds a (non-static) entry to the ARP table,
+ * so that the ARP timer only runs whilst there are entries to age.
+ */
+void
+etharp_timer_needed(void)
+{
+  if (!arp_timer_active) {
+    arp_timer_active = 1;
+    sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
+  }
 }
 #endif /* LWIP_ARP */
 
@@ -222,12 +264,7 @@ dns_timer(void *arg)
 /** Initialize this module */
 void sys_timeouts_init(void)
 {
-#if IP_REASSEMBLY
-  sys_timeout(IP_TMR_INTERVAL, ip_reass_timer, NULL);
-#endif /* IP_REASSEMBLY */
-#if LWIP_ARP
-  sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
-#endif /* LWIP_ARP */
+  /* MODIFIED: the reassembly and ARP timers are started on demand (see ip_reass_timer_needed() and etharp_timer_needed()) */
 #if LWIP_DHCP
   sys_timeout(DHCP_COARSE_TIMER_MSECS, dhcp_timer_coarse, NULL);
   sys_timeout(DHCP_FINE_TIMER_MSECS, dhcp_timer_fine, NULL);
@@ -267,12 +304,25 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 #endif /* LWIP_DEBUG_TIMERNAMES */
 {
   struct sys_timeo *timeout, *t;
+#if NO_SYS
+  u32_t now;
+#endif /* NO_SYS */
 
   timeout = (struct sys_timeo *)memp_malloc(MEMP_SYS_TIMEOUT);
   if (timeout == NULL) {
     LWIP_ASSERT("sys_timeout: timeout != NULL, pool MEMP_SYS_TIMEOUT is empty", timeout != NULL);
     return;
   }
+#if NO_SYS
+  /* MODIFIED: the list counts from timeouts_last_time, not from now; an empty list starts counting afresh */
+  now = sys_now();
+  if (next_timeout == NULL) {
+    timeouts_last_time = now;
+  } else {
+    msecs += now - timeouts_last_time;
+  }
+#endif /* NO_SYS */
+
   timeout->next = NULL;
   timeout->h = handler;
   timeout->arg = arg;
@@ -399,6 +449,26 @@ sys_check_timeouts(void)
   }
 }
 
+/**
+ * MODIFIED: Time until sys_check_timeouts() next has something to do
+ *
+ * @return milliseconds (0 if a timeout has already expired), or 0xffffffff if no timeout is pending
+ */
+u32_t
+sys_timeouts_sleeptime(void)
+{
+  u32_t diff;
+
+  if (next_timeout == NULL) {
+    return 0xffffffff;
+  }
+  diff = sys_now() - timeouts_last_time;
+  if (diff >= next_timeout->time) {
+    return 0;
+  }
+  return next_timeout->time - diff;
+}
+
 /** Set back the timestamp of the last call to sys_check_timeouts()
  * This is necessary if sys_check_timeouts() hasn't been called for a long
  * time (e.g. while saving energy) to prevent all timer functions of that
@@ -62,6 +62,7 @@ struct ip_reassdata {
 
 void ip_reass_init(void);
 void ip_reass_tmr(void);
+u8_t ip_reass_active(void);
 struct pbuf * ip_reass(struct pbuf *p);
 #endif /* IP_REASSEMBLY */
 
@@ -164,6 +164,9 @@ struct pbuf *pbuf_coalesce(struct pbuf *p, pbuf_layer layer);
 #if LWIP_CHECKSUM_ON_COPY
 err_t pbuf_fill_chksum(struct pbuf *p, u16_t start_offset, const void *dataptr,
                        u16_t len, u16_t *chksum);
+/* MODIFIED: chain-aware pbuf_take() that checksums while copying */
+err_t pbuf_take_chksum(struct pbuf *buf, const void *dataptr, u16_t len,
+                       u16_t offset, u16_t *chksum);
 #endif /* LWIP_CHECKSUM_ON_COPY */
 
 u8_t pbuf_get_at(struct pbuf* p, u16_t offset);
@@ -84,9 +84,16 @@ void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg);
 #endif /* LWIP_DEBUG_TIMERNAMES */
 
 void sys_untimeout(sys_timeout_handler handler, void *arg);
+#if IP_REASSEMBLY
+void ip_reass_timer_needed(void);
+#endif /* IP_REASSEMBLY */
+#if LWIP_ARP
+void etharp_timer_needed(void);
+#endif /* LWIP_ARP */
 #if NO_SYS
 void sys_check_timeouts(void);
 void sys_restart_timeouts(void);
+u32_t sys_timeouts_sleeptime(void);
 #else /* NO_SYS */
 void sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg);
 #endif /* NO_SYS */
@@ -34,6 +34,7 @@
 
 /* Prevent having to link sys_arch.c (we don't test the API layers in unit tests) */
 #define NO_SYS                          1
+#define SYS_LIGHTWEIGHT_PROT            1 /* pbufs are allocated from the USB ISR */
 #define MEM_ALIGNMENT                   4
 #define LWIP_RAW                        1
 #define LWIP_NETCONN                    0
@@ -49,6 +50,22 @@
 #define TCP_SND_BUF                     (2 * TCP_MSS)
 
 #define ETHARP_SUPPORT_STATIC_ENTRIES   1
+#define LWIP_NETIF_LINK_CALLBACK        1 /* link changes are notified to the host */
+
+/* checksum summing a word at a time (see chksum.c) */
+#ifndef LWIP_CHKSUM
+#define LWIP_CHKSUM                     fast_chksum
+unsigned short fast_chksum(void *dataptr, int len);
+#endif
+
+/* data copied into pbufs (tcp_write() with TCP_WRITE_FLAG_COPY, pbuf_take_chksum()) is checksummed as it is copied,
+   so that tcp_output() and udp_sendto_chksum() needn't read it again; LWIP_CHKSUM_COPY is lwIP's own, a copy then
+   LWIP_CHKSUM of the copy while it is fresh (chksum.c's fused fast_chksum_copy() is no faster; see there) */
+#define LWIP_CHECKSUM_ON_COPY           1
+/* 1 checks every TCP segment's checksum against one computed the slow way (and sends the latter) */
+#ifndef TCP_CHECKSUM_ON_COPY_SANITY_CHECK
+#define TCP_CHECKSUM_ON_COPY_SANITY_CHECK 0
+#endif
 
 #define LWIP_HTTPD_CGI                  1
 #define LWIP_HTTPD_SSI                  1
@@ -180,6 +180,7 @@ struct etharp_q_entry {
 
 #define etharp_init() /* Compatibility define, not init needed. */
 void etharp_tmr(void);
+u8_t etharp_active(void);
 s8_t etharp_find_addr(struct netif *netif, ip_addr_t *ipaddr,
          struct eth_addr **eth_ret, ip_addr_t **ip_ret);
 err_t etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr);
@@ -55,6 +55,7 @@
 #include "lwip/dhcp.h"
 #include "lwip/autoip.h"
 #include "netif/etharp.h"
+#include "lwip/timers.h"
 
 #if PPPOE_SUPPORT
 #include "netif/ppp_oe.h"
@@ -241,6 +242,27 @@ etharp_tmr(void)
   }
 }
 
+/**
+ * MODIFIED: Reports whether the ARP table holds any entries that etharp_tmr() needs to age
+ */
+u8_t
+etharp_active(void)
+{
+  u8_t i;
+
+  for (i = 0; i < ARP_TABLE_SIZE; ++i) {
+    u8_t state = arp_table[i].state;
+    if (state != ETHARP_STATE_EMPTY
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+      && (state != ETHARP_STATE_STATIC)
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
+      ) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /**
  * Search the ARP table for a matching or new entry.
  * 
@@ -476,6 +498,10 @@ etharp_update_arp_entry(struct netif *netif, ip_addr_t *ipaddr, struct eth_addr
   {
     /* mark it stable */
     arp_table[i].state = ETHARP_STATE_STABLE;
+#if LWIP_TIMERS
+    /* MODIFIED: the entry needs aging */
+    etharp_timer_needed();
+#endif /* LWIP_TIMERS */
   }
 
   /* record network interface */
@@ -1043,6 +1069,10 @@ etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q)
   /* mark a fresh entry as pending (we just sent a request) */
   if (arp_table[i].state == ETHARP_STATE_EMPTY) {
     arp_table[i].state = ETHARP_STATE_PENDING;
+#if LWIP_TIMERS
+    /* MODIFIED: the entry needs aging */
+    etharp_timer_needed();
+#endif /* LWIP_TIMERS */
   }
 
   /* { i is either a STABLE or (new or existing) PENDING entry } */
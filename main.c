@@ -26,8 +26,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "usbd_ecm.h"
+#include "usbd_ncm.h"
 #include "usbd_desc.h"
 #include "usbd_conf.h"
+#include "usbprof.h"
+#include "link.h"
 #include "netif/etharp.h"
 #include "lwip/init.h"
 #include "lwip/netif.h"
@@ -41,6 +44,7 @@
 #include "lwip/dns.h"
 #include "lwip/tcp_impl.h"
 #include "lwip/tcp.h"
+#include "lwip/timers.h"
 #include "time.h"
 #include "httpd.h"
 #include "dhserver.h"
@@ -49,12 +53,44 @@
 /* main USB handle used throughout the USB driver code */
 USBD_HandleTypeDef USBD_Device;
 
-static struct netif netif_data;
-static uint8_t hwaddr[6]  = {0x20,0x89,0x84,0x6A,0x96,0x00};
-static uint8_t ipaddr[4]  = {192, 168, 7, 1};
+/* one netif per ECM function; DHCP and DNS are only served on the first */
+static struct netif netif_data[NUM_OF_ECM];
+static uint8_t hwaddr[NUM_OF_ECM][6] =
+{
+  {0x20,0x89,0x84,0x6A,0x96,0x00},
+#if (NUM_OF_ECM > 1)
+  {0x20,0x89,0x84,0x6A,0x96,0x01},
+#endif
+};
+static uint8_t ipaddr[NUM_OF_ECM][4] =
+{
+  {192, 168, 7, 1},
+#if (NUM_OF_ECM > 1)
+  {192, 168, 8, 1},
+#endif
+};
 static uint8_t netmask[4] = {255, 255, 255, 0};
 static uint8_t gateway[4] = {0, 0, 0, 0};
-static struct pbuf *received_frame;
+
+/* number of received frames that can be held between the USB ISR and service_traffic(); must be a power of two */
+#ifndef RX_RING_SIZE
+#define RX_RING_SIZE 4
+#endif
+
+#if (RX_RING_SIZE & (RX_RING_SIZE - 1)) || (RX_RING_SIZE < 2)
+#error RX_RING_SIZE must be a power of two
+#endif
+
+/* free-running indices; head is only advanced by the ISR and tail only by service_traffic() */
+struct rx_ring
+{
+  struct pbuf *volatile frames[RX_RING_SIZE];
+  volatile unsigned head, tail;
+  struct rx_ring_stats stats;
+};
+
+/* one ring per ECM function, so that a backlog on one never holds up another */
+static struct rx_ring rx_rings[NUM_OF_ECM];
 
 static dhcp_entry_t entries[] =
 {
@@ -73,21 +109,49 @@ static dhcp_config_t dhcp_config =
     entries               /* entries */
 };
 
-/* this function is called by usbd_ecm.c during an ISR; it must not block */
-void usb_ecm_recv_callback(const uint8_t *data, int size)
+/* this function is called by usbd_ecm.c during an ISR (see link.h); it must not block */
+bool link_recv_callback(unsigned index, struct pbuf *frame)
 {
-  if (received_frame)
-    return;
+  struct rx_ring *ring = &rx_rings[index];
+  unsigned occupancy;
 
-  received_frame = pbuf_alloc(PBUF_RAW, size, PBUF_POOL);
-  if (!received_frame)
+  occupancy = ring->head - ring->tail;
+  if (occupancy >= RX_RING_SIZE)
   {
-    usb_ecm_recv_renew();
-    return;
+    /* no room; usbd_ecm.c holds onto the frame until service_traffic() calls link_recv_renew() */
+    ring->stats.overflows++;
+    return false;
   }
 
-  memcpy(received_frame->payload, data, size);
-  received_frame->len = size;
+  ring->frames[ring->head % RX_RING_SIZE] = frame;
+  ring->head++;
+
+  if (++occupancy > ring->stats.high_water)
+    ring->stats.high_water = occupancy;
+
+  /* wake the main loop */
+  event_post(EVENT_USB);
+
+  return true;
+}
+
+/* likewise called during an ISR, once a frame has been sent; its pbuf is released by link_xmit_reclaim() in service_traffic() */
+void link_xmit_callback(unsigned index)
+{
+  (void)index;
+
+  /* wake the main loop */
+  event_post(EVENT_USB);
+}
+
+void rx_ring_get_stats(unsigned index, struct rx_ring_stats *stats)
+{
+  struct rx_ring *ring = &rx_rings[index];
+
+  __disable_irq();
+  *stats = ring->stats;
+  stats->occupancy = ring->head - ring->tail;
+  __enable_irq();
 }
 
 uint32_t sys_now()
@@ -95,9 +159,49 @@ uint32_t sys_now()
     return (uint32_t)mtime();
 }
 
-TIMER_PROC(tcp_timer, TCP_TMR_INTERVAL, 1, NULL)
+/* pbufs are allocated by usbd_ecm.c in the USB ISR, so lwIP's pools need protecting from it */
+sys_prot_t sys_arch_protect(void)
+{
+    sys_prot_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
 {
-    tcp_tmr();
+    __set_PRIMASK(pval);
+}
+
+/*
+lwIP's own timeouts (TCP, ARP aging, IP reassembly) are only scheduled whilst each has work to do (see timers.c);
+lwip_timer is kept running until the soonest of them, and is stopped whilst there are none
+*/
+static stmr_t lwip_timer;
+
+static void lwip_timer_update(void)
+{
+    u32_t sleeptime = sys_timeouts_sleeptime();
+
+    if (sleeptime == 0xffffffff)
+    {
+        stmr_stop(&lwip_timer);
+        return;
+    }
+
+    /* only ever brought forward (by a new timeout) here; lwip_timer_proc() reschedules it afresh */
+    if (!(lwip_timer.flags & STMR_ACTIVE) || (int32_t)(mtime() + sleeptime - (lwip_timer.event + lwip_timer.period)) < 0)
+    {
+        lwip_timer.period = sleeptime;
+        stmr_run(&lwip_timer);
+    }
+}
+
+static void lwip_timer_proc(stmr_t *tmr)
+{
+    sys_check_timeouts();
+
+    stmr_stop(tmr);
+    lwip_timer_update();
 }
 
 err_t output_fn(struct netif *netif, struct pbuf *p, ip_addr_t *ipaddr)
@@ -107,16 +211,14 @@ err_t output_fn(struct netif *netif, struct pbuf *p, ip_addr_t *ipaddr)
 
 err_t linkoutput_fn(struct netif *netif, struct pbuf *p)
 {
-    int i;
-    for (i = 0; i < 200; i++)
-    {
-        if (usb_ecm_can_xmit()) goto ready;
-        msleep(1);
-    }
-    return ERR_USE;
-ready:
-    usb_ecm_xmit_packet(p);
-    return ERR_OK;
+    /* the packet is queued (or dropped) without waiting for the host */
+    return link_xmit_packet(netif - netif_data, p) ? ERR_OK : ERR_MEM;
+}
+
+/* netif_set_link_up()/netif_set_link_down() are passed on to the host as a NETWORK_CONNECTION notification */
+void link_callback(struct netif *netif)
+{
+    link_set_link(netif - netif_data, netif_is_link_up(netif));
 }
 
 err_t netif_init_cb(struct netif *netif)
@@ -136,23 +238,35 @@ err_t netif_init_cb(struct netif *netif)
 
 static void init_lwip()
 {
-    struct netif  *netif = &netif_data;
+    struct netif  *netif;
+    unsigned index;
 
     lwip_init();
-    netif->hwaddr_len = 6;
-    memcpy(netif->hwaddr, hwaddr, 6);
 
-    netif = netif_add(netif, PADDR(ipaddr), PADDR(netmask), PADDR(gateway), NULL, netif_init_cb, ip_input);
-    netif_set_default(netif);
+    for (index = 0; index < NUM_OF_ECM; index++)
+    {
+        netif = &netif_data[index];
+        netif->hwaddr_len = 6;
+        memcpy(netif->hwaddr, hwaddr[index], 6);
+
+        netif_add(netif, PADDR(ipaddr[index]), PADDR(netmask), PADDR(gateway), NULL, netif_init_cb, ip_input);
+        netif_set_link_callback(netif, link_callback);
+
+        /* frames from the host addressed to anyone else are dropped in the USB ISR */
+        link_set_hwaddr(index, hwaddr[index]);
+    }
 
-    stmr_add(&tcp_timer);
+    netif_set_default(&netif_data[0]);
+
+    stmr_init(&lwip_timer);
+    lwip_timer.proc = lwip_timer_proc;
 }
 
 bool dns_query_proc(const char *name, ip_addr_t *addr)
 {
     if (strcmp(name, "run.stm") == 0 || strcmp(name, "www.run.stm") == 0)
     {
-        addr->addr = *(uint32_t *)ipaddr;
+        addr->addr = *(uint32_t *)ipaddr[0];
         return true;
     }
     return false;
@@ -185,7 +299,9 @@ static const char *ssi_tags_table[] =
     "systick", /* 0 */
     "alpha",   /* 1 */
     "bravo",   /* 2 */
-    "charlie"  /* 3 */
+    "charlie", /* 3 */
+    "loops",   /* 4 */
+    "idle"     /* 5 */
 };
 
 static const tCGI cgi_uri_table[] =
@@ -194,9 +310,24 @@ static const tCGI cgi_uri_table[] =
     { "/ctl.cgi",   ctl_cgi_handler },
 };
 
+/* passes of the main loop, and how long it has spent asleep; see main() */
+struct loop_stats
+{
+    uint32_t iterations;
+    uint64_t idle_cycles;
+    uint64_t total_cycles;
+};
+
+static struct loop_stats loop_stats;
+
+static unsigned loop_idle_percent(void)
+{
+    return loop_stats.total_cycles ? (unsigned)(loop_stats.idle_cycles * 100 / loop_stats.total_cycles) : 0;
+}
+
 static u16_t ssi_handler(int index, char *insert, int ins_len)
 {
-    int res;
+    int res = 0;
 
     if (ins_len < 32) return 0;
 
@@ -217,6 +348,12 @@ static u16_t ssi_handler(int index, char *insert, int ins_len)
         *insert = '0' + (charlie & 1);
         res = 1;
         break;
+    case 4: /* loops */
+        res = snprintf(insert, ins_len, "%u", (unsigned)loop_stats.iterations);
+        break;
+    case 5: /* idle */
+        res = snprintf(insert, ins_len, "%u", loop_idle_percent());
+        break;
     }
 
     return res;
@@ -224,23 +361,29 @@ static u16_t ssi_handler(int index, char *insert, int ins_len)
 
 static void service_traffic(void)
 {
+  struct rx_ring *ring;
   struct pbuf *frame;
+  unsigned index;
 
-  /* retrieve and clear var set by usb_ecm_recv_callback() in ISR */
-  __disable_irq();
-  frame = received_frame;
-  received_frame = NULL;
-  __enable_irq();
+  for (index = 0; index < NUM_OF_ECM; index++)
+  {
+    ring = &rx_rings[index];
 
-  if (!frame)
-    return; /* no packet was received */
+    /* release the frames that usbd_ecm.c has finished sending */
+    link_xmit_reclaim(index);
 
-  /* packet was received, so handle it */
-  ethernet_input(frame, &netif_data);
-  pbuf_free(frame);
+    /* drain the frames queued by link_recv_callback() in ISR */
+    while (ring->tail != ring->head)
+    {
+      frame = ring->frames[ring->tail % RX_RING_SIZE];
+      ring->tail++;
 
-  /* tell usbd_ecm.c it is OK to receive another packet */
-  usb_ecm_recv_renew();
+      ethernet_input(frame, &netif_data[index]);
+
+      /* tell usbd_ecm.c there is room (and a free pbuf) for any frame it is holding onto */
+      link_recv_renew(index);
+    }
+  }
 }
 
 /* helper function in stm32f0xx_hal_helper.c */
@@ -248,40 +391,92 @@ void SystemClock_Config(void);
 
 int main(void)
 {
+  uint32_t pending, now, last;
+
   /* initialize ST's HAL */
   HAL_Init();
   
   /* Configure the system clock to get correspondent USB clock source */
   SystemClock_Config();
   
+#if LINK_TAP
+  /* the links are TAP interfaces of the Linux host (see taplink.c) rather than ECM functions */
+  if (!link_open())
+    return 1;
+#else
   /* Init Device Library */
   USBD_Init(&USBD_Device, &VCP_Desc, 0);
   
+#if USBD_USE_NCM
+  /* Add Supported Class */
+  USBD_RegisterClass(&USBD_Device, &USBD_NCM);
+  
+  /* Add NCM Interface Class */
+  USBD_NCM_RegisterInterface(&USBD_Device);
+#else
   /* Add Supported Class */
   USBD_RegisterClass(&USBD_Device, &USBD_ECM);
   
   /* Add ECM Interface Class */
   USBD_ECM_RegisterInterface(&USBD_Device);
+#endif
   
   /* Start Device Process */
   USBD_Start(&USBD_Device);
+#endif
   
   time_init();
   init_lwip();
 
-  while (!netif_is_up(&netif_data));
+  while (!netif_is_up(&netif_data[0]));
 
   while (dhserv_init(&dhcp_config) != ERR_OK);
 
-  while (dnserv_init(PADDR(ipaddr), 53, dns_query_proc) != ERR_OK);
+  while (dnserv_init(PADDR(ipaddr[0]), 53, dns_query_proc) != ERR_OK);
 
   http_set_cgi_handlers(cgi_uri_table, sizeof(cgi_uri_table) / sizeof(*cgi_uri_table));
   http_set_ssi_handler(ssi_handler, ssi_tags_table, sizeof(ssi_tags_table) / sizeof(*ssi_tags_table));
   httpd_init();
 
+  last = cycletime();
+
   for (;;)
   {
-    service_traffic();
-    stmr();
+    /*
+    sleep until an interrupt handler has something for us; WFI still wakes for an interrupt that is masked,
+    which is then serviced (between enabling and disabling them again) before events is checked once more;
+    a SysTick with no timer due (see next_deadline()) posts nothing, and nor does a USB interrupt with no frame
+    received or sent (e.g. SOF), and so the loop just goes back to sleep
+    */
+    __disable_irq();
+    while (!events)
+    {
+      now = cycletime();
+      __WFI();
+      loop_stats.idle_cycles += cycletime() - now;
+      __enable_irq();
+      __ISB();
+      __disable_irq();
+    }
+    pending = events;
+    events = 0;
+    __enable_irq();
+
+    if (pending & EVENT_USB)
+      service_traffic();
+    if (pending & EVENT_TICK)
+      stmr();
+
+    /* the traffic (or a timer) may have given lwIP a new timeout */
+    lwip_timer_update();
+#if USB_PROFILE
+    /* keep the ring of USB handler timings from filling; read the results with usb_prof_get_stats() */
+    usb_prof_collect();
+#endif
+
+    now = cycletime();
+    loop_stats.total_cycles += now - last;
+    last = now;
+    loop_stats.iterations++;
   }
 }
@@ -106,6 +106,18 @@
   */
 static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd);
 void PCD_WritePMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes);
+static HAL_StatusTypeDef PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint8_t *pBuf, const uint8_t *(*gather)(void *context, uint16_t *len), void *context, uint32_t len, uint8_t zlp);
+static void PCD_WriteTxPMA(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t wPMABufAddr, uint16_t wNBytes);
+static void PCD_EP_TxNext(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static void PCD_EP_RxNext(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static void PCD_EP_RxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static void PCD_EP_TxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static void PCD_DbufTxFill(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static void PCD_DbufTxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static uint8_t PCD_DbufRxTake(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static void PCD_DbufRxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep);
+static __IO uint16_t *PCD_CopyToPMA(__IO uint16_t *pdwVal, const uint8_t *pbUsrBuf, uint32_t n);
+static void PCD_CopyFromPMA(uint8_t *pbUsrBuf, __IO uint16_t *pdwVal, uint32_t n);
 void PCD_ReadPMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes);
 /**
   * @}
@@ -327,10 +339,9 @@ HAL_StatusTypeDef HAL_PCD_Stop(PCD_HandleTypeDef *hpcd)
 static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
 {
   PCD_EPTypeDef *ep;
-  uint16_t count=0;
   uint8_t EPindex;
-  __IO uint16_t wIstr;  
-  __IO uint16_t wEPVal = 0;
+  uint16_t wIstr; /* MODIFIED: snapshots of the registers need not be volatile (i.e. kept on the stack) */
+  uint16_t wEPVal = 0;
   
   /* stay in loop while pending interrupts */
   while (((wIstr = hpcd->Instance->ISTR) & USB_ISTR_CTR) != 0)
@@ -338,6 +349,22 @@ static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
     /* extract highest priority endpoint number */
     EPindex = (uint8_t)(wIstr & USB_ISTR_EP_ID);
     
+    /* MODIFIED: the endpoints of Init.fast_ep_mask are bulk and one-way, so their interrupts need none of the decoding below */
+    if ((1U << EPindex) & hpcd->Init.fast_ep_mask)
+    {
+      if ((wIstr & USB_ISTR_DIR) != 0)
+      {
+        PCD_CLEAR_RX_EP_CTR(hpcd->Instance, EPindex);
+        PCD_EP_RxComplete(hpcd, &hpcd->OUT_ep[EPindex]);
+      }
+      else
+      {
+        PCD_CLEAR_TX_EP_CTR(hpcd->Instance, EPindex);
+        PCD_EP_TxComplete(hpcd, &hpcd->IN_ep[EPindex]);
+      }
+      continue;
+    }
+
     if (EPindex == 0)
     {
       /* Decode and service control endpoint interrupt */
@@ -420,50 +447,8 @@ static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
         PCD_CLEAR_RX_EP_CTR(hpcd->Instance, EPindex);
         ep = &hpcd->OUT_ep[EPindex];
         
-        /* OUT double Buffering*/
-        if (ep->doublebuffer == 0)
-        {
-          count = PCD_GET_EP_RX_CNT(hpcd->Instance, ep->num);
-          if (count != 0)
-          {
-            PCD_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, count);
-          }
-        }
-        else
-        {
-          if (PCD_GET_ENDPOINT(hpcd->Instance, ep->num) & USB_EP_DTOG_RX)
-          {
-            /*read from endpoint BUF0Addr buffer*/
-            count = PCD_GET_EP_DBUF0_CNT(hpcd->Instance, ep->num);
-            if (count != 0)
-            {
-              PCD_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr0, count);
-            }
-          }
-          else
-          {
-            /*read from endpoint BUF1Addr buffer*/
-            count = PCD_GET_EP_DBUF1_CNT(hpcd->Instance, ep->num);
-            if (count != 0)
-            {
-              PCD_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr1, count);
-            }
-          }
-          PCD_FreeUserBuffer(hpcd->Instance, ep->num, PCD_EP_DBUF_OUT);  
-        }
-        /*multi-packet on the NON control OUT endpoint*/
-        ep->xfer_count+=count;
-        ep->xfer_buff+=count;
-       
-        if ((ep->xfer_len == 0) || (count < ep->maxpacket))
-        {
-          /* RX COMPLETE */
-          HAL_PCD_DataOutStageCallback(hpcd, ep->num);
-        }
-        else
-        {
-          HAL_PCD_EP_Receive(hpcd, ep->num, ep->xfer_buff, ep->xfer_len);
-        }
+        /* MODIFIED: moved to PCD_EP_RxComplete() */
+        PCD_EP_RxComplete(hpcd, ep);
         
       } /* if((wEPVal & EP_CTR_RX) */
       
@@ -474,51 +459,8 @@ static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
         /* clear int flag */
         PCD_CLEAR_TX_EP_CTR(hpcd->Instance, EPindex);
         
-        /* IN double Buffering*/
-        if (ep->doublebuffer == 0)
-        {
-          ep->xfer_count = PCD_GET_EP_TX_CNT(hpcd->Instance, ep->num);
-          if (ep->xfer_count != 0)
-          {
-            PCD_WritePMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, ep->xfer_count);
-          }
-        }
-        else
-        {
-          if (PCD_GET_ENDPOINT(hpcd->Instance, ep->num) & USB_EP_DTOG_TX)
-          {
-            /*read from endpoint BUF0Addr buffer*/
-            ep->xfer_count = PCD_GET_EP_DBUF0_CNT(hpcd->Instance, ep->num);
-            if (ep->xfer_count != 0)
-            {
-              PCD_WritePMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr0, ep->xfer_count);
-            }
-          }
-          else
-          {
-            /*read from endpoint BUF1Addr buffer*/
-            ep->xfer_count = PCD_GET_EP_DBUF1_CNT(hpcd->Instance, ep->num);
-            if (ep->xfer_count != 0)
-            {
-              PCD_WritePMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr1, ep->xfer_count);
-            }
-          }
-          PCD_FreeUserBuffer(hpcd->Instance, ep->num, PCD_EP_DBUF_IN);  
-        }
-        /*multi-packet on the NON control IN endpoint*/
-        ep->xfer_count = PCD_GET_EP_TX_CNT(hpcd->Instance, ep->num);
-        ep->xfer_buff+=ep->xfer_count;
-       
-        /* Zero Length Packet? */
-        if (ep->xfer_len == 0)
-        {
-          /* TX COMPLETE */
-          HAL_PCD_DataInStageCallback(hpcd, ep->num);
-        }
-        else
-        {
-          HAL_PCD_EP_Transmit(hpcd, ep->num, ep->xfer_buff, ep->xfer_len);
-        }
+        /* MODIFIED: moved to PCD_EP_TxComplete() */
+        PCD_EP_TxComplete(hpcd, ep);
       } 
     }
   }
@@ -901,8 +843,18 @@ HAL_StatusTypeDef HAL_PCD_EP_Open(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint
     /*Set buffer address for double buffered mode*/
     PCD_SET_EP_DBUF_ADDR(hpcd->Instance, ep->num,ep->pmaaddr0, ep->pmaaddr1);
     
+    ep->dbuf_inflight = 0;
+    ep->dbuf_staged = 0;
+    ep->dbuf_prev = 0;
+    ep->dbuf_armed = 0;
+    ep->dbuf_held = 0;
+    ep->xfer_zlp = 0;
+
     if (ep->is_in==0)
     {
+      /* MODIFIED: both buffers must be able to take a whole packet */
+      PCD_SET_EP_DBUF_CNT(hpcd->Instance, ep->num, PCD_EP_DBUF_OUT, ep->maxpacket);
+
       /* Clear the data toggle bits for the endpoint IN/OUT*/
       PCD_CLEAR_RX_DTOG(hpcd->Instance, ep->num);
       PCD_CLEAR_TX_DTOG(hpcd->Instance, ep->num);
@@ -918,9 +870,9 @@ HAL_StatusTypeDef HAL_PCD_EP_Open(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint
       /* Clear the data toggle bits for the endpoint IN/OUT*/
       PCD_CLEAR_RX_DTOG(hpcd->Instance, ep->num);
       PCD_CLEAR_TX_DTOG(hpcd->Instance, ep->num);
-      PCD_RX_DTOG(hpcd->Instance, ep->num);
-      /* Configure DISABLE status for the Endpoint*/
-      PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_DIS);
+      /* MODIFIED: SW_BUF is left equal to DTOG_TX, so the hardware NAKs until PCD_DbufTxFill() hands it a buffer */
+      /* Configure NAK status for the Endpoint*/
+      PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_NAK);
       PCD_SET_EP_RX_STATUS(hpcd->Instance, ep->num, USB_EP_RX_DIS);
     }
   } 
@@ -1016,6 +968,8 @@ HAL_StatusTypeDef HAL_PCD_EP_Receive(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, u
   
   ep = &hpcd->OUT_ep[ep_addr & 0x7F];
   
+  __HAL_LOCK(hpcd); /* MODIFIED: moved ahead of the setup so that a busy return leaves the endpoint untouched */
+   
   /*setup and start the Xfer */
   ep->xfer_buff = pBuf;  
   ep->xfer_len = len;
@@ -1023,33 +977,30 @@ HAL_StatusTypeDef HAL_PCD_EP_Receive(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, u
   ep->is_in = 0;
   ep->num = ep_addr & 0x7F;
    
-  __HAL_LOCK(hpcd); 
-   
-  /* Multi packet transfer*/
-  if (ep->xfer_len > ep->maxpacket)
-  {
-    len=ep->maxpacket;
-    ep->xfer_len-=len; 
-  }
-  else
+  /* MODIFIED: double buffering rewritten; a packet that arrived ahead of this call is taken from PMA now */
+  if (ep->doublebuffer)
   {
-    len=ep->xfer_len;
-    ep->xfer_len =0;
+    ep->dbuf_armed = 1;
+
+    if (ep->dbuf_held)
+    {
+      ep->dbuf_held = 0;
+      if (PCD_DbufRxTake(hpcd, ep))
+      {
+        ep->dbuf_armed = 0;
+        __HAL_UNLOCK(hpcd);
+        /* RX COMPLETE */
+        HAL_PCD_DataOutStageCallback(hpcd, ep->num);
+        return HAL_OK;
+      }
+    }
+
+    __HAL_UNLOCK(hpcd);
+    return HAL_OK;
   }
-  
+
   /* configure and validate Rx endpoint */
-  if (ep->doublebuffer == 0) 
-  {
-    /*Set RX buffer count*/
-    PCD_SET_EP_RX_CNT(hpcd->Instance, ep->num, len);
-  }
-  else
-  {
-    /*Set the Double buffer counter*/
-    PCD_SET_EP_DBUF1_CNT(hpcd->Instance, ep->num, ep->is_in, len);
-  } 
-  
-  PCD_SET_EP_RX_STATUS(hpcd->Instance, ep->num, USB_EP_RX_VALID);
+  PCD_EP_RxNext(hpcd, ep);
   
   __HAL_UNLOCK(hpcd); 
   
@@ -1066,6 +1017,29 @@ uint16_t HAL_PCD_EP_GetRxCount(PCD_HandleTypeDef *hpcd, uint8_t ep_addr)
 {
   return hpcd->OUT_ep[ep_addr & 0x7F].xfer_count;
 }
+
+/**
+  * @brief  MODIFIED: Report whether an IN endpoint still holds data for the host
+  * @param  hpcd: PCD handle
+  * @param  ep_addr: endpoint address
+  * @retval 1 if a packet is waiting for the host (or its completion is yet to be serviced), 0 if idle
+  */
+uint8_t HAL_PCD_EP_IsTxPending(PCD_HandleTypeDef *hpcd, uint8_t ep_addr)
+{
+  PCD_EPTypeDef *ep = &hpcd->IN_ep[ep_addr & 0x7F];
+  uint16_t reg = PCD_GET_ENDPOINT(hpcd->Instance, ep->num);
+
+  if (reg & USB_EP_CTR_TX)
+    return 1;
+
+  if (ep->doublebuffer)
+  {
+    /* the hardware owns a buffer whenever DTOG_TX and SW_BUF (DTOG_RX) differ */
+    return ((reg & USB_EP_DTOG_TX) != 0) != ((reg & USB_EP_DTOG_RX) != 0);
+  }
+
+  return (reg & USB_EPTX_STAT) == USB_EP_TX_VALID;
+}
 /**
   * @brief  Send an amount of data  
   * @param  hpcd: PCD handle
@@ -1076,61 +1050,24 @@ uint16_t HAL_PCD_EP_GetRxCount(PCD_HandleTypeDef *hpcd, uint8_t ep_addr)
   */
 HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint8_t *pBuf, uint32_t len)
 {
-  PCD_EPTypeDef *ep;
-  uint16_t pmabuffer = 0;
-    
-  ep = &hpcd->IN_ep[ep_addr & 0x7F];
-  
-  /*setup and start the Xfer */
-  ep->xfer_buff = pBuf;  
-  ep->xfer_len = len;
-  ep->xfer_count = 0;
-  ep->is_in = 1;
-  ep->num = ep_addr & 0x7F;
-  
-  __HAL_LOCK(hpcd); 
-  
-  /*Multi packet transfer*/
-  if (ep->xfer_len > ep->maxpacket)
-  {
-    len=ep->maxpacket;
-    ep->xfer_len-=len; 
-  }
-  else
-  {  
-    len=ep->xfer_len;
-    ep->xfer_len =0;
-  }
-  
-  /* configure and validate Tx endpoint */
-  if (ep->doublebuffer == 0) 
-  {
-    PCD_WritePMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, len);
-    PCD_SET_EP_TX_CNT(hpcd->Instance, ep->num, len);
-  }
-  else
-  {
-    /*Set the Double buffer counter*/
-    PCD_SET_EP_DBUF1_CNT(hpcd->Instance, ep->num, ep->is_in, len);
-    
-    /*Write the data to the USB endpoint*/
-    if (PCD_GET_ENDPOINT(hpcd->Instance, ep->num)& USB_EP_DTOG_TX)
-    {
-      pmabuffer = ep->pmaaddr1;
-    }
-    else
-    {
-      pmabuffer = ep->pmaaddr0;
-    }
-    PCD_WritePMA(hpcd->Instance, ep->xfer_buff, pmabuffer, len);
-    PCD_FreeUserBuffer(hpcd->Instance, ep->num, ep->is_in);
-  }
+  return PCD_EP_Transmit(hpcd, ep_addr, pBuf, NULL, NULL, len, 0); /* MODIFIED: body moved to PCD_EP_Transmit() */
+}
 
-  PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_VALID);
-  
-  __HAL_UNLOCK(hpcd);
-     
-  return HAL_OK;
+/**
+  * @brief  MODIFIED: Send an amount of data gathered from several pieces of memory
+  * @param  hpcd: PCD handle
+  * @param  ep_addr: endpoint address
+  * @param  gather: called (in order) for each piece of the data; it is passed the number of bytes still
+  *         wanted in *len, and returns a pointer to the next piece having set *len to its size (at least 1)
+  * @param  context: argument passed to gather
+  * @param  len: amount of data to be sent
+  * @param  zlp: if non-zero, a transfer that is a (non-zero) multiple of maxpacket is terminated with a zero-length packet,
+  *         so that the host always sees it end with a short packet
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_PCD_EP_TransmitGather(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, const uint8_t *(*gather)(void *context, uint16_t *len), void *context, uint32_t len, uint8_t zlp)
+{
+  return PCD_EP_Transmit(hpcd, ep_addr, NULL, gather, context, len, zlp);
 }
 
 /**
@@ -1262,6 +1199,420 @@ HAL_StatusTypeDef HAL_PCD_DeActiveRemoteWakeup(PCD_HandleTypeDef *hpcd)
 /** @addtogroup PCD_Private_Functions
   * @{
   */
+/**
+  * @brief  Send an amount of data from either a buffer or a gather callback
+  * @param  hpcd: PCD handle
+  * @param  ep_addr: endpoint address
+  * @param  pBuf: pointer to the transmission buffer (if gather is NULL)
+  * @param  gather: gather callback (see HAL_PCD_EP_TransmitGather()), or NULL
+  * @param  context: argument passed to gather
+  * @param  len: amount of data to be sent
+  * @param  zlp: terminate a multiple of maxpacket with a zero-length packet
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint8_t *pBuf, const uint8_t *(*gather)(void *context, uint16_t *len), void *context, uint32_t len, uint8_t zlp)
+{
+  PCD_EPTypeDef *ep;
+    
+  ep = &hpcd->IN_ep[ep_addr & 0x7F];
+  
+  __HAL_LOCK(hpcd); /* MODIFIED: moved ahead of the setup so that a busy return leaves the endpoint untouched */
+  
+  /* MODIFIED: a double-buffered endpoint can take a new transfer while the last packet of the previous one is in flight */
+  if ((ep->doublebuffer) && (ep->dbuf_staged || (ep->dbuf_inflight && (ep->xfer_len || ep->xfer_zlp))))
+  {
+    __HAL_UNLOCK(hpcd);
+    return HAL_BUSY;
+  }
+  
+  /*setup and start the Xfer */
+  ep->xfer_buff = pBuf;  
+  ep->xfer_gather = gather;
+  ep->xfer_context = context;
+  ep->xfer_len = len;
+  ep->xfer_zlp = zlp && len;
+  ep->xfer_count = 0;
+  ep->is_in = 1;
+  ep->num = ep_addr & 0x7F;
+  
+  /* configure and validate Tx endpoint */
+  if (ep->doublebuffer == 0) 
+  {
+    PCD_EP_TxNext(hpcd, ep);
+  }
+  else
+  {
+    /* MODIFIED: double buffering rewritten; see PCD_DbufTxFill() */
+    ep->dbuf_prev = ep->dbuf_inflight;
+    PCD_DbufTxFill(hpcd, ep);
+  }
+  
+  __HAL_UNLOCK(hpcd);
+     
+  return HAL_OK;
+}
+
+/**
+  * @brief  Start the next packet of a transfer on a single-buffered IN endpoint
+  *         This is used both to start a transfer and (from the ISR) to continue a multi-packet one;
+  *         the transfer ends with the first packet shorter than maxpacket, or once xfer_len is used up.
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_EP_TxNext(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  uint32_t len;
+
+  /*Multi packet transfer*/
+  if (ep->xfer_len > ep->maxpacket)
+  {
+    len=ep->maxpacket;
+    ep->xfer_len-=len; 
+  }
+  else
+  {  
+    len=ep->xfer_len;
+    ep->xfer_len =0;
+  }
+
+  /* MODIFIED: a short packet (including the zero-length one itself) terminates the transfer */
+  if (len < ep->maxpacket)
+  {
+    ep->xfer_zlp = 0;
+  }
+
+  PCD_WriteTxPMA(hpcd, ep, ep->pmaadress, len);
+  PCD_SET_EP_TX_CNT(hpcd->Instance, ep->num, len);
+  PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_VALID);
+}
+
+/**
+  * @brief  Arm a single-buffered OUT endpoint for the next packet of a transfer
+  *         This is used both to start a transfer and (from the ISR) to continue a multi-packet one.
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_EP_RxNext(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  uint32_t len;
+
+  /* Multi packet transfer*/
+  if (ep->xfer_len > ep->maxpacket)
+  {
+    len=ep->maxpacket;
+    ep->xfer_len-=len; 
+  }
+  else
+  {
+    len=ep->xfer_len;
+    ep->xfer_len =0;
+  }
+
+  /*Set RX buffer count*/
+  PCD_SET_EP_RX_CNT(hpcd->Instance, ep->num, len);
+  PCD_SET_EP_RX_STATUS(hpcd->Instance, ep->num, USB_EP_RX_VALID);
+}
+
+/**
+  * @brief  Copy the next packet of an IN transfer into packet memory area (PMA)
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @param  wPMABufAddr: address into PMA.
+  * @param  wNBytes: no. of bytes to be copied.
+  * @retval None
+  */
+static void PCD_WriteTxPMA(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t wPMABufAddr, uint16_t wNBytes)
+{
+  const uint8_t *pbUsrBuf;
+  uint16_t piece;
+  uint16_t temp = 0;
+  uint8_t odd = 0;
+  __IO uint16_t *pdwVal;
+
+  if (ep->xfer_gather == NULL)
+  {
+    PCD_WritePMA(hpcd->Instance, ep->xfer_buff, wPMABufAddr, wNBytes);
+    return;
+  }
+
+  pdwVal = PCD_PMA(hpcd->Instance, wPMABufAddr);
+
+  while (wNBytes)
+  {
+    piece = wNBytes;
+    pbUsrBuf = ep->xfer_gather(ep->xfer_context, &piece);
+    if (piece == 0)
+    {
+      break;
+    }
+    wNBytes -= piece;
+
+    /* pair a byte left over from the previous piece with the first byte of this one */
+    if (odd)
+    {
+      *pdwVal++ = temp | (uint16_t)*pbUsrBuf++ << 8;
+      piece--;
+      odd = 0;
+    }
+
+    pdwVal = PCD_CopyToPMA(pdwVal, pbUsrBuf, piece >> 1);
+    pbUsrBuf += piece & ~1;
+
+    if (piece & 1)
+    {
+      temp = *pbUsrBuf;
+      odd = 1;
+    }
+  }
+
+  if (odd)
+  {
+    *pdwVal = temp;
+  }
+}
+
+/**
+  * @brief  Copy the next packet of an IN transfer into the free buffer of a double-buffered endpoint
+  *         The hardware sends from the buffer selected by DTOG_TX, whilst the application owns the one selected
+  *         by SW_BUF (DTOG_RX); it NAKs whenever the two are equal, and toggling SW_BUF hands over a buffer.
+  *         So, the packet is handed over at once if the hardware is idle, or else it is staged until
+  *         PCD_DbufTxComplete() sees the packet ahead of it acknowledged.
+  *         Once a packet is handed over, the next one is staged in the other buffer straight away, so that both
+  *         buffers are filled before the first packet goes, and the acknowledgement only has to toggle SW_BUF.
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_DbufTxFill(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  uint32_t len;
+
+  do
+  {
+    len = (ep->xfer_len > ep->maxpacket) ? ep->maxpacket : ep->xfer_len;
+    ep->xfer_len -= len;
+
+    /* a short packet (including the zero-length one itself) terminates the transfer */
+    if (len < ep->maxpacket)
+    {
+      ep->xfer_zlp = 0;
+    }
+
+    if (PCD_GET_ENDPOINT(hpcd->Instance, ep->num) & USB_EP_DTOG_RX)
+    {
+      PCD_WriteTxPMA(hpcd, ep, ep->pmaaddr1, len);
+      PCD_SET_EP_DBUF1_CNT(hpcd->Instance, ep->num, PCD_EP_DBUF_IN, len);
+    }
+    else
+    {
+      PCD_WriteTxPMA(hpcd, ep, ep->pmaaddr0, len);
+      PCD_SET_EP_DBUF0_CNT(hpcd->Instance, ep->num, PCD_EP_DBUF_IN, len);
+    }
+
+    if (ep->xfer_gather == NULL)
+    {
+      ep->xfer_buff += len;
+    }
+
+    if (ep->dbuf_inflight)
+    {
+      ep->dbuf_staged = 1;
+    }
+    else
+    {
+      PCD_FreeUserBuffer(hpcd->Instance, ep->num, PCD_EP_DBUF_IN);
+      ep->dbuf_inflight = 1;
+    }
+  }
+  while (!ep->dbuf_staged && ((ep->xfer_len != 0) || (ep->xfer_zlp != 0)));
+
+  PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_VALID);
+}
+
+/**
+  * @brief  Service the acknowledgement of a packet sent from a double-buffered IN endpoint
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_DbufTxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  uint8_t prev;
+
+  ep->dbuf_inflight = 0;
+
+  /* hand over the buffer that was staged behind the packet just sent */
+  if (ep->dbuf_staged)
+  {
+    ep->dbuf_staged = 0;
+    PCD_FreeUserBuffer(hpcd->Instance, ep->num, PCD_EP_DBUF_IN);
+    ep->dbuf_inflight = 1;
+  }
+
+  prev = ep->dbuf_prev;
+  ep->dbuf_prev = 0;
+
+  /* refill the buffer just freed with the rest of the transfer (or its terminating zero-length packet) */
+  if ((ep->xfer_len != 0) || (ep->xfer_zlp != 0))
+  {
+    PCD_DbufTxFill(hpcd, ep);
+  }
+
+  /* the packet just sent either ended the previous transfer or (with nothing left in flight) this one */
+  if (prev || !ep->dbuf_inflight)
+  {
+    /* TX COMPLETE */
+    HAL_PCD_DataInStageCallback(hpcd, ep->num);
+  }
+}
+
+/**
+  * @brief  Take the packet received by a double-buffered OUT endpoint into the transfer buffer
+  *         SW_BUF (DTOG_TX) is toggled before PMA is read, so that the hardware can already be receiving
+  *         the next packet into the other buffer whilst this one is being copied.
+  *         Anything beyond the space left in the transfer buffer is discarded.
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval 1 if the transfer is complete
+  */
+static uint8_t PCD_DbufRxTake(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  uint16_t count, copy;
+  uint16_t pmabuffer;
+
+  PCD_FreeUserBuffer(hpcd->Instance, ep->num, PCD_EP_DBUF_OUT);
+
+  /* SW_BUF now selects the buffer holding the packet */
+  if (PCD_GET_ENDPOINT(hpcd->Instance, ep->num) & USB_EP_DTOG_TX)
+  {
+    count = PCD_GET_EP_DBUF1_CNT(hpcd->Instance, ep->num);
+    pmabuffer = ep->pmaaddr1;
+  }
+  else
+  {
+    count = PCD_GET_EP_DBUF0_CNT(hpcd->Instance, ep->num);
+    pmabuffer = ep->pmaaddr0;
+  }
+
+  copy = (count > ep->xfer_len) ? ep->xfer_len : count;
+  if (copy != 0)
+  {
+    PCD_ReadPMA(hpcd->Instance, ep->xfer_buff, pmabuffer, copy);
+  }
+
+  /*multi-packet on the NON control OUT endpoint*/
+  ep->xfer_buff += copy;
+  ep->xfer_len -= copy;
+  ep->xfer_count += count;
+
+  return (ep->xfer_len == 0) || (count < ep->maxpacket);
+}
+
+/**
+  * @brief  Service the reception of a packet by a double-buffered OUT endpoint
+  *         If no transfer is waiting, the packet is left in PMA (and the host NAKed) until HAL_PCD_EP_Receive().
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_DbufRxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  if (!ep->dbuf_armed)
+  {
+    ep->dbuf_held = 1;
+    return;
+  }
+
+  if (PCD_DbufRxTake(hpcd, ep))
+  {
+    ep->dbuf_armed = 0;
+    /* RX COMPLETE */
+    HAL_PCD_DataOutStageCallback(hpcd, ep->num);
+  }
+}
+
+/**
+  * @brief  MODIFIED: Service the reception of a packet by a (non-control) OUT endpoint, whose CTR_RX has been cleared
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_EP_RxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  uint16_t count;
+
+  /* OUT double Buffering*/
+  if (ep->doublebuffer == 0)
+  {
+    count = PCD_GET_EP_RX_CNT(hpcd->Instance, ep->num);
+    if (count != 0)
+    {
+      PCD_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, count);
+    }
+
+    /*multi-packet on the NON control OUT endpoint*/
+    ep->xfer_count+=count;
+    ep->xfer_buff+=count;
+   
+    if ((ep->xfer_len == 0) || (count < ep->maxpacket))
+    {
+      /* RX COMPLETE */
+      HAL_PCD_DataOutStageCallback(hpcd, ep->num);
+    }
+    else
+    {
+      /* MODIFIED: HAL_PCD_EP_Receive() zeroed xfer_count, and could fail if the lock was held */
+      PCD_EP_RxNext(hpcd, ep);
+    }
+  }
+  else
+  {
+    /* MODIFIED: double buffering rewritten; see PCD_DbufRxComplete() */
+    PCD_DbufRxComplete(hpcd, ep);
+  }
+}
+
+/**
+  * @brief  MODIFIED: Service the acknowledgement of a packet sent by a (non-control) IN endpoint, whose CTR_TX has been cleared
+  * @param  hpcd: PCD handle
+  * @param  ep: endpoint
+  * @retval None
+  */
+static void PCD_EP_TxComplete(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep)
+{
+  /* IN double Buffering*/
+  if (ep->doublebuffer == 0)
+  {
+    /* MODIFIED: the packet just sent is no longer pointlessly rewritten into PMA */
+
+    /*multi-packet on the NON control IN endpoint*/
+    ep->xfer_count = PCD_GET_EP_TX_CNT(hpcd->Instance, ep->num);
+    if (ep->xfer_gather == NULL)
+    {
+      ep->xfer_buff+=ep->xfer_count;
+    }
+   
+    /* Zero Length Packet? */
+    if ((ep->xfer_len == 0) && (ep->xfer_zlp == 0))
+    {
+      /* TX COMPLETE */
+      HAL_PCD_DataInStageCallback(hpcd, ep->num);
+    }
+    else
+    {
+      /* MODIFIED: HAL_PCD_EP_Transmit() could fail (stranding the transfer) if the lock was held */
+      PCD_EP_TxNext(hpcd, ep);
+    }
+  }
+  else
+  {
+    /* MODIFIED: double buffering rewritten; see PCD_DbufTxComplete() */
+    PCD_DbufTxComplete(hpcd, ep);
+  }
+}
+
 /**
   * @brief Copy a buffer from user memory area to packet memory area (PMA)
   * @param   USBx: USB peripheral instance register address.
@@ -1272,20 +1623,8 @@ HAL_StatusTypeDef HAL_PCD_DeActiveRemoteWakeup(PCD_HandleTypeDef *hpcd)
   */
 void PCD_WritePMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
 {
-  uint32_t n = (wNBytes + 1) >> 1; 
-  uint32_t i;
-  uint16_t temp1, temp2;
-  uint16_t *pdwVal;
-  pdwVal = (uint16_t *)(wPMABufAddr + (uint32_t)USBx + 0x400);
-  
-  for (i = n; i != 0; i--)
-  {
-    temp1 = (uint16_t) * pbUsrBuf;
-    pbUsrBuf++;
-    temp2 = temp1 | (uint16_t) * pbUsrBuf << 8;
-    *pdwVal++ = temp2;
-    pbUsrBuf++;
-  }
+  /* MODIFIED: copy loop moved to PCD_CopyToPMA() */
+  PCD_CopyToPMA(PCD_PMA(USBx, wPMABufAddr), pbUsrBuf, (wNBytes + 1) >> 1);
 }
 
 /**
@@ -1298,14 +1637,154 @@ void PCD_WritePMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, u
   */
 void PCD_ReadPMA(USB_TypeDef  *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
 {
-  uint32_t n = (wNBytes + 1) >> 1;
-  uint32_t i;
-  uint16_t *pdwVal;
-  pdwVal = (uint16_t *)(wPMABufAddr + (uint32_t)USBx + 0x400);
-  for (i = n; i != 0; i--)
+  /* MODIFIED: copy loop moved to PCD_CopyFromPMA(), which no longer faults on an odd pbUsrBuf */
+  PCD_CopyFromPMA(pbUsrBuf, PCD_PMA(USBx, wPMABufAddr), (wNBytes + 1) >> 1);
+}
+
+/**
+  * @brief  MODIFIED: Copy halfwords from user memory area to packet memory area (PMA)
+  *         The PMA only takes halfword (or byte) accesses, but an aligned user buffer is read a word at a time
+  *         (four words to a loop); the Cortex-M0 faults on unaligned accesses, so an odd one is read by bytes.
+  * @param  pdwVal: PMA address
+  * @param  pbUsrBuf: pointer to user memory area.
+  * @param  n: no. of halfwords to be copied.
+  * @retval PMA address following the last halfword written
+  */
+static __IO uint16_t *PCD_CopyToPMA(__IO uint16_t *pdwVal, const uint8_t *pbUsrBuf, uint32_t n)
+{
+  const uint32_t *pwUsrBuf;
+  uint32_t w0, w1, w2, w3;
+
+  if ((uintptr_t)pbUsrBuf & 1)
+  {
+    for (; n >= 4; n -= 4)
+    {
+      pdwVal[0] = (uint16_t)pbUsrBuf[0] | (uint16_t)pbUsrBuf[1] << 8;
+      pdwVal[1] = (uint16_t)pbUsrBuf[2] | (uint16_t)pbUsrBuf[3] << 8;
+      pdwVal[2] = (uint16_t)pbUsrBuf[4] | (uint16_t)pbUsrBuf[5] << 8;
+      pdwVal[3] = (uint16_t)pbUsrBuf[6] | (uint16_t)pbUsrBuf[7] << 8;
+      pdwVal += 4;
+      pbUsrBuf += 8;
+    }
+    for (; n != 0; n--)
+    {
+      *pdwVal++ = (uint16_t)pbUsrBuf[0] | (uint16_t)pbUsrBuf[1] << 8;
+      pbUsrBuf += 2;
+    }
+    return pdwVal;
+  }
+
+  /* bring a halfword-aligned buffer up to a word boundary */
+  if (((uintptr_t)pbUsrBuf & 2) && (n != 0))
+  {
+    *pdwVal++ = *(const uint16_t *)pbUsrBuf;
+    pbUsrBuf += 2;
+    n--;
+  }
+
+  pwUsrBuf = (const uint32_t *)pbUsrBuf;
+
+  for (; n >= 8; n -= 8)
+  {
+    w0 = pwUsrBuf[0];
+    w1 = pwUsrBuf[1];
+    w2 = pwUsrBuf[2];
+    w3 = pwUsrBuf[3];
+    pdwVal[0] = (uint16_t)w0;
+    pdwVal[1] = (uint16_t)(w0 >> 16);
+    pdwVal[2] = (uint16_t)w1;
+    pdwVal[3] = (uint16_t)(w1 >> 16);
+    pdwVal[4] = (uint16_t)w2;
+    pdwVal[5] = (uint16_t)(w2 >> 16);
+    pdwVal[6] = (uint16_t)w3;
+    pdwVal[7] = (uint16_t)(w3 >> 16);
+    pdwVal += 8;
+    pwUsrBuf += 4;
+  }
+  for (; n >= 2; n -= 2)
+  {
+    w0 = *pwUsrBuf++;
+    pdwVal[0] = (uint16_t)w0;
+    pdwVal[1] = (uint16_t)(w0 >> 16);
+    pdwVal += 2;
+  }
+  if (n != 0)
+  {
+    *pdwVal++ = *(const uint16_t *)pwUsrBuf;
+  }
+
+  return pdwVal;
+}
+
+/**
+  * @brief  MODIFIED: Copy halfwords from packet memory area (PMA) to user memory area
+  *         As PCD_CopyToPMA(), an aligned user buffer is written a word at a time, and an odd one by bytes.
+  * @param  pbUsrBuf: pointer to user memory area.
+  * @param  pdwVal: PMA address
+  * @param  n: no. of halfwords to be copied.
+  * @retval None
+  */
+static void PCD_CopyFromPMA(uint8_t *pbUsrBuf, __IO uint16_t *pdwVal, uint32_t n)
+{
+  uint32_t *pwUsrBuf;
+  uint16_t h0, h1, h2, h3;
+
+  if ((uintptr_t)pbUsrBuf & 1)
+  {
+    for (; n >= 4; n -= 4)
+    {
+      h0 = pdwVal[0];
+      h1 = pdwVal[1];
+      h2 = pdwVal[2];
+      h3 = pdwVal[3];
+      pbUsrBuf[0] = (uint8_t)h0;
+      pbUsrBuf[1] = (uint8_t)(h0 >> 8);
+      pbUsrBuf[2] = (uint8_t)h1;
+      pbUsrBuf[3] = (uint8_t)(h1 >> 8);
+      pbUsrBuf[4] = (uint8_t)h2;
+      pbUsrBuf[5] = (uint8_t)(h2 >> 8);
+      pbUsrBuf[6] = (uint8_t)h3;
+      pbUsrBuf[7] = (uint8_t)(h3 >> 8);
+      pdwVal += 4;
+      pbUsrBuf += 8;
+    }
+    for (; n != 0; n--)
+    {
+      h0 = *pdwVal++;
+      pbUsrBuf[0] = (uint8_t)h0;
+      pbUsrBuf[1] = (uint8_t)(h0 >> 8);
+      pbUsrBuf += 2;
+    }
+    return;
+  }
+
+  /* bring a halfword-aligned buffer up to a word boundary */
+  if (((uintptr_t)pbUsrBuf & 2) && (n != 0))
+  {
+    *(uint16_t *)pbUsrBuf = *pdwVal++;
+    pbUsrBuf += 2;
+    n--;
+  }
+
+  pwUsrBuf = (uint32_t *)pbUsrBuf;
+
+  for (; n >= 8; n -= 8)
+  {
+    pwUsrBuf[0] = (uint32_t)pdwVal[0] | (uint32_t)pdwVal[1] << 16;
+    pwUsrBuf[1] = (uint32_t)pdwVal[2] | (uint32_t)pdwVal[3] << 16;
+    pwUsrBuf[2] = (uint32_t)pdwVal[4] | (uint32_t)pdwVal[5] << 16;
+    pwUsrBuf[3] = (uint32_t)pdwVal[6] | (uint32_t)pdwVal[7] << 16;
+    pdwVal += 8;
+    pwUsrBuf += 4;
+  }
+  for (; n >= 2; n -= 2)
+  {
+    *pwUsrBuf++ = (uint32_t)pdwVal[0] | (uint32_t)pdwVal[1] << 16;
+    pdwVal += 2;
+  }
+  if (n != 0)
   {
-    *(uint16_t*)pbUsrBuf++ = *pdwVal++;
-    pbUsrBuf++;
+    *(uint16_t *)pwUsrBuf = *pdwVal;
   }
 }
 /**
@@ -113,6 +113,10 @@ typedef struct
 
   uint32_t battery_charging_enable; /*!< Enable or disable Battery charging.                                  
                                       This parameter can be set to ENABLE or DISABLE                      */                                    
+
+  uint32_t fast_ep_mask;         /*!< MODIFIED: Endpoints (bit n for endpoint n) that are bulk and one-way, whose
+                                      interrupts PCD_EP_ISR_Handler() services without decoding them.
+                                      This parameter can be 0, for none                                   */
                                 
 }PCD_InitTypeDef;
 
@@ -155,6 +159,22 @@ typedef struct
   
   uint32_t  xfer_count;     /*!< Partial transfer length in case of multi packet transfer                 */
 
+  const uint8_t *(*xfer_gather)(void *context, uint16_t *len); /*!< MODIFIED: gather callback used instead of xfer_buff, or NULL */
+
+  void      *xfer_context;  /*!< MODIFIED: argument passed to xfer_gather                                   */
+
+  uint8_t   xfer_zlp;       /*!< MODIFIED: IN: the transfer still owes a terminating zero-length packet      */
+
+  uint8_t   dbuf_inflight;  /*!< MODIFIED: double-buffered IN: a buffer has been handed to the hardware      */
+
+  uint8_t   dbuf_staged;    /*!< MODIFIED: double-buffered IN: the other buffer is filled and waiting        */
+
+  uint8_t   dbuf_prev;      /*!< MODIFIED: double-buffered IN: the buffer in flight ends the previous transfer */
+
+  uint8_t   dbuf_armed;     /*!< MODIFIED: double-buffered OUT: a transfer is waiting for data              */
+
+  uint8_t   dbuf_held;      /*!< MODIFIED: double-buffered OUT: a packet arrived with no transfer waiting   */
+
 }PCD_EPTypeDef;
 
 typedef   USB_TypeDef PCD_TypeDef; 
@@ -283,7 +303,10 @@ typedef struct
   */
 
 /* SetENDPOINT */
+/* MODIFIED: a build for something other than the F072 (e.g. a model of the peripheral) may supply its own */
+#ifndef PCD_SET_ENDPOINT
 #define PCD_SET_ENDPOINT(USBx, bEpNum,wRegValue)  (*(&(USBx)->EP0R + (bEpNum) * 2)= (uint16_t)(wRegValue))
+#endif
 
 /* GetENDPOINT */
 #define PCD_GET_ENDPOINT(USBx, bEpNum)        (*(&(USBx)->EP0R + (bEpNum) * 2))
@@ -525,10 +548,23 @@ typedef struct
   */
 #define PCD_GET_EP_ADDRESS(USBx, bEpNum) ((uint8_t)(PCD_GET_ENDPOINT((USBx), (bEpNum)) & USB_EPADDR_FIELD))
 
-#define PCD_EP_TX_ADDRESS(USBx, bEpNum) ((uint16_t *)(((USBx)->BTABLE+(bEpNum)*8)+     ((uint32_t)(USBx) + 0x400)))
-#define PCD_EP_TX_CNT(USBx, bEpNum) ((uint16_t *)(((USBx)->BTABLE+(bEpNum)*8+2)+  ((uint32_t)(USBx) + 0x400)))
-#define PCD_EP_RX_ADDRESS(USBx, bEpNum) ((uint16_t *)(((USBx)->BTABLE+(bEpNum)*8+4)+  ((uint32_t)(USBx) + 0x400)))
-#define PCD_EP_RX_CNT(USBx, bEpNum) ((uint16_t *)(((USBx)->BTABLE+(bEpNum)*8+6)+  ((uint32_t)(USBx) + 0x400)))
+/**
+  * @brief  MODIFIED: Gets a pointer into the packet memory area (PMA).
+  *         Every PMA (and BTABLE) access goes through this one macro, so that a build for something other
+  *         than the F072 (e.g. a model of the peripheral) can say where the PMA is by defining PCD_PMA_BASE.
+  * @param  USBx: USB peripheral instance register address.
+  * @param  wOffset: offset into PMA.
+  * @retval Halfword pointer
+  */
+#ifndef PCD_PMA_BASE
+#define PCD_PMA_BASE(USBx) ((uint8_t *)(USBx) + 0x400)
+#endif
+#define PCD_PMA(USBx, wOffset) ((uint16_t *)(PCD_PMA_BASE(USBx) + (wOffset)))
+
+#define PCD_EP_TX_ADDRESS(USBx, bEpNum) PCD_PMA((USBx), (USBx)->BTABLE+(bEpNum)*8)
+#define PCD_EP_TX_CNT(USBx, bEpNum) PCD_PMA((USBx), (USBx)->BTABLE+(bEpNum)*8+2)
+#define PCD_EP_RX_ADDRESS(USBx, bEpNum) PCD_PMA((USBx), (USBx)->BTABLE+(bEpNum)*8+4)
+#define PCD_EP_RX_CNT(USBx, bEpNum) PCD_PMA((USBx), (USBx)->BTABLE+(bEpNum)*8+6)
 
 /**
   * @brief  sets address of the tx/rx buffer.
@@ -735,7 +771,9 @@ HAL_StatusTypeDef HAL_PCD_EP_Open(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint
 HAL_StatusTypeDef HAL_PCD_EP_Close(PCD_HandleTypeDef *hpcd, uint8_t ep_addr);
 HAL_StatusTypeDef HAL_PCD_EP_Receive(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint8_t *pBuf, uint32_t len);
 HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, uint8_t *pBuf, uint32_t len);
+HAL_StatusTypeDef HAL_PCD_EP_TransmitGather(PCD_HandleTypeDef *hpcd, uint8_t ep_addr, const uint8_t *(*gather)(void *context, uint16_t *len), void *context, uint32_t len, uint8_t zlp); /* MODIFIED: added */
 uint16_t          HAL_PCD_EP_GetRxCount(PCD_HandleTypeDef *hpcd, uint8_t ep_addr);
+uint8_t           HAL_PCD_EP_IsTxPending(PCD_HandleTypeDef *hpcd, uint8_t ep_addr); /* MODIFIED: added */
 HAL_StatusTypeDef HAL_PCD_EP_SetStall(PCD_HandleTypeDef *hpcd, uint8_t ep_addr);
 HAL_StatusTypeDef HAL_PCD_EP_ClrStall(PCD_HandleTypeDef *hpcd, uint8_t ep_addr);
 HAL_StatusTypeDef HAL_PCD_EP_Flush(PCD_HandleTypeDef *hpcd, uint8_t ep_addr);
@@ -30,6 +30,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "usbd_core.h"
 #include "stm32f0xx_it.h"
+#include "usbprof.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -113,7 +114,9 @@ void SysTick_Handler(void)
   */
 void USB_IRQHandler(void)
 {
+  USB_PROF_ENTER(USB_PROF_IRQ);
   HAL_PCD_IRQHandler(&hpcd);
+  USB_PROF_EXIT(USB_PROF_IRQ);
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,178 @@
+/*
+    TAP interface link for a Linux host build
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+This stands in for the USB class when the network services run as a Linux process (LINK_TAP; see link.h).
+Each link is a TAP interface opened through /dev/net/tun; the host end of it is configured with the usual tools
+(e.g. "ip addr add 192.168.7.2/24 dev tap0; ip link set tap0 up"), and takes the place of the USB host.
+
+link_poll() waits (with poll()) for frames, copies each into a PBUF_POOL pbuf, and offers it to link_recv_callback(),
+just as usbd_ecm.c does from its ISR. A declined frame is held, and nothing more is read from that link, until link_recv_renew().
+Transmit is a write() of the whole frame, so a pbuf is never held after link_xmit_packet() returns; link_xmit_callback() is never called, and link_xmit_reclaim() has nothing to do.
+*/
+
+#include "link.h"
+
+#if LINK_TAP
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#define TAP_FRAME_SIZE 1514
+
+struct tap_link
+{
+  int fd;
+  struct pbuf *held;               /* frame declined by link_recv_callback(), until link_recv_renew() */
+};
+
+static struct tap_link links[NUM_OF_ECM];
+
+bool link_open(void)
+{
+  struct ifreq ifr;
+  unsigned index;
+
+  for (index = 0; index < NUM_OF_ECM; index++)
+  {
+    links[index].fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    if (links[index].fd < 0)
+    {
+      perror("/dev/net/tun");
+      return false;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    snprintf(ifr.ifr_name, IFNAMSIZ, "tap%u", index);
+
+    if (ioctl(links[index].fd, TUNSETIFF, &ifr) < 0)
+    {
+      perror(ifr.ifr_name);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* read (and offer) frames from one link until it runs dry, or a frame is declined */
+static void link_read(unsigned index)
+{
+  struct tap_link *link = &links[index];
+  uint8_t frame[TAP_FRAME_SIZE];
+  struct pbuf *p;
+  ssize_t len;
+
+  while (!link->held)
+  {
+    len = read(link->fd, frame, sizeof(frame));
+    if (len <= 0)
+      return;
+
+    /* as with a full pbuf pool in the firmware, a frame that can't be stored is lost */
+    p = pbuf_alloc(PBUF_RAW, (u16_t)len, PBUF_POOL);
+    if (!p)
+      continue;
+    pbuf_take(p, frame, (u16_t)len);
+
+    if (!link_recv_callback(index, p))
+      link->held = p;
+  }
+}
+
+void link_poll(int timeout_ms)
+{
+  struct pollfd fds[NUM_OF_ECM];
+  unsigned index;
+
+  for (index = 0; index < NUM_OF_ECM; index++)
+  {
+    fds[index].fd = links[index].fd;
+    fds[index].events = links[index].held ? 0 : POLLIN;
+  }
+
+  if (poll(fds, NUM_OF_ECM, timeout_ms) <= 0)
+    return;
+
+  for (index = 0; index < NUM_OF_ECM; index++)
+  {
+    if (fds[index].revents & POLLIN)
+      link_read(index);
+  }
+}
+
+void link_recv_renew(unsigned index)
+{
+  struct tap_link *link = &links[index];
+
+  if (link->held && link_recv_callback(index, link->held))
+  {
+    link->held = NULL;
+    link_read(index);
+  }
+}
+
+bool link_xmit_packet(unsigned index, struct pbuf *p)
+{
+  uint8_t frame[TAP_FRAME_SIZE];
+  u16_t len;
+
+  if (p->tot_len > sizeof(frame))
+    return false;
+
+  len = pbuf_copy_partial(p, frame, p->tot_len, 0);
+
+  /* a full TAP queue drops the frame, as a full transmit queue does in usbd_ecm.c */
+  return write(links[index].fd, frame, len) == len;
+}
+
+void link_xmit_reclaim(unsigned index)
+{
+  (void)index;
+}
+
+void link_set_hwaddr(unsigned index, const uint8_t *hwaddr)
+{
+  /* the kernel's TAP interface passes every frame on; lwIP itself ignores those for other addresses */
+  (void)index;
+  (void)hwaddr;
+}
+
+void link_set_link(unsigned index, bool up)
+{
+  /* the TAP interface's carrier follows this process having it open */
+  (void)index;
+  (void)up;
+}
+
+#endif /* LINK_TAP */
@@ -38,28 +38,89 @@ void time_init(void)
 }
 
 volatile uint32_t msAddition = 0;
+static volatile uint32_t msWraps = 0; /* msAddition wraps every 49.7 days; this makes a 64-bit count of ms */
+volatile uint32_t events = 0;
+
+/* a copy of the soonest timer deadline (see stmr_update_tick), so that the main loop is only woken once a timer is due */
+static volatile uint32_t tick_deadline;
+static volatile bool tick_armed = false;
 
 void SysTick_Handler(void)
 {
-    msAddition++; /* +1 ms */
+    if (++msAddition == 0) /* +1 ms */
+        msWraps++;
+    if (tick_armed && (int32_t)(msAddition - tick_deadline) >= 0)
+        event_post(EVENT_TICK);
+}
+
+void event_post(uint32_t event)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* the load and store of events mustn't be split by a handler that preempts this one (SysTick preempts the USB interrupt) */
+    __disable_irq();
+    events |= event;
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Reads the time as whole milliseconds plus the SysTick cycles into the current one.
+ * SysTick's COUNTFLAG can't show that the counter has reloaded part way through, as reading CTRL clears it
+ * (so a second reader, or the next read, misses it); the pending bit of the SysTick exception is used instead,
+ * which also covers a caller that has interrupts masked.
+ * SysTick has the highest priority (TICK_INT_PRIORITY, 0), and the USB interrupt a lower one (3, see usbd_conf.c),
+ * so SysTick_Handler can run part way through a call from the USB ISR just as from the main loop; the retry covers both.
+ */
+static uint64_t systick_sample(uint32_t *cycles)
+{
+    uint32_t lo, hi, val, pending;
+
+    /* (unless called from SysTick_Handler itself) try again if SysTick_Handler ran part way through */
+    do
+    {
+        hi = msWraps;
+        lo = msAddition;
+        val = SysTick->VAL;
+
+        /* the counter has reloaded, but SysTick_Handler has yet to count it */
+        pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+        if (pending)
+            val = SysTick->VAL; /* so, make sure that val is from after the reload */
+    } while (lo != msAddition || hi != msWraps);
+
+    *cycles = SysTick->LOAD - val;
+    return (((uint64_t)hi << 32) | lo) + (pending ? 1 : 0);
 }
 
 uint32_t mtime(void)
 {
-    uint32_t ctrl;
-    static int32_t res;
-    uint32_t ticks;
+    uint32_t cycles;
+
+    return (uint32_t)systick_sample(&cycles);
+}
+
+uint64_t mtime64(void)
+{
+    uint32_t cycles;
 
-    ctrl = SysTick->CTRL;
+    return systick_sample(&cycles);
+}
 
-read:
-    ticks = SysTick->VAL;
-    res = msAddition;
-    ctrl = SysTick->CTRL;
-    if (ctrl & SysTick_CTRL_COUNTFLAG_Msk)
-        goto read;
+uint64_t utime(void)
+{
+    uint32_t cycles;
+    uint64_t ms = systick_sample(&cycles);
 
-    return res;
+    /* cycles is less than the reload value (SystemCoreClock / 1000), so this can't overflow */
+    return ms * 1000 + cycles * 1000 / (SysTick->LOAD + 1);
+}
+
+uint32_t cycletime(void)
+{
+    uint32_t cycles;
+    uint32_t ms = (uint32_t)systick_sample(&cycles);
+
+    return ms * (SysTick->LOAD + 1) + cycles;
 }
 
 void msleep(int ms)
@@ -73,29 +134,118 @@ void msleep(int ms)
     }
 }
 
+/*
+ * the running timers are kept in a list ordered by deadline, soonest first;
+ * so, stmr() need only look at the head, and next_deadline() is the head's deadline
+ */
 static stmr_t *stmrs = NULL;
 
+static void stmr_update_tick(void)
+{
+    if (stmrs != NULL)
+    {
+        tick_deadline = stmrs->deadline;
+        tick_armed = true;
+    }
+    else
+        tick_armed = false;
+}
+
+static void stmr_unlink(stmr_t *tmr)
+{
+    if ((tmr->flags & STMR_QUEUED) == 0)
+        return;
+
+    if (tmr->prev != NULL)
+        tmr->prev->next = tmr->next;
+    else
+        stmrs = tmr->next;
+    if (tmr->next != NULL)
+        tmr->next->prev = tmr->prev;
+
+    tmr->next = tmr->prev = NULL;
+    tmr->flags &= ~(uint32_t)STMR_QUEUED;
+}
+
+/* queue a timer behind any others with the same (or an earlier) deadline */
+static void stmr_insert(stmr_t *tmr)
+{
+    stmr_t *prev = NULL;
+    stmr_t *t = stmrs;
+
+    while (t != NULL && (int32_t)(tmr->deadline - t->deadline) >= 0)
+    {
+        prev = t;
+        t = t->next;
+    }
+
+    tmr->prev = prev;
+    tmr->next = t;
+    if (prev != NULL)
+        prev->next = tmr;
+    else
+        stmrs = tmr;
+    if (t != NULL)
+        t->prev = tmr;
+
+    tmr->flags |= STMR_QUEUED;
+}
+
+/* (re)queue a timer that has been added to the list and is active; otherwise, take it out of the queue */
+static void stmr_schedule(stmr_t *tmr)
+{
+    stmr_unlink(tmr);
+    if ((tmr->flags & (STMR_ACTIVE | STMR_ADDED)) == (STMR_ACTIVE | STMR_ADDED))
+        stmr_insert(tmr);
+    stmr_update_tick();
+}
+
 void stmr(void)
 {
-    stmr_t *tmr;
+    stmr_t *t;
     uint32_t time;
+    uint32_t late;
+    uint32_t missed;
+
     time = mtime();
-    tmr = stmrs;
-    while (tmr != NULL)
+
+    while ((t = stmrs) != NULL && (int32_t)(time - t->deadline) >= 0)
     {
-        stmr_t *t;
-        uint32_t elapsed;
-        t = tmr;
-        tmr = tmr->next;
-        if ((t->flags & STMR_ACTIVE) == 0)
-            continue;
-        elapsed = time;
-        elapsed -= t->event;
-        if (elapsed < t->period)
-            continue;
+        late = time - t->deadline;
+        t->runs++;
+        t->late_total += late;
+        if (late > t->late_max)
+            t->late_max = late;
+
+        /* the next deadline follows on from this one, not from when the proc returns, so a periodic timer doesn't drift */
+        t->event = t->deadline;
+        if (t->period == 0)
+            t->deadline = time + 1;
+        else
+        {
+            /* skip (and count) whole periods that were missed altogether */
+            missed = late / t->period;
+            t->overruns += missed;
+            t->deadline += (missed + 1) * t->period;
+        }
+
+        /* requeued ahead of the call, so that the proc may stop, free or re-run its own timer */
+        stmr_unlink(t);
+        stmr_insert(t);
+
         t->proc(t);
-        t->event = mtime();
     }
+
+    stmr_update_tick();
+}
+
+bool next_deadline(uint32_t *deadline)
+{
+    if (stmrs == NULL)
+        return false;
+
+    *deadline = stmrs->deadline;
+    return true;
 }
 
 void stmr_init(stmr_t *tmr)
@@ -105,50 +255,37 @@ void stmr_init(stmr_t *tmr)
     tmr->flags = 0;
     tmr->data = NULL;
     tmr->proc = NULL;
-    tmr->next = stmrs;
-    stmrs = tmr;
+    tmr->next = tmr->prev = NULL;
+    tmr->deadline = 0;
+    tmr->runs = tmr->overruns = 0;
+    tmr->late_max = tmr->late_total = 0;
+    stmr_add(tmr);
 }
 
 void stmr_add(stmr_t *tmr)
 {
-    tmr->next = stmrs;
-    stmrs = tmr;
+    /* an active timer is first due a period after its last event (i.e. after boot, for a TIMER_PROC) */
+    tmr->flags |= STMR_ADDED;
+    tmr->deadline = tmr->event + tmr->period;
+    stmr_schedule(tmr);
 }
 
 void stmr_free(stmr_t *tmr)
 {
-    stmr_t *t;
-    
-    if (stmrs == NULL)
-        return;
-
-    if (tmr == stmrs)
-    {
-        stmrs = tmr->next;
-        tmr->next = NULL;
-        return;
-    }
-
-    t = stmrs;
-    while (t->next != NULL)
-    {
-        if (t->next == tmr)
-        {
-            t->next = tmr->next;
-            tmr->next = NULL;
-            return;
-        }
-        t = t->next;
-    }
+    tmr->flags &= ~(uint32_t)STMR_ADDED;
+    stmr_schedule(tmr);
 }
 
 void stmr_stop(stmr_t *tmr)
 {
     tmr->flags &= ~(uint32_t)STMR_ACTIVE;
+    stmr_schedule(tmr);
 }
 
 void stmr_run(stmr_t *tmr)
 {
     tmr->flags |= STMR_ACTIVE;
     tmr->event = mtime();
+    tmr->deadline = tmr->event + tmr->period;
+    stmr_schedule(tmr);
 }
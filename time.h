@@ -42,8 +42,20 @@ extern "C" {
 
 void    time_init(void);                 /* time module initialization */
 uint32_t mtime(void);                     /* monotonic time with 1 ms precision */
+uint64_t mtime64(void);                   /* as mtime(), but 64 bits, so it never wraps */
+uint64_t utime(void);                     /* monotonic time with 1 us precision; 64 bits, so it never wraps */
+uint32_t cycletime(void);                 /* monotonic time in core clock cycles; wraps every 2^32 cycles */
 void    msleep(int ms);                  /* sleep to n ms */
 
+/* events that wake the main loop; posted by interrupt handlers with event_post(), and taken by the main loop with interrupts disabled */
+
+#define EVENT_TICK 0x01 /* SysTick: the soonest timer is due */
+#define EVENT_USB  0x02 /* link: a received frame was queued, or sent ones await reclaiming */
+
+extern volatile uint32_t events;
+
+void    event_post(uint32_t event);      /* set events atomically; from any handler, whatever preempts it */
+
 /* softeare timer types */
 
 typedef struct stmr stmr_t;
@@ -51,20 +63,29 @@ typedef struct stmr stmr_t;
 typedef void (*stmr_cb_t)(stmr_t *tmr);
 
 #define STMR_ACTIVE 1
+#define STMR_ADDED  2 /* don't touch it */
+#define STMR_QUEUED 4 /* don't touch it */
 
 struct stmr
 {
 	uint32_t  period; /* timer period, ms. */
-	uint32_t  event;  /* the last event, ms */
+	uint32_t  event;  /* the last event (as scheduled), ms */
 	uint32_t  flags;  /* STMR_XXX */
 	void     *data;   /* user data */
 	stmr_cb_t proc;   /* timer proc */
 	stmr_t   *next;   /* don't touch it */
+	stmr_t   *prev;   /* don't touch it */
+	uint32_t  deadline;   /* the next event, ms; don't touch it */
+	uint32_t  runs;       /* times the proc has been called */
+	uint32_t  overruns;   /* whole periods missed because stmr() was called too late */
+	uint32_t  late_max;   /* jitter: the most that a call has been late, ms */
+	uint32_t  late_total; /* jitter: total lateness, ms; late_total / runs is the average */
 };
 
 /* softeare timer functions */
 
-void stmr(void);             /* call it periodically */
+void stmr(void);             /* call it periodically (or on EVENT_TICK) */
+bool next_deadline(uint32_t *deadline); /* soonest deadline of any running timer, ms; false if there is none */
 void stmr_init(stmr_t *tmr); /* init timer and adds to list */
 void stmr_add(stmr_t *tmr);  /* adds timer to a timers list */
 void stmr_free(stmr_t *tmr); /* remove timer from the list */
@@ -29,11 +29,23 @@
 #include "stm32f0xx_hal.h"
 #include "usbd_core.h"
 #include "usbd_ecm.h"
+#include "usbd_ncm.h"
+#include "usbprof.h"
 
 PCD_HandleTypeDef hpcd; /* used externally by stm32f0xx_it.c */
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+
+/* the class is chosen at build time, so its endpoint callbacks can be called directly */
+#if USBD_USE_NCM
+#define USBD_CLASS_DataIn      USBD_NCM_DataIn
+#define USBD_CLASS_DataOut     USBD_NCM_DataOut
+#else
+#define USBD_CLASS_DataIn      USBD_ECM_DataIn
+#define USBD_CLASS_DataOut     USBD_ECM_DataOut
+#endif
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
@@ -96,7 +108,9 @@ void HAL_PCD_MspDeInit(PCD_HandleTypeDef *hpcd)
   */
 void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
 {
+  USB_PROF_ENTER(USB_PROF_SETUP);
   USBD_LL_SetupStage(hpcd->pData, (uint8_t *)hpcd->Setup);
+  USB_PROF_EXIT(USB_PROF_SETUP);
 }
 
 /**
@@ -107,7 +121,25 @@ void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
   */
 void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 {
-  USBD_LL_DataOutStage(hpcd->pData, epnum, hpcd->OUT_ep[epnum].xfer_buff);
+#if USBD_FAST_DISPATCH
+  USBD_HandleTypeDef *pdev = hpcd->pData;
+#endif
+  USB_PROF_ENTER(USB_PROF_DATA_OUT);
+
+#if USBD_FAST_DISPATCH
+  /* only EP0 needs the generic handling in usbd_core.c; every other endpoint belongs to the class */
+  if (epnum != 0)
+  {
+    if (pdev->dev_state == USBD_STATE_CONFIGURED)
+      USBD_CLASS_DataOut(pdev, epnum);
+  }
+  else
+#endif
+  {
+    USBD_LL_DataOutStage(hpcd->pData, epnum, hpcd->OUT_ep[epnum].xfer_buff);
+  }
+
+  USB_PROF_EXIT(USB_PROF_DATA_OUT);
 }
 
 /**
@@ -118,7 +150,25 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
   */
 void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 {
-  USBD_LL_DataInStage(hpcd->pData, epnum, hpcd->IN_ep[epnum].xfer_buff);
+#if USBD_FAST_DISPATCH
+  USBD_HandleTypeDef *pdev = hpcd->pData;
+#endif
+  USB_PROF_ENTER(USB_PROF_DATA_IN);
+
+#if USBD_FAST_DISPATCH
+  /* as HAL_PCD_DataOutStageCallback() */
+  if (epnum != 0)
+  {
+    if (pdev->dev_state == USBD_STATE_CONFIGURED)
+      USBD_CLASS_DataIn(pdev, epnum);
+  }
+  else
+#endif
+  {
+    USBD_LL_DataInStage(hpcd->pData, epnum, hpcd->IN_ep[epnum].xfer_buff);
+  }
+
+  USB_PROF_EXIT(USB_PROF_DATA_IN);
 }
 
 /**
@@ -128,7 +178,9 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
   */
 void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 {
+  USB_PROF_ENTER(USB_PROF_SOF);
   USBD_LL_SOF(hpcd->pData);
+  USB_PROF_EXIT(USB_PROF_SOF);
 }
 
 /**
@@ -221,6 +273,9 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   hpcd.Init.ep0_mps = 0x40;
   hpcd.Init.phy_itface = PCD_PHY_EMBEDDED;
   hpcd.Init.speed = PCD_SPEED_FULL;
+#ifdef ECM_DATA_EP_MASK
+  hpcd.Init.fast_ep_mask = ECM_DATA_EP_MASK;
+#endif
   /* Link The driver to the stack */
   hpcd.pData = pdev;
   pdev->pData = &hpcd;
@@ -235,11 +290,20 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   pma_address = 8 * MAX((sizeof(hpcd.IN_ep) / sizeof(*hpcd.IN_ep)), (sizeof(hpcd.OUT_ep) / sizeof(*hpcd.OUT_ep)));
 
   /* PMA allocation for EP0 */
-  HAL_PCDEx_PMAConfig(pdev->pData, 0x00, PCD_SNG_BUF, pma_address =+ USB_MAX_EP0_SIZE);
-  HAL_PCDEx_PMAConfig(pdev->pData, 0x80, PCD_SNG_BUF, pma_address =+ USB_MAX_EP0_SIZE);
+  HAL_PCDEx_PMAConfig(pdev->pData, 0x00, PCD_SNG_BUF, pma_address);
+  pma_address += USB_MAX_EP0_SIZE;
+  HAL_PCDEx_PMAConfig(pdev->pData, 0x80, PCD_SNG_BUF, pma_address);
+  pma_address += USB_MAX_EP0_SIZE;
 
   /* PMA allocation for other endpoints */
+#if USBD_USE_NCM
+  USBD_NCM_PMAConfig(pdev->pData, &pma_address);
+#else
   USBD_ECM_PMAConfig(pdev->pData, &pma_address);
+#endif
+
+  /* the F072 has 1024 bytes of PMA */
+  assert_param(pma_address <= 1024);
 
   return USBD_OK;
 }
@@ -366,6 +430,17 @@ uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
   }
 }
 
+/**
+  * @brief  Returns whether an IN endpoint still holds data for the host.
+  * @param  pdev: Device handle
+  * @param  ep_addr: Endpoint Number
+  * @retval Pending (1: Yes, 0: No)
+  */
+uint8_t USBD_LL_IsTxPendingEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return HAL_PCD_EP_IsTxPending(pdev->pData, ep_addr);
+}
+
 /**
   * @brief  Assigns a USB address to the device.
   * @param  pdev: Device handle
@@ -396,6 +471,28 @@ USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev,
   return (HAL_OK == outcome) ? USBD_OK : USBD_BUSY;
 }
 
+/**
+  * @brief  Transmits data gathered (by a callback) from several pieces of memory over an endpoint.
+  * @param  pdev: Device handle
+  * @param  ep_addr: Endpoint Number
+  * @param  gather: Callback returning each piece of the data in turn (see HAL_PCD_EP_TransmitGather)
+  * @param  context: Argument passed to gather
+  * @param  size: Data size    
+  * @param  zlp: Terminate a multiple of the max packet size with a zero-length packet
+  * @retval USBD Status
+  */
+USBD_StatusTypeDef USBD_LL_TransmitGather(USBD_HandleTypeDef *pdev, 
+                                          uint8_t ep_addr,
+                                          const uint8_t *(*gather)(void *context, uint16_t *len),
+                                          void *context,
+                                          uint16_t size,
+                                          uint8_t zlp)
+{
+  HAL_StatusTypeDef outcome;
+  outcome = HAL_PCD_EP_TransmitGather(pdev->pData, ep_addr, gather, context, size, zlp);
+  return (HAL_OK == outcome) ? USBD_OK : USBD_BUSY;
+}
+
 /**
   * @brief  Prepares an endpoint for reception.
   * @param  pdev: Device handle
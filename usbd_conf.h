@@ -38,18 +38,69 @@
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
 /* Common Config */
+
+/* number of ECM functions in the device, each with its own interfaces, endpoints and netif; the F072 has endpoints (and PMA) enough for two */
+#ifndef NUM_OF_ECM
+#define NUM_OF_ECM             1
+#endif
+
+/*
+each ECM function can hold two PBUF_POOL pbufs (one being received into by usbd_ecm.c, one queued for lwIP), and lwIP wants one more;
+PBUF_POOL_SIZE is set for all of lwIP by the project's preprocessor definitions, which should derive it from NUM_OF_ECM
+*/
+#define ECM_PBUF_POOL_MIN      (1 + 2 * NUM_OF_ECM)
+
+#if defined(PBUF_POOL_SIZE) && (PBUF_POOL_SIZE < ECM_PBUF_POOL_MIN)
+#error PBUF_POOL_SIZE is too small for NUM_OF_ECM; see ECM_PBUF_POOL_MIN
+#endif
+
+/* endpoints of the first ECM (or NCM) function */
 #define ECM_NOTIFICATION_IN_EP 0x81
 #define ECM_DATA_IN_EP         0x82
 #define ECM_DATA_OUT_EP        0x03
 
+/* endpoints of the second ECM function */
+#define ECM2_NOTIFICATION_IN_EP 0x84
+#define ECM2_DATA_IN_EP         0x85
+#define ECM2_DATA_OUT_EP        0x06
+
 #define ECM_NOTIFICATION_IN_SZ 64
 #define ECM_DATA_IN_SZ         USB_FS_MAX_PACKET_SIZE
 #define ECM_DATA_OUT_SZ        USB_FS_MAX_PACKET_SIZE
 
-#define USBD_MAX_NUM_INTERFACES               2 /* FIXME: must manually ensure this is 2x NUM_OF_ECM plus any other usage */
+/* set to 0 to give the ECM data endpoints a single PMA buffer each (rather than a pair) */
+#ifndef ECM_DOUBLE_BUFFER
+#define ECM_DOUBLE_BUFFER      1
+#endif
+
+/* set to 1 to present a CDC-NCM function (several packets per transfer) rather than CDC-ECM; the same endpoints are used */
+#ifndef USBD_USE_NCM
+#define USBD_USE_NCM           0
+#endif
+
+/* set to 0 to pass completions on the data (non-control) endpoints through the generic paths of the HAL and usbd_core.c, rather than straight to the class */
+#ifndef USBD_FAST_DISPATCH
+#define USBD_FAST_DISPATCH     1
+#endif
+
+/* the endpoint numbers (bit n for endpoint n) of the ECM data endpoints, whose interrupts PCD_EP_ISR_Handler() services directly; given to the HAL as Init.fast_ep_mask by USBD_LL_Init() */
+#if USBD_FAST_DISPATCH
+#if NUM_OF_ECM > 1
+#define ECM_DATA_EP_MASK       ((1U << (ECM_DATA_IN_EP & 0x0F)) | (1U << ECM_DATA_OUT_EP) | (1U << (ECM2_DATA_IN_EP & 0x0F)) | (1U << ECM2_DATA_OUT_EP))
+#else
+#define ECM_DATA_EP_MASK       ((1U << (ECM_DATA_IN_EP & 0x0F)) | (1U << ECM_DATA_OUT_EP))
+#endif
+#endif
+
+/* set to 1 to time the USB interrupt and the class callbacks (see usbprof.c) */
+#ifndef USB_PROFILE
+#define USB_PROFILE            0
+#endif
+
+#define USBD_MAX_NUM_INTERFACES               (2 * NUM_OF_ECM)
 #define USBD_MAX_NUM_CONFIGURATION            1
 #define USBD_MAX_STR_DESC_SIZ                 0x100
-#define USBD_SUPPORT_USER_STRING              0 
+#define USBD_SUPPORT_USER_STRING              (NUM_OF_ECM > 1) /* the MAC address strings of the second (and later) ECM functions */
 #define USBD_SELF_POWERED                     0
 #define USBD_DEBUG_LEVEL                      0
 
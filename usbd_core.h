@@ -127,12 +127,20 @@ USBD_StatusTypeDef  USBD_LL_FlushEP (USBD_HandleTypeDef *pdev, uint8_t ep_addr);
 USBD_StatusTypeDef  USBD_LL_StallEP (USBD_HandleTypeDef *pdev, uint8_t ep_addr);   
 USBD_StatusTypeDef  USBD_LL_ClearStallEP (USBD_HandleTypeDef *pdev, uint8_t ep_addr);   
 uint8_t             USBD_LL_IsStallEP (USBD_HandleTypeDef *pdev, uint8_t ep_addr);   
+uint8_t             USBD_LL_IsTxPendingEP (USBD_HandleTypeDef *pdev, uint8_t ep_addr);   
 USBD_StatusTypeDef  USBD_LL_SetUSBAddress (USBD_HandleTypeDef *pdev, uint8_t dev_addr);   
 USBD_StatusTypeDef  USBD_LL_Transmit (USBD_HandleTypeDef *pdev, 
                                       uint8_t  ep_addr,                                      
                                       uint8_t  *pbuf,
                                       uint16_t  size);
 
+USBD_StatusTypeDef  USBD_LL_TransmitGather (USBD_HandleTypeDef *pdev, 
+                                            uint8_t  ep_addr,                                      
+                                            const uint8_t *(*gather)(void *context, uint16_t *len),
+                                            void *context,
+                                            uint16_t  size,
+                                            uint8_t  zlp);
+
 USBD_StatusTypeDef  USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, 
                                            uint8_t  ep_addr,                                      
                                            uint8_t  *pbuf,
@@ -357,6 +357,12 @@ static void USBD_GetDescriptor(USBD_HandleTypeDef *pdev ,
       break;
       
     default:
+#if (USBD_SUPPORT_USER_STRING == 1)
+      /* MODIFIED: restored from ST's original, but with a NULL return stalled */
+      pbuf = pdev->pClass->GetUsrStrDescriptor(pdev, (uint8_t)(req->wValue), &len);
+      if (pbuf)
+        break;
+#endif
        USBD_CtlError(pdev , req);
       return;
     }
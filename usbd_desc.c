@@ -33,6 +33,7 @@ Leveraging the structs in usbhelper.h and ecmhelper.h, a USB descriptor for this
 #include "usbd_conf.h"
 #include "usbhelper.h"
 #include "usbd_ecm.h"
+#include "usbd_ncm.h"
 #include "ecmhelper.h"
 
 /* Private typedef -----------------------------------------------------------*/
@@ -41,7 +42,20 @@ Leveraging the structs in usbhelper.h and ecmhelper.h, a USB descriptor for this
 #define USBD_PID                      0x8887 /* temporary assignment */
 #define USBD_LANGID_STRING            0x409
 #define USBD_MANUFACTURER_STRING      "Acme"
+#if USBD_USE_NCM
+#define USBD_PRODUCT_FS_STRING        "NCM"
+#else
 #define USBD_PRODUCT_FS_STRING        "ECM"
+#endif
+
+/*
+for some peculiar reason, ST doesn't define the unique ID registers in the HAL include files
+the DEVICE_ID registers are documented in Chapter 33 of the RM0091 Reference Manual
+(a build for something other than the F072, e.g. the host build, can define DEVICE_ID2 itself)
+*/
+#ifndef DEVICE_ID2
+#define DEVICE_ID2                    (*(uint32_t*)(0x1FFFF7B0))
+#endif
 
 /* Private macro -------------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
@@ -87,7 +101,11 @@ static const struct device_descriptor hUSBDDeviceDesc =
 struct configuration_1
 {
   struct configuration_descriptor config;
-  struct ecm_interface ecm;
+#if USBD_USE_NCM
+  struct ncm_interface ncm;
+#else
+  struct ecm_interface ecm[NUM_OF_ECM];
+#endif
 };
 
 /* fully initialize the bespoke struct as a const */
@@ -105,7 +123,16 @@ __ALIGN_BEGIN static const struct configuration_1 USBD_ECM_CfgFSDesc __ALIGN_END
     50,                                              /* MaxPower */
   },
 
-  .ecm = ECM_DESCRIPTOR(/* Notify ITF */ 0x00, /* Data ITF */ 0x01, /* Notify EP */ ECM_NOTIFICATION_IN_EP, /* DataOut EP */ ECM_DATA_OUT_EP, /* DataIn EP */ ECM_DATA_IN_EP, /* iMACstring */ USBD_IDX_SERIAL_STR)
+#if USBD_USE_NCM
+  .ncm = NCM_DESCRIPTOR(/* Notify ITF */ NCM_NOTIFY_ITF, /* Data ITF */ NCM_DATA_ITF, /* Notify EP */ ECM_NOTIFICATION_IN_EP, /* DataOut EP */ ECM_DATA_OUT_EP, /* DataIn EP */ ECM_DATA_IN_EP, /* iMACstring */ USBD_IDX_SERIAL_STR)
+#else
+  .ecm = {
+    ECM_DESCRIPTOR(/* Notify ITF */ ECM_NOTIFY_ITF(0), /* Data ITF */ ECM_DATA_ITF(0), /* Notify EP */ ECM_NOTIFICATION_IN_EP, /* DataOut EP */ ECM_DATA_OUT_EP, /* DataIn EP */ ECM_DATA_IN_EP, /* iMACstring */ USBD_IDX_MAC_STR(0))
+#if (NUM_OF_ECM > 1)
+    ECM_DESCRIPTOR(/* Notify ITF */ ECM_NOTIFY_ITF(1), /* Data ITF */ ECM_DATA_ITF(1), /* Notify EP */ ECM2_NOTIFICATION_IN_EP, /* DataOut EP */ ECM2_DATA_OUT_EP, /* DataIn EP */ ECM2_DATA_IN_EP, /* iMACstring */ USBD_IDX_MAC_STR(1))
+#endif
+  },
+#endif
 };
 
 const uint8_t *const USBD_CfgFSDesc_pnt = (const uint8_t *)&USBD_ECM_CfgFSDesc;
@@ -176,19 +203,26 @@ static uint8_t *USBD_VCP_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint
   * @retval Pointer to descriptor buffer
   */
 static uint8_t *USBD_VCP_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+  return USBD_MACStrDescriptor(0, length);
+}
+
+/**
+  * @brief  Returns the MAC address string descriptor of an ECM function.
+  * @param  index: ECM function (0 is also the serial number)
+  * @param  length: Pointer to data length variable
+  * @retval Pointer to descriptor buffer
+  */
+uint8_t *USBD_MACStrDescriptor(unsigned index, uint16_t *length)
 {
   uint32_t deviceserial;
   
-  /*
-  for some peculiar reason, ST doesn't define the unique ID registers in the HAL include files
-  the DEVICE_ID registers are documented in Chapter 33 of the RM0091 Reference Manual
-  */
-  deviceserial = *(uint32_t*)(0x1FFFF7B0); /*DEVICE_ID2*/
+  deviceserial = DEVICE_ID2;
   
   USBD_StrDesc[0] = *length = 2 + 8*2 + 4*2;
   USBD_StrDesc[1] = USB_DESC_TYPE_STRING;
-  /* set upper bits to ensure classification as locally administered */
-  IntToUnicode (0x02020000, &USBD_StrDesc[2], 4);
+  /* set upper bits to ensure classification as locally administered (and unique to each ECM function) */
+  IntToUnicode (0x02020000 | (index << 26), &USBD_StrDesc[2], 4);
   /* set lower 32-bits using silicon serial number */
   IntToUnicode (deviceserial, &USBD_StrDesc[10], 8);
   return USBD_StrDesc;  
@@ -7,9 +7,13 @@
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
+/* string index of the MAC address of each ECM function; the serial number doubles as that of the first */
+#define USBD_IDX_MAC_STR(index)       (USBD_IDX_SERIAL_STR + (index))
+
 /* Exported functions ------------------------------------------------------- */
 extern const USBD_DescriptorsTypeDef VCP_Desc;
 extern const uint8_t *const USBD_CfgFSDesc_pnt;
 extern const uint16_t USBD_CfgFSDesc_len;
+uint8_t *USBD_MACStrDescriptor(unsigned index, uint16_t *length);
 
 #endif /* __USBD_DESC_H */
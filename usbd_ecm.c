@@ -27,38 +27,102 @@ Theory of operation:
 
 Each incoming virtual Ethernet packet from the host arrives via ECM_DATA_OUT_EP.
 It arrives in 64-byte chunks, and the last chunk will have a length of less than 64 (signifying a whole packet).
-These chunks are accumulated in ecm_rx_buffer, and the whole packet is passed to the user's usb_ecm_recv_callback function.
-The user indicates that another packet can be received (writing over the existing data) by calling usb_ecm_recv_renew().
+(A packet that is a multiple of 64 bytes long is ended by a zero-length chunk.)
+The HAL reads these chunks as one multi-packet transfer (ended by that short chunk) directly into the payload of a PBUF_POOL pbuf (rx_pbuf) allocated ahead of time.
+The first chunk of each packet is read on its own, so that ecm_filter_rx() (see ecmfilter.c) can check its Ethernet header.
+The rest of an unwanted packet is read over the top of that chunk and then dropped, so the pbuf is simply re-used for the next packet.
+The whole packet is then passed (as that pbuf) to the user's usb_ecm_recv_callback function.
+If the callback accepts the packet, a fresh pbuf is allocated and ECM_DATA_OUT_EP is immediately re-armed.
+If the callback declines (i.e. the user has nowhere to put it), the packet is held in rx_pbuf and the host is NAKed.
+The user offers the held packet again (once it has room for it) by calling usb_ecm_recv_renew().
 
-Note that ST's stack may refuse to "renew", so OutboundTransferNeedsRenewal exists to mop up when this happens.
+Note that ST's stack may refuse to "renew" (and the pbuf pool may be empty), so OutboundTransferNeedsRenewal exists to mop up when this happens.
+
+With ECM_DOUBLE_BUFFER, both data endpoints have a pair of PMA buffers.
+So, the host can send the next OUT chunk whilst the HAL is copying the previous one out of PMA,
+and the next IN chunk is copied into PMA whilst the previous one is still being sent.
 
 Outgoing virtual Ethernet packets are sent to the host via ECM_DATA_IN_IP.
-In theory, the ST stack can handle "multi-packet" automatically, but there seem to be issues with this.
-So, as with receive packets, transmit packets are sent to the host in 64-byte chunks.
-The user should call usb_ecm_can_xmit() to verify whether it is possible to transmit another packet.
-The user then calls usb_ecm_xmit_packet() to transmit such a packet.
+As with receive packets, each transmit packet is handed to the HAL as one multi-packet transfer, which it sends in 64-byte chunks.
+The HAL is asked to follow a packet that is a multiple of 64 bytes long with a zero-length chunk, so the host never waits for (or merges it with) the next one.
+Each chunk is gathered by the HAL straight from the pbuf chain into PMA (see ecm_tx_gather), even when it spans pbufs.
+So, there is no intermediate copy of the packet; the payload of a PBUF_ROM pbuf goes straight from flash to PMA.
+The user calls usb_ecm_xmit_packet() to queue a packet (as a pbuf) for transmission; this never blocks.
+The pbuf is referenced with pbuf_ref() and held in tx_queue until it has been sent; if the queue is full, the packet is dropped.
+The DataIn completion of a packet starts the next packet in the queue.
+(With ECM_DOUBLE_BUFFER, the next packet is handed over as soon as the last chunk of the previous one is in PMA.)
+Sent pbufs are only released by usb_ecm_xmit_reclaim() (as lwIP's heap may not be freed in an ISR), which the user should call regularly.
+
+Transmit progress is driven purely by events: a packet being queued, or the DataIn completion of an earlier one.
+(DataIn completions used to go missing because a HAL call made from the main loop could be interrupted by the USB ISR,
+whose own HAL call then found the HAL locked; the HAL_BUSY was ignored, so that packet was never sent and never completed.
+Main loop calls are now made with interrupts disabled, the ISR no longer re-enters the locking HAL API, and a refused call is retried.)
+InboundTransferNeedsRenewal mops up after a refused USBD_LL_TransmitGather(), as OutboundTransferNeedsRenewal does for receive.
+Separately, a stall watchdog (ECM_TX_STALL_TIMEOUT) counts how often a packet goes unacknowledged for too long.
+If the HAL reports that the endpoint is idle at that point, the completion really has been lost, and the packet is treated as sent.
+Otherwise the host simply isn't reading, and the packet is left in place.
+
+The link state and speed are sent to the host via ECM_NOTIFICATION_IN_EP (see ecmnotify.c).
+
+The device may have more than one ECM function (NUM_OF_ECM), each with its own interfaces, endpoints (see parameters[]) and PMA.
+All of the state above lives in a struct ecm_context per function, found from the endpoint (or interface) that an event is for.
+So, each function has its own receive pbuf, transmit queue and counters, and a busy host on one never holds up another.
 */
 
 #include "usbd_ecm.h"
 #include "usbd_desc.h"
+#include "lwip/mem.h"
+
+/* usbd_ncm.c is built instead when USBD_USE_NCM is set */
+#if !USBD_USE_NCM
+
+/*
+each chunk must land in one contiguous piece of the pbuf chain;
+the HAL also writes whole halfwords, so an odd-length final chunk needs a spare byte after it
+*/
+#if (PBUF_POOL_BUFSIZE < (ECM_MAX_SEGMENT_SIZE + 1)) && (PBUF_POOL_BUFSIZE % ECM_DATA_OUT_SZ)
+#error PBUF_POOL_BUFSIZE must either hold a whole packet or be a multiple of ECM_DATA_OUT_SZ
+#endif
+
+/* each ECM function takes three endpoints (of the seven beyond EP0) and up to 320 bytes of PMA */
+#if (NUM_OF_ECM < 1) || (NUM_OF_ECM > 2)
+#error NUM_OF_ECM must be 1 or 2
+#endif
+
+#ifndef ECM_TX_QUEUE_SIZE
+#define ECM_TX_QUEUE_SIZE 4
+#endif
+
+#if (ECM_TX_QUEUE_SIZE & (ECM_TX_QUEUE_SIZE - 1)) || (ECM_TX_QUEUE_SIZE < 2)
+#error ECM_TX_QUEUE_SIZE must be a power of two
+#endif
+
+/* SOFs (i.e. milliseconds) without a DataIn completion before the stall watchdog fires; 0 disables it */
+#ifndef ECM_TX_STALL_TIMEOUT
+#define ECM_TX_STALL_TIMEOUT 32
+#endif
+
+/* number of packets that can be handed to the HAL ahead of their acknowledgement (i.e. one per PMA buffer) */
+#if ECM_DOUBLE_BUFFER
+#define ECM_TX_DEPTH 2
+#else
+#define ECM_TX_DEPTH 1
+#endif
 
 /* USB handle declared in main.c */
 extern USBD_HandleTypeDef USBD_Device;
 
-extern void ECM_ReceivePacket(unsigned index, uint8_t *data, uint16_t length);
-
 /* local function prototyping */
 
 static uint8_t USBD_ECM_Init (USBD_HandleTypeDef *pdev, uint8_t cfgidx);
 static uint8_t USBD_ECM_DeInit (USBD_HandleTypeDef *pdev, uint8_t cfgidx);
 static uint8_t USBD_ECM_Setup (USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
-static uint8_t USBD_ECM_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum);
-static uint8_t USBD_ECM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t USBD_ECM_EP0_RxReady (USBD_HandleTypeDef *pdev);
 static const uint8_t *USBD_ECM_GetFSCfgDesc (uint16_t *length);
 static uint8_t USBD_ECM_SOF (USBD_HandleTypeDef *pdev);
-
-static USBD_StatusTypeDef USBD_ECM_ReceivePacket (USBD_HandleTypeDef *pdev, unsigned index);
+#if (USBD_SUPPORT_USER_STRING == 1)
+static uint8_t *USBD_ECM_GetUsrStrDesc (USBD_HandleTypeDef *pdev, uint8_t index, uint16_t *length);
+#endif
 
 /* class callbacks structure that is used by main.c */
 const USBD_ClassTypeDef USBD_ECM = 
@@ -74,141 +138,463 @@ const USBD_ClassTypeDef USBD_ECM =
   .IsoINIncomplete       = NULL,
   .IsoOUTIncomplete      = NULL,     
   .GetFSConfigDescriptor = USBD_ECM_GetFSCfgDesc,    
+#if (USBD_SUPPORT_USER_STRING == 1)
+  .GetUsrStrDescriptor   = USBD_ECM_GetUsrStrDesc,
+#endif
 };
 
-static USBD_HandleTypeDef *registered_pdev;
+/* endpoints of each ECM function; these must match the descriptors in usbd_desc.c */
+struct ecm_parameters
+{
+  uint8_t notification_in_ep;
+  uint8_t data_in_ep;
+  uint8_t data_out_ep;
+};
+
+static const struct ecm_parameters parameters[NUM_OF_ECM] = 
+{
+  {
+    .notification_in_ep = ECM_NOTIFICATION_IN_EP,
+    .data_in_ep         = ECM_DATA_IN_EP,
+    .data_out_ep        = ECM_DATA_OUT_EP,
+  },
+#if (NUM_OF_ECM > 1)
+  {
+    .notification_in_ep = ECM2_NOTIFICATION_IN_EP,
+    .data_in_ep         = ECM2_DATA_IN_EP,
+    .data_out_ep        = ECM2_DATA_OUT_EP,
+  },
+#endif
+};
 
-__ALIGN_BEGIN static uint8_t ecm_rx_buffer[ECM_MAX_SEGMENT_SIZE] __ALIGN_END;
-__ALIGN_BEGIN static uint8_t ecm_tx_buffer[ECM_MAX_SEGMENT_SIZE] __ALIGN_END;
-__ALIGN_BEGIN static USBD_SetupReqTypedef notify __ALIGN_END =
+struct ecm_tx_slot
 {
-  .bmRequest = 0x21,
-  .bRequest = 0 /* NETWORK_CONNECTION */,
-  .wValue = 1 /* Connected */,
-  .wLength = 0,
+  struct pbuf *p;                  /* the packet, as queued by usb_ecm_xmit_packet() */
+  struct pbuf *q;                  /* pbuf within p that ecm_tx_gather() reads from next */
+  int offset;                      /* offset within q that ecm_tx_gather() reads from next */
 };
 
-static int ecm_rx_index;
-static bool can_xmit;
-static bool OutboundTransferNeedsRenewal;
-static uint8_t *ecm_tx_ptr;
-static int ecm_tx_remaining;
-static int ecm_tx_busy;
-static int copy_length;
+/* the state of one ECM function */
+struct ecm_context
+{
+  unsigned index;                  /* of this context within context[] (and parameters[]) */
+  struct ecm_notify notify;        /* notifications to the host (see ecmnotify.c) */
+
+  struct pbuf *rx_pbuf;            /* pbuf that the packet presently being received is read into */
+  struct pbuf *rx_q;               /* pbuf within the rx_pbuf chain that the next chunk lands in */
+  int rx_offset;                   /* offset of the next chunk within rx_q */
+  int rx_armed;                    /* length of the transfer presently armed */
+  int rx_index;
+  bool rx_discard;                 /* set when the packet is unwanted (or more than ECM_MAX_SEGMENT_SIZE); the rest is read over the top of it, and then dropped */
+  bool rx_pending;
+  bool OutboundTransferNeedsRenewal;
+  bool InboundTransferNeedsRenewal;
+  int tx_outstanding;              /* packets handed to the HAL that have yet to be acknowledged */
+  int tx_stall;                    /* SOFs seen without an acknowledgement */
+
+  /*
+  tx_head is only advanced by usb_ecm_xmit_packet(), tx_next (once a packet is handed to the HAL) and
+  tx_tail (once it has been sent) only by the ISR, and tx_reclaim only by usb_ecm_xmit_reclaim();
+  the indices free-run and are reduced modulo ECM_TX_QUEUE_SIZE
+  */
+  struct ecm_tx_slot tx_queue[ECM_TX_QUEUE_SIZE];
+  volatile unsigned tx_head, tx_next, tx_tail;
+  unsigned tx_reclaim;
+  struct ecm_tx_stats tx_stats;
+  struct ecm_stats stats;
+};
 
-void usb_ecm_recv_renew(void)
+static USBD_HandleTypeDef *registered_pdev;
+
+static struct ecm_context context[NUM_OF_ECM];
+
+/* only one control transfer is ever in progress, so these are shared by all ECM functions */
+static uint8_t ecm_mc_filters[ECM_MC_FILTERS * ETHARP_HWADDR_LEN]; /* data stage of SET_ETHERNET_MULTICAST_FILTERS */
+static uint16_t ecm_mc_count;      /* number of addresses expected in ecm_mc_filters */
+static unsigned ecm_mc_index;      /* ECM function that they are for */
+__ALIGN_BEGIN static uint32_t ecm_statistic __ALIGN_END; /* data stage of GET_ETHERNET_STATISTIC */
+
+static void ecm_rx_arm(struct ecm_context *ecm)
 {
   USBD_StatusTypeDef outcome;
+  int chunk_size;
+
+  if (!ecm->rx_pbuf)
+  {
+    ecm->rx_pbuf = pbuf_alloc(PBUF_RAW, ECM_MAX_SEGMENT_SIZE, PBUF_POOL);
+    if (!ecm->rx_pbuf)
+    {
+      /* the host is NAKed until a pbuf frees up */
+      ecm->stats.pbuf_failures++;
+      ecm->OutboundTransferNeedsRenewal = true;
+      return;
+    }
+    ecm->rx_q = ecm->rx_pbuf;
+    ecm->rx_offset = 0;
+    ecm->rx_index = 0;
+  }
+
+  chunk_size = ecm->rx_q->len - ecm->rx_offset;
+  if (chunk_size <= 0)
+  {
+    /* no room left for a packet this big; keep reading (over the top of it) until it ends, and then discard it */
+    ecm_filter_count_oversize(ecm->index);
+    ecm->rx_discard = true;
+    ecm->rx_q = ecm->rx_pbuf;
+    ecm->rx_offset = 0;
+    chunk_size = ecm->rx_q->len;
+  }
+
+  /* the first chunk (holding the Ethernet header) is read on its own, so that an unwanted packet is recognised straight away */
+  if (!ecm->rx_index && (chunk_size > ECM_DATA_OUT_SZ))
+    chunk_size = ECM_DATA_OUT_SZ;
+
+  ecm->rx_armed = chunk_size;
+
+  /* a double-buffered endpoint may complete a chunk that arrived early (and so re-enter this function) from within USBD_LL_PrepareReceive() */
+  ecm->OutboundTransferNeedsRenewal = false;
+
+  outcome = USBD_LL_PrepareReceive(registered_pdev, parameters[ecm->index].data_out_ep, (uint8_t *)ecm->rx_q->payload + ecm->rx_offset, chunk_size);
+
+  if (USBD_OK != outcome)
+    ecm->OutboundTransferNeedsRenewal = true; /* set if the HAL was busy so that we know to retry it */
+}
+
+static void ecm_rx_deliver(struct ecm_context *ecm)
+{
+  bool retry = ecm->rx_pending;
+
+  ecm->rx_pending = !usb_ecm_recv_callback(ecm->index, ecm->rx_pbuf);
+
+  if (ecm->rx_pending)
+  {
+    if (!retry)
+      ecm->stats.rx_overruns++;
+    return; /* the packet stays in rx_pbuf, and the host is NAKed until usb_ecm_recv_renew() */
+  }
+
+  ecm->stats.frames_in++;
+  ecm->stats.bytes_in += ecm->rx_pbuf->tot_len;
 
-  outcome = USBD_LL_PrepareReceive(registered_pdev, ECM_DATA_OUT_EP, ecm_rx_buffer + ecm_rx_index, ECM_DATA_OUT_SZ);
+  /* the user now owns the pbuf */
+  ecm->rx_pbuf = NULL;
+  ecm_rx_arm(ecm);
+}
+
+void usb_ecm_recv_renew(unsigned index)
+{
+  struct ecm_context *ecm = &context[index];
 
-  OutboundTransferNeedsRenewal = (USBD_OK != outcome); /* set if the HAL was busy so that we know to retry it */
+  if (!registered_pdev)
+    return;
+
+  __disable_irq();
+  if (ecm->rx_pending)
+  {
+    ecm_rx_deliver(ecm);
+  }
+  else if (ecm->OutboundTransferNeedsRenewal)
+  {
+    ecm->stats.renew_retries++;
+    ecm_rx_arm(ecm);
+  }
+  __enable_irq();
 }
 
 static uint8_t USBD_ECM_Init (USBD_HandleTypeDef *pdev, uint8_t cfgidx)
 {
+  struct ecm_context *ecm = context;
+  unsigned index;
+
   registered_pdev = pdev;
 
-  /* Open EP IN */
-  USBD_LL_OpenEP(pdev, ECM_DATA_IN_EP, USBD_EP_TYPE_BULK, ECM_DATA_IN_SZ);
+  for (index = 0; index < NUM_OF_ECM; index++, ecm++)
+  {
+    /* Open EP IN */
+    USBD_LL_OpenEP(pdev, parameters[index].data_in_ep, USBD_EP_TYPE_BULK, ECM_DATA_IN_SZ);
   
-  /* Open EP OUT */
-  USBD_LL_OpenEP(pdev, ECM_DATA_OUT_EP, USBD_EP_TYPE_BULK, ECM_DATA_OUT_SZ);
+    /* Open EP OUT */
+    USBD_LL_OpenEP(pdev, parameters[index].data_out_ep, USBD_EP_TYPE_BULK, ECM_DATA_OUT_SZ);
 
-  /* Open Command IN EP */
-  USBD_LL_OpenEP(pdev, ECM_NOTIFICATION_IN_EP, USBD_EP_TYPE_INTR, ECM_NOTIFICATION_IN_SZ);
+    /* Open Command IN EP */
+    USBD_LL_OpenEP(pdev, parameters[index].notification_in_ep, USBD_EP_TYPE_INTR, ECM_NOTIFICATION_IN_SZ);
 
-  usb_ecm_recv_renew();
-  can_xmit = true;
-  OutboundTransferNeedsRenewal = false;
-  ecm_tx_busy = 0;
-  ecm_tx_remaining = 0;
+    ecm->index = index;
+    ecm_notify_init(&ecm->notify, parameters[index].notification_in_ep, ECM_NOTIFY_ITF(index));
+
+    ecm_filter_reset(index);
+
+    ecm->rx_pending = false;
+    ecm->rx_discard = false;
+    ecm_rx_arm(ecm);
+    ecm->tx_outstanding = 0;
+    ecm->tx_stall = 0;
+    ecm->InboundTransferNeedsRenewal = false;
+  }
 
   return USBD_OK;
 }
 
 static uint8_t USBD_ECM_DeInit (USBD_HandleTypeDef *pdev, uint8_t cfgidx)
 {
+  struct ecm_context *ecm = context;
+  unsigned index;
+
   registered_pdev = NULL;
 
-  /* Close EP IN */
-  USBD_LL_CloseEP(pdev, ECM_DATA_IN_EP);
+  for (index = 0; index < NUM_OF_ECM; index++, ecm++)
+  {
+    /* Close EP IN */
+    USBD_LL_CloseEP(pdev, parameters[index].data_in_ep);
 
-  /* Close EP OUT */
-  USBD_LL_CloseEP(pdev, ECM_DATA_OUT_EP);
+    /* Close EP OUT */
+    USBD_LL_CloseEP(pdev, parameters[index].data_out_ep);
 
-  /* Close Command IN EP */
-  USBD_LL_CloseEP(pdev, ECM_NOTIFICATION_IN_EP);
+    /* Close Command IN EP */
+    USBD_LL_CloseEP(pdev, parameters[index].notification_in_ep);
+    ecm_notify_init(&ecm->notify, parameters[index].notification_in_ep, ECM_NOTIFY_ITF(index));
 
-  can_xmit = false;
+    /* abandon anything still queued for transmission; usb_ecm_xmit_reclaim() will release it */
+    ecm->tx_outstanding = 0;
+    ecm->tx_next = ecm->tx_head;
+    ecm->tx_tail = ecm->tx_head;
+    if (ecm->tx_reclaim != ecm->tx_tail)
+      usb_ecm_xmit_callback(index);
+
+    if (ecm->rx_pbuf)
+    {
+      pbuf_free(ecm->rx_pbuf);
+      ecm->rx_pbuf = NULL;
+    }
+  }
 
   return USBD_OK;
 }
 
+/*
+look up one of the statistics advertised in bmEthernetStatistics; returns false for any other feature selector
+the device plays the part of the network adapter, so frames from the host are "transmitted" and frames to it are "received"
+*/
+static bool ecm_get_statistic(struct ecm_context *ecm, uint16_t selector, uint32_t *value)
+{
+  struct ecm_filter_stats filter_stats;
+
+  usb_ecm_get_filter_stats(ecm->index, &filter_stats);
+
+  switch (selector)
+  {
+  case 1 /* XMIT_OK */:
+    *value = ecm->stats.frames_in;
+    return true;
+  case 2 /* RCV_OK */:
+    *value = ecm->stats.frames_out;
+    return true;
+  case 3 /* XMIT_ERROR */:
+    *value = filter_stats.rx_runt + filter_stats.rx_oversize;
+    return true;
+  case 5 /* RCV_NO_BUFFER */:
+    *value = ecm->tx_stats.drops;
+    return true;
+  case 23 /* XMIT_DEFERRED */:
+    *value = ecm->stats.rx_overruns;
+    return true;
+  default:
+    return false;
+  }
+}
+
 static uint8_t USBD_ECM_Setup (USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
 {
-  if (0x43 /* SET_ETHERNET_PACKET_FILTER */ == req->bRequest)
+  struct ecm_context *ecm;
+  unsigned index;
+
+  /* class requests are addressed to the notification interface of an ECM function */
+  index = LOBYTE(req->wIndex) / 2;
+  if (index >= NUM_OF_ECM)
+    return USBD_OK;
+  ecm = &context[index];
+
+  if (0x44 /* GET_ETHERNET_STATISTIC */ == req->bRequest)
   {
-    notify.wIndex = req->wIndex;
-    USBD_LL_Transmit(pdev, ECM_NOTIFICATION_IN_EP, (uint8_t *)&notify, sizeof(notify));
+    if (ecm_get_statistic(ecm, req->wValue, &ecm_statistic))
+      USBD_CtlSendData(pdev, (uint8_t *)&ecm_statistic, MIN(sizeof(ecm_statistic), req->wLength));
+    else
+      USBD_CtlError(pdev, req);
+  }
+  else if (0x43 /* SET_ETHERNET_PACKET_FILTER */ == req->bRequest)
+  {
+    ecm_filter_set_packet_filter(index, req->wValue);
+
+    /* the host is now listening for the link state (and speed) */
+    ecm_notify_start(&ecm->notify, pdev);
+  }
+  else if (0x40 /* SET_ETHERNET_MULTICAST_FILTERS */ == req->bRequest)
+  {
+    if ((req->wValue > ECM_MC_FILTERS) || (req->wLength != req->wValue * ETHARP_HWADDR_LEN))
+    {
+      /* more addresses than advertised in wMCFilters */
+      USBD_CtlError(pdev, req);
+    }
+    else if (req->wValue)
+    {
+      /* the table is rebuilt by USBD_ECM_EP0_RxReady() once the addresses arrive */
+      ecm_mc_count = req->wValue;
+      ecm_mc_index = index;
+      USBD_CtlPrepareRx(pdev, ecm_mc_filters, req->wLength);
+    }
+    else
+    {
+      ecm_filter_set_multicast(index, NULL, 0);
+    }
   }
 
   return USBD_OK;
 }
 
-static void ecm_incoming_attempt(void)
+/* called by the HAL as it fills PMA; returns the next contiguous piece (of at most *len bytes) of the packet in the given slot */
+static const uint8_t *ecm_tx_gather(void *context, uint16_t *len)
 {
-  int chunk_size;
+  struct ecm_tx_slot *slot = context;
+  const uint8_t *data;
+  int piece;
+
+  /* move on to the next pbuf in the chain once this one is used up (skipping any empty ones) */
+  while (slot->offset >= slot->q->len)
+  {
+    slot->q = slot->q->next;
+    slot->offset = 0;
+  }
+
+  piece = slot->q->len - slot->offset;
+  if (piece > *len)
+    piece = *len;
+
+  data = (const uint8_t *)slot->q->payload + slot->offset;
+  slot->offset += piece;
+  *len = piece;
 
-  if (!ecm_tx_remaining || ecm_tx_busy)
+  return data;
+}
+
+static void ecm_incoming_attempt(struct ecm_context *ecm)
+{
+  struct ecm_tx_slot *slot;
+
+  if (!registered_pdev)
     return;
 
-  chunk_size = ecm_tx_remaining;
-  if (chunk_size > ECM_DATA_IN_SZ)
-    chunk_size = ECM_DATA_IN_SZ;
+  ecm->InboundTransferNeedsRenewal = false;
 
-  /* ST stack always returns a success code, so reading the return value is pointless */
-  USBD_LL_Transmit(registered_pdev, ECM_DATA_IN_EP, ecm_tx_ptr, chunk_size);
+  while ((ecm->tx_outstanding < ECM_TX_DEPTH) && (ecm->tx_next != ecm->tx_head))
+  {
+    slot = &ecm->tx_queue[ecm->tx_next % ECM_TX_QUEUE_SIZE];
+    slot->q = slot->p;
+    slot->offset = 0;
 
-  ecm_tx_ptr += chunk_size;
-  ecm_tx_remaining -= chunk_size;
-  ecm_tx_busy = 1;
+    /* nothing has been gathered if the HAL refuses; the SOF handler will try again */
+    if (USBD_OK != USBD_LL_TransmitGather(registered_pdev, parameters[ecm->index].data_in_ep, ecm_tx_gather, slot, slot->p->tot_len, 1))
+    {
+      ecm->tx_stats.busy_retries++;
+      ecm->InboundTransferNeedsRenewal = true;
+      return;
+    }
+
+    ecm->tx_next++;
+    ecm->tx_outstanding++;
+  }
 }
 
-static uint8_t USBD_ECM_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
+static void ecm_tx_complete(struct ecm_context *ecm)
 {
-  if (ECM_DATA_IN_EP == (epnum | 0x80))
+  /* the oldest packet handed to the HAL has been sent */
+  if (ecm->tx_outstanding)
   {
-    ecm_tx_busy = 0;
-    if (0 == ecm_tx_remaining)
-      can_xmit = true;
-    ecm_incoming_attempt();
+    ecm->stats.frames_out++;
+    ecm->stats.bytes_out += ecm->tx_queue[ecm->tx_tail % ECM_TX_QUEUE_SIZE].p->tot_len;
+    ecm->tx_outstanding--;
+    ecm->tx_tail++;
+    usb_ecm_xmit_callback(ecm->index);
+  }
+  ecm->tx_stall = 0;
+  ecm_incoming_attempt(ecm);
+}
+
+uint8_t USBD_ECM_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  unsigned index;
+
+  for (index = 0; index < NUM_OF_ECM; index++)
+  {
+    if (parameters[index].data_in_ep == (epnum | 0x80))
+      ecm_tx_complete(&context[index]);
+    else if (parameters[index].notification_in_ep == (epnum | 0x80))
+      ecm_notify_complete(&context[index].notify);
   }
 
   return USBD_OK;
 }
 
-static uint8_t USBD_ECM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum)
+uint8_t USBD_ECM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum)
 {      
+  struct ecm_context *ecm = context;
   uint32_t RxLength;
+  unsigned index;
 
-  if (ECM_DATA_OUT_EP != epnum)
+  for (index = 0; index < NUM_OF_ECM; index++, ecm++)
+  {
+    if (parameters[index].data_out_ep == epnum)
+      break;
+  }
+
+  if (NUM_OF_ECM == index)
     return USBD_OK;
 
   /* Get the received data length */
   RxLength = USBD_LL_GetRxDataSize (pdev, epnum);
 
-  ecm_rx_index += RxLength;
+  ecm->rx_index += RxLength;
+  ecm->rx_offset += RxLength;
 
-  if (RxLength < ECM_DATA_OUT_SZ)
+  /* classify the packet as soon as its first chunk is in */
+  if (!ecm->rx_discard && RxLength && (ecm->rx_index == (int)RxLength) && !ecm_filter_rx(index, ecm->rx_pbuf->payload, RxLength))
+    ecm->rx_discard = true;
+
+  /* the packet has ended if the transfer was cut short (or finished with a chunk of less than 64 bytes, including a zero-length one) */
+  if (((int)RxLength < ecm->rx_armed) || (RxLength % ECM_DATA_OUT_SZ))
   {
-    usb_ecm_recv_callback(ecm_rx_buffer, ecm_rx_index);
-    ecm_rx_index = 0;
+    /* a zero-length chunk with no packet ahead of it is not a packet at all */
+    if (ecm->rx_discard || !ecm->rx_index)
+    {
+      /* re-use the pbuf for the next packet */
+      ecm->rx_discard = false;
+      ecm->rx_q = ecm->rx_pbuf;
+      ecm->rx_offset = 0;
+      ecm->rx_index = 0;
+      ecm_rx_arm(ecm);
+      return USBD_OK;
+    }
+
+    /* trim the pbuf (chain) down to the packet that actually arrived */
+    pbuf_realloc(ecm->rx_pbuf, ecm->rx_index);
+    ecm_rx_deliver(ecm);
   }
   else
   {
-    /* Initiate next USB packet transfer */
-    usb_ecm_recv_renew();
+    if (ecm->rx_discard)
+    {
+      /* an unwanted packet keeps being read over the top of the pbuf */
+      ecm->rx_q = ecm->rx_pbuf;
+      ecm->rx_offset = 0;
+    }
+    else if ((ecm->rx_offset >= ecm->rx_q->len) && ecm->rx_q->next)
+    {
+      /* move on to the next pbuf in the chain once this one is full */
+      ecm->rx_q = ecm->rx_q->next;
+      ecm->rx_offset = 0;
+    }
+
+    /* Initiate next USB transfer */
+    ecm_rx_arm(ecm);
   }
 
   return USBD_OK;
@@ -216,28 +602,53 @@ static uint8_t USBD_ECM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum)
 
 static uint8_t USBD_ECM_SOF (USBD_HandleTypeDef *pdev)
 {
-  /* mop up for any failed USBD_LL_PrepareReceive() call */
-  if (OutboundTransferNeedsRenewal)
-    usb_ecm_recv_renew();
+  struct ecm_context *ecm = context;
+  unsigned index;
 
-  if (ecm_tx_busy)
+  for (index = 0; index < NUM_OF_ECM; index++, ecm++)
   {
-    /* ugly hack for ST stack sometimes not providing the DataOut callback */
-    if (++ecm_tx_busy > 32)
+    /* mop up for any failed USBD_LL_PrepareReceive() call */
+    if (ecm->OutboundTransferNeedsRenewal)
     {
-      ecm_tx_busy = 0;
-      if (0 == ecm_tx_remaining)
-        can_xmit = true;
+      ecm->stats.renew_retries++;
+      ecm_rx_arm(ecm);
     }
-  }
 
-  ecm_incoming_attempt();
+    /* ...and likewise for a failed USBD_LL_TransmitGather() call */
+    if (ecm->InboundTransferNeedsRenewal)
+      ecm_incoming_attempt(ecm);
+
+    /* ...and for a notification that the HAL was too busy to take */
+    ecm_notify_service(&ecm->notify);
+
+#if ECM_TX_STALL_TIMEOUT
+    if (ecm->tx_outstanding && (++ecm->tx_stall >= ECM_TX_STALL_TIMEOUT))
+    {
+      ecm->tx_stall = 0;
+      ecm->tx_stats.stalls++;
+
+      /* an idle endpoint means the completion was lost; otherwise, the host isn't reading and the packet stays put */
+      if (!USBD_LL_IsTxPendingEP(pdev, parameters[index].data_in_ep))
+      {
+        ecm->tx_stats.lost_completions++;
+        ecm_tx_complete(ecm);
+      }
+    }
+#endif
+  }
 
   return USBD_OK;
 }
 
 static uint8_t USBD_ECM_EP0_RxReady (USBD_HandleTypeDef *pdev)
-{ 
+{
+  /* the only request with a data stage is SET_ETHERNET_MULTICAST_FILTERS */
+  if (ecm_mc_count)
+  {
+    ecm_filter_set_multicast(ecm_mc_index, ecm_mc_filters, ecm_mc_count);
+    ecm_mc_count = 0;
+  }
+
   return USBD_OK;
 }
 
@@ -247,57 +658,116 @@ static const uint8_t *USBD_ECM_GetFSCfgDesc (uint16_t *length)
   return USBD_CfgFSDesc_pnt;
 }
 
-uint8_t USBD_ECM_RegisterInterface(USBD_HandleTypeDef *pdev)
+#if (USBD_SUPPORT_USER_STRING == 1)
+static uint8_t *USBD_ECM_GetUsrStrDesc (USBD_HandleTypeDef *pdev, uint8_t index, uint16_t *length)
 {
-  unsigned index;
+  /* the MAC address strings of the second and later ECM functions follow the serial number */
+  if ((index > USBD_IDX_MAC_STR(0)) && (index < USBD_IDX_MAC_STR(NUM_OF_ECM)))
+    return USBD_MACStrDescriptor(index - USBD_IDX_MAC_STR(0), length);
 
+  return NULL;
+}
+#endif
+
+uint8_t USBD_ECM_RegisterInterface(USBD_HandleTypeDef *pdev)
+{
   return USBD_OK;
 }
 
 void USBD_ECM_PMAConfig(PCD_HandleTypeDef *hpcd, uint32_t *pma_address)
 {
+  unsigned index;
+
   /* allocate PMA memory for all endpoints associated with ECM */
-  HAL_PCDEx_PMAConfig(hpcd, ECM_DATA_IN_EP,  PCD_SNG_BUF, *pma_address);
-  *pma_address += ECM_DATA_IN_SZ;
-  HAL_PCDEx_PMAConfig(hpcd, ECM_DATA_OUT_EP, PCD_SNG_BUF, *pma_address);
-  *pma_address += ECM_DATA_OUT_SZ;
-  HAL_PCDEx_PMAConfig(hpcd, ECM_NOTIFICATION_IN_EP,  PCD_SNG_BUF, *pma_address);
-  *pma_address += ECM_NOTIFICATION_IN_SZ;
+  for (index = 0; index < NUM_OF_ECM; index++)
+  {
+#if ECM_DOUBLE_BUFFER
+    /* a double-buffered endpoint takes its two buffer addresses packed into the low and high halfwords */
+    HAL_PCDEx_PMAConfig(hpcd, parameters[index].data_in_ep,  PCD_DBL_BUF, *pma_address | ((*pma_address + ECM_DATA_IN_SZ) << 16));
+    *pma_address += 2 * ECM_DATA_IN_SZ;
+    HAL_PCDEx_PMAConfig(hpcd, parameters[index].data_out_ep, PCD_DBL_BUF, *pma_address | ((*pma_address + ECM_DATA_OUT_SZ) << 16));
+    *pma_address += 2 * ECM_DATA_OUT_SZ;
+#else
+    HAL_PCDEx_PMAConfig(hpcd, parameters[index].data_in_ep,  PCD_SNG_BUF, *pma_address);
+    *pma_address += ECM_DATA_IN_SZ;
+    HAL_PCDEx_PMAConfig(hpcd, parameters[index].data_out_ep, PCD_SNG_BUF, *pma_address);
+    *pma_address += ECM_DATA_OUT_SZ;
+#endif
+    HAL_PCDEx_PMAConfig(hpcd, parameters[index].notification_in_ep,  PCD_SNG_BUF, *pma_address);
+    *pma_address += ECM_NOTIFICATION_IN_SZ;
+  }
+}
+
+void usb_ecm_xmit_reclaim(unsigned index)
+{
+  struct ecm_context *ecm = &context[index];
+  struct pbuf *p;
+
+  while (ecm->tx_reclaim != ecm->tx_tail)
+  {
+    p = ecm->tx_queue[ecm->tx_reclaim % ECM_TX_QUEUE_SIZE].p;
+    ecm->tx_queue[ecm->tx_reclaim % ECM_TX_QUEUE_SIZE].p = NULL;
+    ecm->tx_reclaim++;
+    pbuf_free(p);
+  }
 }
 
-bool usb_ecm_can_xmit(void)
+bool usb_ecm_xmit_packet(unsigned index, struct pbuf *p)
 {
-  bool outcome;
+  struct ecm_context *ecm = &context[index];
+  unsigned occupancy;
+
+  usb_ecm_xmit_reclaim(index);
+
+  occupancy = ecm->tx_head - ecm->tx_reclaim;
+
+  if (!registered_pdev || (p->tot_len > ECM_MAX_SEGMENT_SIZE) || (occupancy >= ECM_TX_QUEUE_SIZE))
+  {
+    ecm->tx_stats.drops++;
+    return false;
+  }
+
+  /* the host doesn't want to see this type of packet */
+  if (!ecm_filter_tx(index, p))
+    return true;
+
+  /* hold onto the pbuf until it has been sent */
+  pbuf_ref(p);
+  ecm->tx_queue[ecm->tx_head % ECM_TX_QUEUE_SIZE].p = p;
+  ecm->tx_head++;
+
+  ecm->tx_stats.queued++;
+  if (++occupancy > ecm->tx_stats.high_water)
+    ecm->tx_stats.high_water = occupancy;
 
+  /* start sending it if the IN endpoint is idle */
   __disable_irq();
-  outcome = can_xmit;
+  ecm_incoming_attempt(ecm);
   __enable_irq();
 
-  return outcome;
+  return true;
 }
 
-void usb_ecm_xmit_packet(struct pbuf *p)
+void usb_ecm_xmit_get_stats(unsigned index, struct ecm_tx_stats *stats)
 {
-  struct pbuf *q;
-  int packet_size;
-  uint8_t *data;
+  struct ecm_context *ecm = &context[index];
 
-  if (!registered_pdev || !can_xmit)
-    return;
+  *stats = ecm->tx_stats;
+  stats->occupancy = ecm->tx_head - ecm->tx_reclaim;
+}
 
-  data = ecm_tx_buffer;
-  packet_size = 0;
-  for(q = p; q != NULL; q = q->next)
-  {
-      memcpy(data, q->payload, q->len);
-      data += q->len;
-      packet_size += q->len;
-  }
+void usb_ecm_set_link(unsigned index, bool up)
+{
+  __disable_irq();
+  ecm_notify_link(&context[index].notify, up);
+  __enable_irq();
+}
 
+void usb_ecm_get_stats(unsigned index, struct ecm_stats *stats)
+{
   __disable_irq();
-  can_xmit = false;
-  ecm_tx_ptr = ecm_tx_buffer;
-  ecm_tx_remaining = packet_size;
-  copy_length = packet_size;
+  *stats = context[index].stats;
   __enable_irq();
 }
+
+#endif /* !USBD_USE_NCM */
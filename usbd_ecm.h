@@ -31,20 +31,70 @@
 #include "usbd_ioreq.h"
 #include "netif/etharp.h"
 #include "ecmhelper.h"
+#include "ecmfilter.h"
+#include "ecmnotify.h"
 
 #define ETH_HEADER_SIZE             14
 #define ECM_MTU                     (ECM_MAX_SEGMENT_SIZE - ETH_HEADER_SIZE)
 
+/* interface numbers used by each ECM function in usbd_desc.c */
+#define ECM_NOTIFY_ITF(index)       (2 * (index))
+#define ECM_DATA_ITF(index)         (2 * (index) + 1)
+
 /* array of callback functions invoked by USBD_RegisterClass() in main.c */
 extern const USBD_ClassTypeDef USBD_ECM;
 
+/* the class's DataIn and DataOut callbacks, which usbd_conf.c also calls directly (see USBD_FAST_DISPATCH) */
+uint8_t USBD_ECM_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_ECM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum);
+
 uint8_t USBD_ECM_RegisterInterface(USBD_HandleTypeDef *pdev);
 void USBD_ECM_PMAConfig(PCD_HandleTypeDef *hpcd, uint32_t *pma_address);
 
-void usb_ecm_recv_callback(const uint8_t *data, int size);
-void usb_ecm_recv_renew(void);
+/*
+the usb_ecm_* functions take the index (from 0 to NUM_OF_ECM - 1) of the ECM function concerned;
+each has its own queues and counters, so traffic on one never holds up another
+*/
+
+/* called during an ISR with a PBUF_POOL pbuf; return true to take ownership of it, or false to leave the frame pending (and the host NAKed) until usb_ecm_recv_renew() */
+bool usb_ecm_recv_callback(unsigned index, struct pbuf *frame);
+/* re-offer any pending frame to usb_ecm_recv_callback(); call once there is room for it */
+void usb_ecm_recv_renew(unsigned index);
+
+struct ecm_tx_stats
+{
+  unsigned occupancy;        /* packets presently held in the transmit queue */
+  unsigned high_water;       /* most packets ever held in the transmit queue */
+  uint32_t queued;           /* packets accepted by usb_ecm_xmit_packet() */
+  uint32_t drops;            /* packets refused by usb_ecm_xmit_packet() */
+  uint32_t busy_retries;     /* packets the HAL refused to start (and that were retried) */
+  uint32_t stalls;           /* times the stall watchdog fired */
+  uint32_t lost_completions; /* stalls where the HAL had finished but no DataIn completion arrived */
+};
+
+struct ecm_stats
+{
+  uint32_t frames_in;        /* frames from the host taken by usb_ecm_recv_callback() */
+  uint32_t bytes_in;         /* ...and their total length */
+  uint32_t frames_out;       /* frames sent to the host */
+  uint32_t bytes_out;        /* ...and their total length */
+  uint32_t rx_overruns;      /* frames that usb_ecm_recv_callback() declined (leaving the host NAKed) */
+  uint32_t pbuf_failures;    /* attempts to allocate a PBUF_POOL pbuf for frames from the host that failed */
+  uint32_t renew_retries;    /* times reception had to be restarted (OutboundTransferNeedsRenewal) */
+};
+
+/* report a change of the (netif's) link state to the host; the link starts out up */
+void usb_ecm_set_link(unsigned index, bool up);
+
+/* traffic counters; TX busy rejections and watchdog recoveries are in struct ecm_tx_stats, filtered frames in struct ecm_filter_stats */
+void usb_ecm_get_stats(unsigned index, struct ecm_stats *stats);
 
-bool usb_ecm_can_xmit(void);
-void usb_ecm_xmit_packet(struct pbuf *p);
+/* queue a packet for transmission to the host; never blocks, and returns false if the packet was dropped for lack of room (packets withheld by the host's packet filter count as sent) */
+bool usb_ecm_xmit_packet(unsigned index, struct pbuf *p);
+/* called during an ISR once a packet has been sent, and so has a pbuf for usb_ecm_xmit_reclaim() to release; it must not block */
+void usb_ecm_xmit_callback(unsigned index);
+/* release the pbufs of packets that have been sent; call from outside of any ISR (after usb_ecm_xmit_callback()) */
+void usb_ecm_xmit_reclaim(unsigned index);
+void usb_ecm_xmit_get_stats(unsigned index, struct ecm_tx_stats *stats);
   
 #endif  // __USB_ECM_H_
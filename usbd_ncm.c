@@ -0,0 +1,947 @@
+/*
+    USB CDC-NCM for STM32F072 microcontroller
+
+    Copyright (C) 2015,2016,2018 Peter Lawrence
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+This is the CDC-NCM counterpart of usbd_ecm.c, and is built instead of it when USBD_USE_NCM is set.
+Rather than one Ethernet packet (datagram) per USB transfer, NCM packs several datagrams into each transfer (a Network Transfer Block, or NTB).
+So, small packets (TCP ACKs, DNS, ARP) no longer cost a whole transfer (and a mostly empty 64-byte USB packet) each.
+Only 16-bit NTBs (NTB16) are supported, and CRCs are neither sent nor accepted.
+
+The data endpoints are only opened once the host selects alternate setting 1 of the data interface.
+
+Each incoming NTB from the host arrives via ECM_DATA_OUT_EP as one multi-packet transfer into ncm_rx_ntb.
+It is parsed (see ncm_rx_process) and each datagram is copied into a PBUF_POOL pbuf and passed to the user's usb_ecm_recv_callback function.
+Datagrams that ecm_filter_rx() (see ecmfilter.c) rejects are skipped without being copied.
+If the callback declines (or the pbuf pool is empty), parsing pauses (with the host NAKed) until usb_ecm_recv_renew() (or the next SOF, respectively).
+ECM_DATA_OUT_EP is re-armed once every datagram in the NTB has been taken.
+
+Outgoing packets are queued by usb_ecm_xmit_packet() exactly as in usbd_ecm.c.
+Queued packets are packed into an NTB (see ncm_tx_build), which is sent to the host via ECM_DATA_IN_EP as one multi-packet transfer.
+There is no NTB buffer; the HAL gathers the NTH, each datagram (straight from its pbuf chain), the padding and the NDP into PMA (see ncm_tx_gather).
+An NTB is closed and sent once it is full, or once the previous NTB has been acknowledged, or else after NCM_TX_TIMEOUT SOFs.
+So, packets queued whilst the IN endpoint is busy (or within NCM_TX_TIMEOUT of each other) share an NTB.
+*/
+
+#include "usbd_ncm.h"
+#include "usbd_desc.h"
+
+#if USBD_USE_NCM
+
+/* only one NCM function is supported; its usb_ecm_* index is always 0 */
+#if (NUM_OF_ECM != 1)
+#error NUM_OF_ECM must be 1 with USBD_USE_NCM
+#endif
+
+/* dwNtbOutMaxSize: the largest NTB accepted from the host (this much RAM is set aside for ncm_rx_ntb) */
+#ifndef NCM_NTB_OUT_MAX_SIZE
+#define NCM_NTB_OUT_MAX_SIZE 2048
+#endif
+
+/* dwNtbInMaxSize: the largest NTB sent to the host (this costs no RAM, as NTBs are gathered straight from the pbufs) */
+#ifndef NCM_NTB_IN_MAX_SIZE
+#define NCM_NTB_IN_MAX_SIZE 2048
+#endif
+
+#ifndef NCM_TX_QUEUE_SIZE
+#define NCM_TX_QUEUE_SIZE 8
+#endif
+
+#if (NCM_TX_QUEUE_SIZE & (NCM_TX_QUEUE_SIZE - 1)) || (NCM_TX_QUEUE_SIZE < 2)
+#error NCM_TX_QUEUE_SIZE must be a power of two
+#endif
+
+/* most datagrams packed into one NTB */
+#ifndef NCM_TX_MAX_DATAGRAMS
+#define NCM_TX_MAX_DATAGRAMS NCM_TX_QUEUE_SIZE
+#endif
+
+/* SOFs (i.e. milliseconds) that a part-filled NTB waits for more datagrams, if the IN endpoint is idle; 0 sends at once */
+#ifndef NCM_TX_TIMEOUT
+#define NCM_TX_TIMEOUT 1
+#endif
+
+/* SOFs (i.e. milliseconds) without a DataIn completion before the stall watchdog fires; 0 disables it */
+#ifndef ECM_TX_STALL_TIMEOUT
+#define ECM_TX_STALL_TIMEOUT 32
+#endif
+
+/* number of NTBs that can be handed to the HAL ahead of their acknowledgement (i.e. one per PMA buffer) */
+#if ECM_DOUBLE_BUFFER
+#define NCM_TX_DEPTH 2
+#else
+#define NCM_TX_DEPTH 1
+#endif
+
+#define NCM_NTH16_SIGNATURE 0x484D434E /* "NCMH" */
+#define NCM_NDP16_SIGNATURE 0x304D434E /* "NCM0" (i.e. without CRC) */
+#define NCM_NTH16_SIZE      12
+#define NCM_NDP16_SIZE(n)   (8 + 4 * ((n) + 1)) /* header, n datagram entries, and the null entry that terminates them */
+#define NCM_ALIGNMENT       4                   /* wNdpInDivisor, wNdpInAlignment, and likewise for OUT */
+#define NCM_ALIGN(x)        (((x) + (NCM_ALIGNMENT - 1)) & ~(NCM_ALIGNMENT - 1))
+
+#if (NCM_NTB_IN_MAX_SIZE < (NCM_ALIGN(NCM_NTH16_SIZE + ECM_MAX_SEGMENT_SIZE) + NCM_NDP16_SIZE(1))) || (NCM_NTB_IN_MAX_SIZE > 65535)
+#error NCM_NTB_IN_MAX_SIZE must fit one maximum-size datagram (and be usable with NTB16)
+#endif
+
+#if (NCM_NTB_OUT_MAX_SIZE < (NCM_ALIGN(NCM_NTH16_SIZE + ECM_MAX_SEGMENT_SIZE) + NCM_NDP16_SIZE(1))) || (NCM_NTB_OUT_MAX_SIZE > 65535)
+#error NCM_NTB_OUT_MAX_SIZE must fit one maximum-size datagram (and be usable with NTB16)
+#endif
+
+/* local function prototyping */
+
+static uint8_t USBD_NCM_Init (USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_NCM_DeInit (USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_NCM_Setup (USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_NCM_EP0_RxReady (USBD_HandleTypeDef *pdev);
+static const uint8_t *USBD_NCM_GetFSCfgDesc (uint16_t *length);
+static uint8_t USBD_NCM_SOF (USBD_HandleTypeDef *pdev);
+
+/* class callbacks structure that is used by main.c */
+const USBD_ClassTypeDef USBD_NCM =
+{
+  .Init                  = USBD_NCM_Init,
+  .DeInit                = USBD_NCM_DeInit,
+  .Setup                 = USBD_NCM_Setup,
+  .EP0_TxSent            = NULL,
+  .EP0_RxReady           = USBD_NCM_EP0_RxReady,
+  .DataIn                = USBD_NCM_DataIn,
+  .DataOut               = USBD_NCM_DataOut,
+  .SOF                   = USBD_NCM_SOF,
+  .IsoINIncomplete       = NULL,
+  .IsoOUTIncomplete      = NULL,
+  .GetFSConfigDescriptor = USBD_NCM_GetFSCfgDesc,
+};
+
+/* reply to GET_NTB_PARAMETERS */
+struct ntb_parameters
+{
+  struct usb_uint16 wLength;
+  struct usb_uint16 bmNtbFormatsSupported;
+  struct usb_uint32 dwNtbInMaxSize;
+  struct usb_uint16 wNdpInDivisor;
+  struct usb_uint16 wNdpInPayloadRemainder;
+  struct usb_uint16 wNdpInAlignment;
+  struct usb_uint16 wReserved;
+  struct usb_uint32 dwNtbOutMaxSize;
+  struct usb_uint16 wNdpOutDivisor;
+  struct usb_uint16 wNdpOutPayloadRemainder;
+  struct usb_uint16 wNdpOutAlignment;
+  struct usb_uint16 wNtbOutMaxDatagrams;
+};
+
+__ALIGN_BEGIN static const struct ntb_parameters ncm_ntb_parameters __ALIGN_END =
+{
+  .wLength                 = USB_UINT16(sizeof(struct ntb_parameters)),
+  .bmNtbFormatsSupported   = USB_UINT16(0x0001), /* NTB16 only */
+  .dwNtbInMaxSize          = USB_UINT32(NCM_NTB_IN_MAX_SIZE),
+  .wNdpInDivisor           = USB_UINT16(NCM_ALIGNMENT),
+  .wNdpInPayloadRemainder  = USB_UINT16(0),
+  .wNdpInAlignment         = USB_UINT16(NCM_ALIGNMENT),
+  .wReserved               = USB_UINT16(0),
+  .dwNtbOutMaxSize         = USB_UINT32(NCM_NTB_OUT_MAX_SIZE),
+  .wNdpOutDivisor          = USB_UINT16(NCM_ALIGNMENT),
+  .wNdpOutPayloadRemainder = USB_UINT16(0),
+  .wNdpOutAlignment        = USB_UINT16(NCM_ALIGNMENT),
+  .wNtbOutMaxDatagrams     = USB_UINT16(0),      /* no limit */
+};
+
+static USBD_HandleTypeDef *registered_pdev;
+static uint8_t ncm_alt_setting;    /* alternate setting of the data interface; the data endpoints are only open for 1 */
+
+static struct ecm_notify ncm_notify; /* notifications to the host (see ecmnotify.c) */
+
+static uint8_t ncm_mc_filters[ECM_MC_FILTERS * ETHARP_HWADDR_LEN]; /* data stage of SET_ETHERNET_MULTICAST_FILTERS */
+static uint16_t ncm_mc_count;      /* number of addresses expected in ncm_mc_filters */
+
+static uint32_t ncm_rx_ntb[NCM_NTB_OUT_MAX_SIZE / 4]; /* the NTB presently being received or parsed */
+static uint16_t ncm_rx_length;     /* wBlockLength of the NTB in ncm_rx_ntb */
+static uint16_t ncm_rx_ndp;        /* offset of the NDP presently being parsed, or 0 once they are all done */
+static uint16_t ncm_rx_entry;      /* next datagram entry within that NDP */
+static uint16_t ncm_rx_ndps;       /* NDPs parsed so far; a well-formed NTB cannot chain more than fit in it */
+static struct pbuf *ncm_rx_pbuf;   /* datagram declined by usb_ecm_recv_callback(), to be offered again */
+static bool ncm_rx_pending;
+static bool OutboundTransferNeedsRenewal;
+static bool InboundTransferNeedsRenewal;
+static int ncm_tx_stall;           /* SOFs seen without an acknowledgement */
+static int ncm_tx_wait;            /* SOFs that the oldest unsent packet has waited */
+
+struct ncm_tx_ntb
+{
+  unsigned first;                  /* ncm_tx_queue index of the first datagram */
+  unsigned count;                  /* datagrams in the NTB */
+  uint16_t ndp_index;              /* offset of the NDP (which follows the datagrams) */
+  uint16_t length;                 /* wBlockLength */
+  uint8_t nth[NCM_NTH16_SIZE];
+  uint8_t ndp[NCM_NDP16_SIZE(NCM_TX_MAX_DATAGRAMS)];
+  uint16_t position;               /* offset within the NTB that ncm_tx_gather() reads from next */
+  unsigned datagram;               /* datagram that ncm_tx_gather() is presently reading */
+  struct pbuf *q;                  /* pbuf within that datagram that ncm_tx_gather() reads from next */
+  int offset;                      /* offset within q that ncm_tx_gather() reads from next */
+};
+
+/*
+as in usbd_ecm.c, ncm_tx_head is only advanced by usb_ecm_xmit_packet(), ncm_tx_next (once a packet is packed into an NTB) and
+ncm_tx_tail (once it has been sent) only by the ISR, and ncm_tx_reclaim only by usb_ecm_xmit_reclaim();
+ncm_tx_issued and ncm_tx_done likewise count the NTBs handed to the HAL and acknowledged;
+the indices free-run and are reduced modulo NCM_TX_QUEUE_SIZE (or NCM_TX_DEPTH)
+*/
+static struct pbuf *ncm_tx_queue[NCM_TX_QUEUE_SIZE];
+static volatile unsigned ncm_tx_head, ncm_tx_next, ncm_tx_tail;
+static unsigned ncm_tx_reclaim;
+static struct ncm_tx_ntb ncm_tx_ntbs[NCM_TX_DEPTH];
+static unsigned ncm_tx_issued, ncm_tx_done;
+static struct ecm_tx_stats ecm_tx_stats;
+static struct ncm_stats ncm_stats;
+static struct ecm_stats ecm_stats;
+__ALIGN_BEGIN static uint32_t ncm_statistic __ALIGN_END; /* data stage of GET_ETHERNET_STATISTIC */
+
+static const uint8_t ncm_zeroes[NCM_ALIGNMENT];
+
+static uint16_t ncm_get16(const uint8_t *src)
+{
+  return (uint16_t)src[0] | (uint16_t)src[1] << 8;
+}
+
+static uint32_t ncm_get32(const uint8_t *src)
+{
+  return (uint32_t)ncm_get16(src) | (uint32_t)ncm_get16(src + 2) << 16;
+}
+
+static void ncm_put16(uint8_t *dst, uint16_t value)
+{
+  dst[0] = LOBYTE(value);
+  dst[1] = HIBYTE(value);
+}
+
+static void ncm_put32(uint8_t *dst, uint32_t value)
+{
+  ncm_put16(dst, value);
+  ncm_put16(dst + 2, value >> 16);
+}
+
+static void ncm_rx_arm(void)
+{
+  USBD_StatusTypeDef outcome;
+
+  ncm_rx_ndp = 0;
+
+  /* a double-buffered endpoint may complete an NTB that arrived early (and so re-enter this function) from within USBD_LL_PrepareReceive() */
+  OutboundTransferNeedsRenewal = false;
+
+  outcome = USBD_LL_PrepareReceive(registered_pdev, ECM_DATA_OUT_EP, (uint8_t *)ncm_rx_ntb, sizeof(ncm_rx_ntb));
+
+  if (USBD_OK != outcome)
+    OutboundTransferNeedsRenewal = true; /* set if the HAL was busy so that we know to retry it */
+}
+
+/* move on to the next NDP in the chain; returns false once there are none left */
+static bool ncm_rx_next_ndp(uint16_t index)
+{
+  const uint8_t *ntb = (const uint8_t *)ncm_rx_ntb;
+  uint16_t length;
+
+  ncm_rx_ndp = 0;
+  ncm_rx_entry = 0;
+
+  if (!index)
+    return false;
+
+  if ((++ncm_rx_ndps > ncm_rx_length / NCM_NDP16_SIZE(1)) || (index % NCM_ALIGNMENT) || ((uint32_t)index + NCM_NDP16_SIZE(0) > ncm_rx_length))
+    goto malformed;
+
+  length = ncm_get16(ntb + index + 4);
+  if ((NCM_NDP16_SIGNATURE != ncm_get32(ntb + index)) || (length < NCM_NDP16_SIZE(1)) || (length % 4) || ((uint32_t)index + length > ncm_rx_length))
+    goto malformed;
+
+  ncm_rx_ndp = index;
+  return true;
+
+malformed:
+  ncm_stats.errors_in++;
+  return false;
+}
+
+/* offer each datagram of the received NTB in turn to usb_ecm_recv_callback(), and re-arm for the next NTB once they are all taken */
+static void ncm_rx_process(void)
+{
+  const uint8_t *ntb = (const uint8_t *)ncm_rx_ntb;
+  const uint8_t *entry;
+  uint16_t index, length;
+  bool retry;
+
+  while (ncm_rx_ndp)
+  {
+    if (!ncm_rx_pbuf)
+    {
+      /* the entries end with a null one (or with the NDP itself) */
+      if ((uint32_t)NCM_NDP16_SIZE(ncm_rx_entry) > ncm_get16(ntb + ncm_rx_ndp + 4))
+      {
+        ncm_rx_next_ndp(ncm_get16(ntb + ncm_rx_ndp + 6));
+        continue;
+      }
+
+      entry = ntb + ncm_rx_ndp + 8 + 4 * ncm_rx_entry;
+      index = ncm_get16(entry);
+      length = ncm_get16(entry + 2);
+
+      if (!index || !length)
+      {
+        ncm_rx_next_ndp(ncm_get16(ntb + ncm_rx_ndp + 6));
+        continue;
+      }
+
+      if ((length > ECM_MAX_SEGMENT_SIZE) || ((uint32_t)index + length > ncm_rx_length))
+      {
+        ncm_stats.errors_in++;
+        ncm_rx_entry++;
+        continue;
+      }
+
+      /* an unwanted datagram is dropped before it costs a pbuf */
+      if (!ecm_filter_rx(0, ntb + index, length))
+      {
+        ncm_rx_entry++;
+        continue;
+      }
+
+      ncm_rx_pbuf = pbuf_alloc(PBUF_RAW, length, PBUF_POOL);
+      if (!ncm_rx_pbuf)
+      {
+        /* the host is NAKed until a pbuf frees up */
+        ecm_stats.pbuf_failures++;
+        OutboundTransferNeedsRenewal = true;
+        return;
+      }
+      pbuf_take(ncm_rx_pbuf, ntb + index, length);
+    }
+
+    retry = ncm_rx_pending;
+    ncm_rx_pending = !usb_ecm_recv_callback(0, ncm_rx_pbuf);
+
+    if (ncm_rx_pending)
+    {
+      if (!retry)
+        ecm_stats.rx_overruns++;
+      return; /* the datagram stays in ncm_rx_pbuf, and the host is NAKed until usb_ecm_recv_renew() */
+    }
+
+    ecm_stats.frames_in++;
+    ecm_stats.bytes_in += ncm_rx_pbuf->tot_len;
+
+    /* the user now owns the pbuf */
+    ncm_rx_pbuf = NULL;
+    ncm_rx_entry++;
+    ncm_stats.datagrams_in++;
+  }
+
+  ncm_rx_arm();
+}
+
+void usb_ecm_recv_renew(unsigned index)
+{
+  if (!registered_pdev)
+    return;
+
+  __disable_irq();
+  if (ncm_rx_pending || (OutboundTransferNeedsRenewal && ncm_rx_ndp))
+  {
+    if (!ncm_rx_pending)
+      ecm_stats.renew_retries++;
+    ncm_rx_process();
+  }
+  else if (OutboundTransferNeedsRenewal && ncm_alt_setting)
+  {
+    ecm_stats.renew_retries++;
+    ncm_rx_arm();
+  }
+  __enable_irq();
+}
+
+static void ncm_tx_abandon(void)
+{
+  /* usb_ecm_xmit_reclaim() will release anything still queued */
+  ncm_tx_next = ncm_tx_head;
+  ncm_tx_tail = ncm_tx_head;
+  if (ncm_tx_reclaim != ncm_tx_tail)
+    usb_ecm_xmit_callback(0);
+  ncm_tx_done = ncm_tx_issued;
+  ncm_tx_stall = 0;
+  ncm_tx_wait = 0;
+  InboundTransferNeedsRenewal = false;
+}
+
+static void ncm_data_close(USBD_HandleTypeDef *pdev)
+{
+  ncm_alt_setting = 0;
+
+  USBD_LL_CloseEP(pdev, ECM_DATA_IN_EP);
+  USBD_LL_CloseEP(pdev, ECM_DATA_OUT_EP);
+
+  ncm_tx_abandon();
+
+  ncm_rx_ndp = 0;
+  ncm_rx_pending = false;
+  OutboundTransferNeedsRenewal = false;
+  if (ncm_rx_pbuf)
+  {
+    pbuf_free(ncm_rx_pbuf);
+    ncm_rx_pbuf = NULL;
+  }
+}
+
+static void ncm_data_open(USBD_HandleTypeDef *pdev)
+{
+  /* Open EP IN */
+  USBD_LL_OpenEP(pdev, ECM_DATA_IN_EP, USBD_EP_TYPE_BULK, ECM_DATA_IN_SZ);
+
+  /* Open EP OUT */
+  USBD_LL_OpenEP(pdev, ECM_DATA_OUT_EP, USBD_EP_TYPE_BULK, ECM_DATA_OUT_SZ);
+
+  ncm_alt_setting = 1;
+  ncm_rx_arm();
+
+  /* the host treats the link as down until told otherwise */
+  ecm_notify_start(&ncm_notify, pdev);
+}
+
+static uint8_t USBD_NCM_Init (USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  registered_pdev = pdev;
+
+  /* Open Command IN EP */
+  USBD_LL_OpenEP(pdev, ECM_NOTIFICATION_IN_EP, USBD_EP_TYPE_INTR, ECM_NOTIFICATION_IN_SZ);
+  ecm_notify_init(&ncm_notify, ECM_NOTIFICATION_IN_EP, NCM_NOTIFY_ITF);
+
+  ecm_filter_reset(0);
+
+  /* the data endpoints wait for alternate setting 1 of the data interface */
+  ncm_data_close(pdev);
+
+  return USBD_OK;
+}
+
+static uint8_t USBD_NCM_DeInit (USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  registered_pdev = NULL;
+
+  ncm_data_close(pdev);
+
+  /* Close Command IN EP */
+  USBD_LL_CloseEP(pdev, ECM_NOTIFICATION_IN_EP);
+  ecm_notify_init(&ncm_notify, ECM_NOTIFICATION_IN_EP, NCM_NOTIFY_ITF);
+
+  return USBD_OK;
+}
+
+/*
+look up one of the statistics advertised in bmEthernetStatistics; returns false for any other feature selector
+as in usbd_ecm.c, frames from the host are "transmitted" and frames to it are "received"
+*/
+static bool ncm_get_statistic(uint16_t selector, uint32_t *value)
+{
+  struct ecm_filter_stats filter_stats;
+
+  usb_ecm_get_filter_stats(0, &filter_stats);
+
+  switch (selector)
+  {
+  case 1 /* XMIT_OK */:
+    *value = ecm_stats.frames_in;
+    return true;
+  case 2 /* RCV_OK */:
+    *value = ecm_stats.frames_out;
+    return true;
+  case 3 /* XMIT_ERROR */:
+    *value = filter_stats.rx_runt + filter_stats.rx_oversize + ncm_stats.errors_in;
+    return true;
+  case 5 /* RCV_NO_BUFFER */:
+    *value = ecm_tx_stats.drops;
+    return true;
+  case 23 /* XMIT_DEFERRED */:
+    *value = ecm_stats.rx_overruns;
+    return true;
+  default:
+    return false;
+  }
+}
+
+static uint8_t USBD_NCM_Setup (USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  static uint8_t alt_setting;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+  case USB_REQ_TYPE_STANDARD:
+    if (USB_REQ_GET_INTERFACE == req->bRequest)
+    {
+      alt_setting = (NCM_DATA_ITF == LOBYTE(req->wIndex)) ? ncm_alt_setting : 0;
+      USBD_CtlSendData(pdev, &alt_setting, 1);
+    }
+    else if ((USB_REQ_SET_INTERFACE == req->bRequest) && (NCM_DATA_ITF == LOBYTE(req->wIndex)))
+    {
+      /* selecting either setting resets the data toggles, and abandons whatever was in progress */
+      ncm_data_close(pdev);
+      if (1 == req->wValue)
+        ncm_data_open(pdev);
+    }
+    break;
+
+  case USB_REQ_TYPE_CLASS:
+    if (0x80 /* GET_NTB_PARAMETERS */ == req->bRequest)
+    {
+      USBD_CtlSendData(pdev, (uint8_t *)&ncm_ntb_parameters, MIN(sizeof(ncm_ntb_parameters), req->wLength));
+    }
+    else if (0x44 /* GET_ETHERNET_STATISTIC */ == req->bRequest)
+    {
+      if (ncm_get_statistic(req->wValue, &ncm_statistic))
+        USBD_CtlSendData(pdev, (uint8_t *)&ncm_statistic, MIN(sizeof(ncm_statistic), req->wLength));
+      else
+        USBD_CtlError(pdev, req);
+    }
+    else if (0x43 /* SET_ETHERNET_PACKET_FILTER */ == req->bRequest)
+    {
+      ecm_filter_set_packet_filter(0, req->wValue);
+
+      ecm_notify_start(&ncm_notify, pdev);
+    }
+    else if (0x40 /* SET_ETHERNET_MULTICAST_FILTERS */ == req->bRequest)
+    {
+      if ((req->wValue > ECM_MC_FILTERS) || (req->wLength != req->wValue * ETHARP_HWADDR_LEN))
+      {
+        /* more addresses than advertised in wMCFilters */
+        USBD_CtlError(pdev, req);
+      }
+      else if (req->wValue)
+      {
+        /* the table is rebuilt by USBD_NCM_EP0_RxReady() once the addresses arrive */
+        ncm_mc_count = req->wValue;
+        USBD_CtlPrepareRx(pdev, ncm_mc_filters, req->wLength);
+      }
+      else
+      {
+        ecm_filter_set_multicast(0, NULL, 0);
+      }
+    }
+    break;
+  }
+
+  return USBD_OK;
+}
+
+/*
+pack as many queued packets as will fit into the given NTB, writing its NTH and NDP;
+returns false (leaving the packets queued) if the NTB has room to spare and flush is false
+*/
+static bool ncm_tx_build(struct ncm_tx_ntb *ntb, bool flush)
+{
+  struct pbuf *p;
+  unsigned count, available;
+  uint16_t start, position;
+
+  available = ncm_tx_head - ncm_tx_next;
+  position = NCM_NTH16_SIZE;
+
+  for (count = 0; (count < available) && (count < NCM_TX_MAX_DATAGRAMS); count++)
+  {
+    p = ncm_tx_queue[(ncm_tx_next + count) % NCM_TX_QUEUE_SIZE];
+    start = NCM_ALIGN(position);
+
+    /* the NDP (with an entry for this packet) must still fit after it */
+    if ((uint32_t)NCM_ALIGN(start + p->tot_len) + NCM_NDP16_SIZE(count + 1) > NCM_NTB_IN_MAX_SIZE)
+    {
+      flush = true;
+      break;
+    }
+
+    ncm_put16(&ntb->ndp[8 + 4 * count], start);
+    ncm_put16(&ntb->ndp[8 + 4 * count + 2], p->tot_len);
+    position = start + p->tot_len;
+  }
+
+  if (NCM_TX_MAX_DATAGRAMS == count)
+    flush = true;
+
+  if (!count || !flush)
+    return false;
+
+  ntb->first = ncm_tx_next;
+  ntb->count = count;
+  ntb->ndp_index = NCM_ALIGN(position);
+  ntb->length = ntb->ndp_index + NCM_NDP16_SIZE(count);
+
+  ncm_put32(&ntb->nth[0], NCM_NTH16_SIGNATURE);
+  ncm_put16(&ntb->nth[4], NCM_NTH16_SIZE);
+  ncm_put16(&ntb->nth[6], ncm_tx_issued);       /* wSequence */
+  ncm_put16(&ntb->nth[8], ntb->length);         /* wBlockLength */
+  ncm_put16(&ntb->nth[10], ntb->ndp_index);     /* wNdpIndex */
+
+  ncm_put32(&ntb->ndp[0], NCM_NDP16_SIGNATURE);
+  ncm_put16(&ntb->ndp[4], NCM_NDP16_SIZE(count)); /* wLength */
+  ncm_put16(&ntb->ndp[6], 0);                     /* wNextNdpIndex */
+  ncm_put32(&ntb->ndp[8 + 4 * count], 0);         /* null entry */
+
+  ntb->position = 0;
+  ntb->datagram = 0;
+  ntb->q = ncm_tx_queue[ntb->first % NCM_TX_QUEUE_SIZE];
+  ntb->offset = 0;
+
+  return true;
+}
+
+/* called by the HAL as it fills PMA; returns the next contiguous piece (of at most *len bytes) of the given NTB */
+static const uint8_t *ncm_tx_gather(void *context, uint16_t *len)
+{
+  struct ncm_tx_ntb *ntb = context;
+  const uint8_t *data;
+  uint16_t start, end = 0, piece;
+  bool in_datagram = false;
+
+  if (ntb->position < NCM_NTH16_SIZE)
+  {
+    data = ntb->nth + ntb->position;
+    piece = NCM_NTH16_SIZE - ntb->position;
+  }
+  else if (ntb->datagram < ntb->count)
+  {
+    start = ncm_get16(&ntb->ndp[8 + 4 * ntb->datagram]);
+    end = start + ncm_get16(&ntb->ndp[8 + 4 * ntb->datagram + 2]);
+
+    if (ntb->position < start)
+    {
+      /* padding ahead of the datagram */
+      data = ncm_zeroes;
+      piece = start - ntb->position;
+    }
+    else
+    {
+      /* move on to the next pbuf in the chain once this one is used up (skipping any empty ones) */
+      while (ntb->offset >= ntb->q->len)
+      {
+        ntb->q = ntb->q->next;
+        ntb->offset = 0;
+      }
+
+      data = (const uint8_t *)ntb->q->payload + ntb->offset;
+      piece = ntb->q->len - ntb->offset;
+      in_datagram = true;
+    }
+  }
+  else if (ntb->position < ntb->ndp_index)
+  {
+    /* padding ahead of the NDP */
+    data = ncm_zeroes;
+    piece = ntb->ndp_index - ntb->position;
+  }
+  else
+  {
+    data = ntb->ndp + (ntb->position - ntb->ndp_index);
+    piece = ntb->length - ntb->position;
+  }
+
+  if (piece > *len)
+    piece = *len;
+
+  ntb->position += piece;
+  *len = piece;
+
+  if (in_datagram)
+  {
+    ntb->offset += piece;
+
+    if (ntb->position == end)
+    {
+      if (++ntb->datagram < ntb->count)
+        ntb->q = ncm_tx_queue[(ntb->first + ntb->datagram) % NCM_TX_QUEUE_SIZE];
+      ntb->offset = 0;
+    }
+  }
+
+  return data;
+}
+
+static void ncm_incoming_attempt(bool flush)
+{
+  struct ncm_tx_ntb *ntb;
+
+  if (!ncm_alt_setting)
+    return;
+
+  InboundTransferNeedsRenewal = false;
+
+  while (((ncm_tx_issued - ncm_tx_done) < NCM_TX_DEPTH) && (ncm_tx_next != ncm_tx_head))
+  {
+    ntb = &ncm_tx_ntbs[ncm_tx_issued % NCM_TX_DEPTH];
+
+    if (!ncm_tx_build(ntb, flush || !NCM_TX_TIMEOUT))
+      return;
+
+    /* nothing has been gathered if the HAL refuses; the SOF handler will try again; an NTB of dwNtbInMaxSize needs no ZLP */
+    if (USBD_OK != USBD_LL_TransmitGather(registered_pdev, ECM_DATA_IN_EP, ncm_tx_gather, ntb, ntb->length, ntb->length != NCM_NTB_IN_MAX_SIZE))
+    {
+      ecm_tx_stats.busy_retries++;
+      InboundTransferNeedsRenewal = true;
+      return;
+    }
+
+    ncm_tx_next += ntb->count;
+    ncm_tx_issued++;
+    ncm_tx_wait = 0;
+
+    ncm_stats.ntbs_out++;
+    ncm_stats.datagrams_out += ntb->count;
+  }
+}
+
+static void ncm_tx_complete(void)
+{
+  const struct ncm_tx_ntb *ntb;
+  unsigned i;
+
+  /* the oldest NTB handed to the HAL has been sent */
+  if (ncm_tx_issued != ncm_tx_done)
+  {
+    ntb = &ncm_tx_ntbs[ncm_tx_done % NCM_TX_DEPTH];
+    for (i = 0; i < ntb->count; i++)
+      ecm_stats.bytes_out += ncm_tx_queue[(ncm_tx_tail + i) % NCM_TX_QUEUE_SIZE]->tot_len;
+    ecm_stats.frames_out += ntb->count;
+
+    ncm_tx_tail += ntb->count;
+    ncm_tx_done++;
+    usb_ecm_xmit_callback(0);
+  }
+  ncm_tx_stall = 0;
+
+  /* whatever was queued whilst that NTB was being sent goes now */
+  ncm_incoming_attempt(true);
+}
+
+uint8_t USBD_NCM_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (ECM_DATA_IN_EP == (epnum | 0x80))
+    ncm_tx_complete();
+  else if (ECM_NOTIFICATION_IN_EP == (epnum | 0x80))
+    ecm_notify_complete(&ncm_notify);
+
+  return USBD_OK;
+}
+
+uint8_t USBD_NCM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  const uint8_t *ntb = (const uint8_t *)ncm_rx_ntb;
+  uint32_t RxLength;
+
+  if (ECM_DATA_OUT_EP != epnum)
+    return USBD_OK;
+
+  /* Get the received data length */
+  RxLength = USBD_LL_GetRxDataSize (pdev, epnum);
+
+  /* a zero-length packet after an NTB of dwNtbOutMaxSize is not an NTB at all */
+  if (!RxLength)
+  {
+    ncm_rx_arm();
+    return USBD_OK;
+  }
+
+  ncm_stats.ntbs_in++;
+
+  ncm_rx_length = ncm_get16(ntb + 8);
+
+  if ((RxLength < NCM_NTH16_SIZE) || (NCM_NTH16_SIGNATURE != ncm_get32(ntb)) || (NCM_NTH16_SIZE != ncm_get16(ntb + 4)) || (ncm_rx_length > RxLength))
+  {
+    ncm_stats.errors_in++;
+    ncm_rx_arm();
+    return USBD_OK;
+  }
+
+  ncm_rx_ndps = 0;
+  ncm_rx_next_ndp(ncm_get16(ntb + 10));
+  ncm_rx_process();
+
+  return USBD_OK;
+}
+
+static uint8_t USBD_NCM_SOF (USBD_HandleTypeDef *pdev)
+{
+  /* retry a notification that the HAL was too busy to take */
+  ecm_notify_service(&ncm_notify);
+
+  if (!ncm_alt_setting)
+    return USBD_OK;
+
+  /* mop up for any failed USBD_LL_PrepareReceive() call (or pbuf_alloc() whilst parsing) */
+  if (OutboundTransferNeedsRenewal)
+  {
+    ecm_stats.renew_retries++;
+    if (ncm_rx_ndp)
+      ncm_rx_process();
+    else
+      ncm_rx_arm();
+  }
+
+  /* close a part-filled NTB once it has waited long enough (or retry a failed USBD_LL_TransmitGather() call) */
+  if ((ncm_tx_next != ncm_tx_head) && (++ncm_tx_wait >= NCM_TX_TIMEOUT))
+    ncm_incoming_attempt(true);
+  else if (InboundTransferNeedsRenewal)
+    ncm_incoming_attempt(false);
+
+#if ECM_TX_STALL_TIMEOUT
+  if ((ncm_tx_issued != ncm_tx_done) && (++ncm_tx_stall >= ECM_TX_STALL_TIMEOUT))
+  {
+    ncm_tx_stall = 0;
+    ecm_tx_stats.stalls++;
+
+    /* an idle endpoint means the completion was lost; otherwise, the host isn't reading and the NTB stays put */
+    if (!USBD_LL_IsTxPendingEP(pdev, ECM_DATA_IN_EP))
+    {
+      ecm_tx_stats.lost_completions++;
+      ncm_tx_complete();
+    }
+  }
+#endif
+
+  return USBD_OK;
+}
+
+static uint8_t USBD_NCM_EP0_RxReady (USBD_HandleTypeDef *pdev)
+{
+  /* the only request with a data stage is SET_ETHERNET_MULTICAST_FILTERS */
+  if (ncm_mc_count)
+  {
+    ecm_filter_set_multicast(0, ncm_mc_filters, ncm_mc_count);
+    ncm_mc_count = 0;
+  }
+
+  return USBD_OK;
+}
+
+static const uint8_t *USBD_NCM_GetFSCfgDesc (uint16_t *length)
+{
+  *length = USBD_CfgFSDesc_len;
+  return USBD_CfgFSDesc_pnt;
+}
+
+uint8_t USBD_NCM_RegisterInterface(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+void USBD_NCM_PMAConfig(PCD_HandleTypeDef *hpcd, uint32_t *pma_address)
+{
+  /* allocate PMA memory for all endpoints associated with NCM */
+#if ECM_DOUBLE_BUFFER
+  /* a double-buffered endpoint takes its two buffer addresses packed into the low and high halfwords */
+  HAL_PCDEx_PMAConfig(hpcd, ECM_DATA_IN_EP,  PCD_DBL_BUF, *pma_address | ((*pma_address + ECM_DATA_IN_SZ) << 16));
+  *pma_address += 2 * ECM_DATA_IN_SZ;
+  HAL_PCDEx_PMAConfig(hpcd, ECM_DATA_OUT_EP, PCD_DBL_BUF, *pma_address | ((*pma_address + ECM_DATA_OUT_SZ) << 16));
+  *pma_address += 2 * ECM_DATA_OUT_SZ;
+#else
+  HAL_PCDEx_PMAConfig(hpcd, ECM_DATA_IN_EP,  PCD_SNG_BUF, *pma_address);
+  *pma_address += ECM_DATA_IN_SZ;
+  HAL_PCDEx_PMAConfig(hpcd, ECM_DATA_OUT_EP, PCD_SNG_BUF, *pma_address);
+  *pma_address += ECM_DATA_OUT_SZ;
+#endif
+  HAL_PCDEx_PMAConfig(hpcd, ECM_NOTIFICATION_IN_EP,  PCD_SNG_BUF, *pma_address);
+  *pma_address += ECM_NOTIFICATION_IN_SZ;
+}
+
+void usb_ecm_xmit_reclaim(unsigned index)
+{
+  struct pbuf *p;
+
+  while (ncm_tx_reclaim != ncm_tx_tail)
+  {
+    p = ncm_tx_queue[ncm_tx_reclaim % NCM_TX_QUEUE_SIZE];
+    ncm_tx_queue[ncm_tx_reclaim % NCM_TX_QUEUE_SIZE] = NULL;
+    ncm_tx_reclaim++;
+    pbuf_free(p);
+  }
+}
+
+bool usb_ecm_xmit_packet(unsigned index, struct pbuf *p)
+{
+  unsigned occupancy;
+
+  usb_ecm_xmit_reclaim(0);
+
+  occupancy = ncm_tx_head - ncm_tx_reclaim;
+
+  if (!ncm_alt_setting || (p->tot_len > ECM_MAX_SEGMENT_SIZE) || (occupancy >= NCM_TX_QUEUE_SIZE))
+  {
+    ecm_tx_stats.drops++;
+    return false;
+  }
+
+  /* the host doesn't want to see this type of packet */
+  if (!ecm_filter_tx(0, p))
+    return true;
+
+  /* hold onto the pbuf until it has been sent */
+  pbuf_ref(p);
+  ncm_tx_queue[ncm_tx_head % NCM_TX_QUEUE_SIZE] = p;
+  ncm_tx_head++;
+
+  ecm_tx_stats.queued++;
+  if (++occupancy > ecm_tx_stats.high_water)
+    ecm_tx_stats.high_water = occupancy;
+
+  /* start sending if this fills an NTB (otherwise, the SOF handler closes it after NCM_TX_TIMEOUT) */
+  __disable_irq();
+  ncm_incoming_attempt(false);
+  __enable_irq();
+
+  return true;
+}
+
+void usb_ecm_xmit_get_stats(unsigned index, struct ecm_tx_stats *stats)
+{
+  *stats = ecm_tx_stats;
+  stats->occupancy = ncm_tx_head - ncm_tx_reclaim;
+}
+
+void usb_ecm_set_link(unsigned index, bool up)
+{
+  __disable_irq();
+  ecm_notify_link(&ncm_notify, up);
+  __enable_irq();
+}
+
+void usb_ecm_get_stats(unsigned index, struct ecm_stats *stats)
+{
+  __disable_irq();
+  *stats = ecm_stats;
+  __enable_irq();
+}
+
+void usb_ncm_get_stats(struct ncm_stats *stats)
+{
+  __disable_irq();
+  *stats = ncm_stats;
+  __enable_irq();
+}
+
+#endif /* USBD_USE_NCM */
@@ -0,0 +1,60 @@
+/*
+    USB CDC-NCM for STM32F072 microcontroller
+
+    Copyright (C) 2015,2016,2018 Peter Lawrence
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef __USB_NCM_H_
+#define __USB_NCM_H_
+
+/*
+usbd_ncm.c is built instead of usbd_ecm.c when USBD_USE_NCM is set;
+it provides the same usb_ecm_* packet interface (see usbd_ecm.h), so the user's code is unchanged
+*/
+#include "usbd_ecm.h"
+
+/* interface numbers used by the NCM function in usbd_desc.c */
+#define NCM_NOTIFY_ITF              0x00
+#define NCM_DATA_ITF                0x01
+
+/* array of callback functions invoked by USBD_RegisterClass() in main.c */
+extern const USBD_ClassTypeDef USBD_NCM;
+
+/* the class's DataIn and DataOut callbacks, which usbd_conf.c also calls directly (see USBD_FAST_DISPATCH) */
+uint8_t USBD_NCM_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_NCM_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+uint8_t USBD_NCM_RegisterInterface(USBD_HandleTypeDef *pdev);
+void USBD_NCM_PMAConfig(PCD_HandleTypeDef *hpcd, uint32_t *pma_address);
+
+struct ncm_stats
+{
+  uint32_t ntbs_in;          /* NTBs received from the host */
+  uint32_t datagrams_in;     /* datagrams found in those NTBs */
+  uint32_t errors_in;        /* NTBs (or datagrams within them) discarded as malformed */
+  uint32_t ntbs_out;         /* NTBs sent to the host */
+  uint32_t datagrams_out;    /* datagrams packed into those NTBs */
+};
+
+void usb_ncm_get_stats(struct ncm_stats *stats);
+
+#endif  // __USB_NCM_H_
@@ -41,6 +41,14 @@ struct usb_uint16
 
 #define USB_UINT16(x) { .lo = LOBYTE(x), .hi = HIBYTE(x) }
 
+struct usb_uint32
+{
+  struct usb_uint16 lo;
+  struct usb_uint16 hi;
+};
+
+#define USB_UINT32(x) { .lo = USB_UINT16((x) & 0xFFFF), .hi = USB_UINT16((x) >> 16) }
+
 struct device_descriptor
 {
   uint8_t bLength;
@@ -140,6 +148,15 @@ struct cdc_enet_functional_descriptor
   uint8_t bNumberPowerFilters;
 };
 
+struct cdc_ncm_functional_descriptor
+{
+  uint8_t bFunctionLength;
+  uint8_t bDescriptorType;
+  uint8_t bDescriptorSubtype;
+  struct usb_uint16 bcdNcmVersion;
+  uint8_t bmNetworkCapabilities;
+};
+
 struct interface_association_descriptor
 {
   uint8_t bLength;
@@ -0,0 +1,173 @@
+/*
+    USB interrupt profiling for STM32F072 microcontroller
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+Theory of operation:
+
+USB_PROF_ENTER() and USB_PROF_EXIT() bracket USB_IRQHandler() and the callbacks in usbd_conf.c that lead to the class.
+Each pair takes a timestamp on the way in and on the way out, and the ISR pushes the handler and both timestamps into a ring.
+The ring has a single producer (the USB ISR) and a single consumer (the main loop), so it needs no locking;
+if the main loop falls behind, records are dropped and counted in lost, rather than the ISR waiting.
+usb_prof_collect() (called from the main loop) does all of the arithmetic.
+
+A record is pushed on the way out, so those of the callbacks nested within a USB_IRQHandler() come just ahead of its own.
+So, usb_prof_collect() takes each USB_IRQHandler() record together with the records before it, and from the timestamps works out
+the duration of each call (min, max, total and a log2 histogram per handler), how long after the interrupt was entered each callback
+was reached (latency), and how much of the interrupt was spent outside of the callbacks (exclusive).
+A callback whose USB_IRQHandler() record was lost to a full ring still has its duration counted, but not its latency.
+
+The timestamps come from cycletime() (see time.c), which counts core clock cycles.
+*/
+
+#include <string.h>
+#include "usbprof.h"
+#include "time.h"
+
+#if USB_PROFILE
+
+#if (USB_PROF_RING_SIZE & (USB_PROF_RING_SIZE - 1)) || (USB_PROF_RING_SIZE < 2)
+#error USB_PROF_RING_SIZE must be a power of two
+#endif
+
+struct usb_prof_record
+{
+  uint8_t handler;
+  uint32_t entry, exit;            /* cycletime() samples */
+};
+
+static struct usb_prof_record ring[USB_PROF_RING_SIZE];
+static volatile unsigned ring_head;    /* written only by the ISR; free-running */
+static volatile unsigned ring_tail;    /* written only by usb_prof_collect(); free-running */
+static volatile uint32_t ring_lost;    /* written only by the ISR */
+
+static struct usb_prof_stats prof_stats[USB_PROF_HANDLERS];
+static uint32_t lost_reset;            /* ring_lost as of the last usb_prof_reset() */
+
+void usb_prof_record(enum usb_prof_handler handler, uint32_t start)
+{
+  uint32_t exit = cycletime();
+  struct usb_prof_record *entry;
+
+  if ((ring_head - ring_tail) >= USB_PROF_RING_SIZE)
+  {
+    ring_lost++;
+    return;
+  }
+
+  entry = &ring[ring_head % USB_PROF_RING_SIZE];
+  entry->handler = handler;
+  entry->entry = start;
+  entry->exit = exit;
+  ring_head++;
+}
+
+static unsigned usb_prof_bucket(uint32_t cycles)
+{
+  unsigned bucket = 0;
+
+  while ((cycles >>= 1) && (bucket < (USB_PROF_BUCKETS - 1)))
+    bucket++;
+
+  return bucket;
+}
+
+static void usb_prof_account(const struct usb_prof_record *entry, uint32_t nested)
+{
+  struct usb_prof_stats *stats = &prof_stats[entry->handler];
+  uint32_t cycles = entry->exit - entry->entry;
+
+  if (!stats->count || (cycles < stats->min))
+    stats->min = cycles;
+  if (cycles > stats->max)
+    stats->max = cycles;
+  stats->count++;
+  stats->total += cycles;
+  stats->exclusive += cycles - nested;
+  stats->histogram[usb_prof_bucket(cycles)]++;
+}
+
+void usb_prof_collect(void)
+{
+  const struct usb_prof_record *entry, *irq;
+  struct usb_prof_stats *stats;
+  unsigned head, end;
+  uint32_t nested, latency;
+
+  /* the ISR only ever adds whole interrupts' worth of records whilst this runs */
+  head = ring_head;
+
+  while (ring_tail != head)
+  {
+    /* find the USB_IRQHandler() record that closes the run of nested callback records starting at ring_tail */
+    for (end = ring_tail; end != head; end++)
+    {
+      if (ring[end % USB_PROF_RING_SIZE].handler == USB_PROF_IRQ)
+        break;
+    }
+    irq = (end != head) ? &ring[end % USB_PROF_RING_SIZE] : NULL;
+
+    nested = 0;
+    for (; ring_tail != end; ring_tail++)
+    {
+      entry = &ring[ring_tail % USB_PROF_RING_SIZE];
+      usb_prof_account(entry, 0);
+
+      /* a callback that lies within that interrupt (rather than an earlier one whose record was lost) is nested in it */
+      latency = entry->entry - (irq ? irq->entry : 0);
+      if (irq && (latency <= (irq->exit - irq->entry)))
+      {
+        stats = &prof_stats[entry->handler];
+        if (latency > stats->latency_max)
+          stats->latency_max = latency;
+        stats->latency_total += latency;
+        nested += entry->exit - entry->entry;
+      }
+    }
+
+    if (irq)
+    {
+      usb_prof_account(irq, nested);
+      ring_tail++;
+    }
+  }
+}
+
+void usb_prof_get_stats(enum usb_prof_handler handler, struct usb_prof_stats *stats, uint32_t *lost)
+{
+  usb_prof_collect();
+
+  *stats = prof_stats[handler];
+  if (lost)
+    *lost = ring_lost - lost_reset;
+}
+
+void usb_prof_reset(void)
+{
+  usb_prof_collect();
+
+  memset(prof_stats, 0, sizeof(prof_stats));
+  lost_reset = ring_lost;
+}
+
+#endif /* USB_PROFILE */
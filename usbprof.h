@@ -0,0 +1,85 @@
+/*
+    USB interrupt profiling for STM32F072 microcontroller
+
+    Copyright (C) 2026 stm32ecm contributors
+
+    Permission is hereby granted, free of charge, to any person obtaining a 
+    copy of this software and associated documentation files (the "Software"), 
+    to deal in the Software without restriction, including without limitation 
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+    and/or sell copies of the Software, and to permit persons to whom the 
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in 
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+    DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef __USB_PROF_H
+#define __USB_PROF_H
+
+#include <stdint.h>
+#include "usbd_conf.h"
+#include "time.h"
+
+/* the handlers that are timed; USB_PROF_IRQ covers the whole of USB_IRQHandler(), and the others are nested within it */
+enum usb_prof_handler
+{
+  USB_PROF_IRQ,
+  USB_PROF_SETUP,
+  USB_PROF_DATA_OUT,
+  USB_PROF_DATA_IN,
+  USB_PROF_SOF,
+  USB_PROF_HANDLERS,
+};
+
+/* number of records that the ISR can get ahead of usb_prof_collect(); must be a power of two */
+#ifndef USB_PROF_RING_SIZE
+#define USB_PROF_RING_SIZE 32
+#endif
+
+/* histogram bucket n counts calls of 2^n to 2^(n+1)-1 cycles; the last bucket takes everything longer */
+#define USB_PROF_BUCKETS 16
+
+struct usb_prof_stats
+{
+  uint32_t count;                  /* calls recorded */
+  uint32_t min, max;               /* cycles */
+  uint64_t total;                  /* cycles; total / count is the average, and total over the elapsed time is the CPU share */
+  uint64_t exclusive;              /* cycles of total not spent in the handlers nested within (so, for USB_PROF_IRQ, the HAL's own share) */
+  uint32_t latency_max;            /* cycles from entering USB_IRQHandler() to entering this handler (0 for USB_PROF_IRQ) */
+  uint64_t latency_total;          /* ...and their sum over the calls nested within a recorded USB_IRQHandler() */
+  uint32_t histogram[USB_PROF_BUCKETS];
+};
+
+#if USB_PROFILE
+
+/* called from the ISR by USB_PROF_EXIT(); start is the cycletime() sample taken by USB_PROF_ENTER() */
+void usb_prof_record(enum usb_prof_handler handler, uint32_t start);
+
+/* called from the main loop: moves the ISR's records into the per-handler statistics */
+void usb_prof_collect(void);
+
+/* collects, then copies out the statistics of one handler; lost is the number of records dropped by a full ring */
+void usb_prof_get_stats(enum usb_prof_handler handler, struct usb_prof_stats *stats, uint32_t *lost);
+
+void usb_prof_reset(void);
+
+#define USB_PROF_ENTER(handler) uint32_t usb_prof_start_##handler = cycletime()
+#define USB_PROF_EXIT(handler)  usb_prof_record(handler, usb_prof_start_##handler)
+
+#else
+
+#define USB_PROF_ENTER(handler)
+#define USB_PROF_EXIT(handler)
+
+#endif
+
+#endif /* __USB_PROF_H */